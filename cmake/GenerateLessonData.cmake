@@ -0,0 +1,131 @@
+# Typing Speed Test - Lesson Data Generator
+#
+# Compiles data/lessons.def and data/sentences.def into lessondata.h: constexpr
+# tables of std::string_view in read-only memory, so lesson and sentence data
+# needs no construction at runtime and is shared by every LessonManager.
+#
+# Usage: cmake -DLESSONS=<file> -DSENTENCES=<file> -DOUTPUT=<header> -P GenerateLessonData.cmake
+#
+# @author Tolstoy Justin
+# @license MIT License
+
+foreach(required LESSONS SENTENCES OUTPUT)
+    if(NOT DEFINED ${required})
+        message(FATAL_ERROR "GenerateLessonData.cmake: -D${required}=... is required")
+    endif()
+endforeach()
+
+# CMake lists split on ';' and treat brackets and backslashes specially, so those
+# characters travel encoded until they are written out as C++ string literals
+function(read_encoded_lines path out_var)
+    file(READ "${path}" content)
+    string(REPLACE "\r" "" content "${content}")
+    string(REPLACE "\\" "@BACKSLASH@" content "${content}")
+    string(REPLACE ";" "@SEMICOLON@" content "${content}")
+    string(REPLACE "[" "@LBRACKET@" content "${content}")
+    string(REPLACE "]" "@RBRACKET@" content "${content}")
+    string(REPLACE "\n" ";" content "${content}")
+    set(${out_var} "${content}" PARENT_SCOPE)
+endfunction()
+
+function(cpp_literal encoded out_var)
+    string(REPLACE "@BACKSLASH@" "\\\\" text "${encoded}")
+    string(REPLACE "\"" "\\\"" text "${text}")
+    string(REPLACE "@SEMICOLON@" ";" text "${text}")
+    string(REPLACE "@LBRACKET@" "[" text "${text}")
+    string(REPLACE "@RBRACKET@" "]" text "${text}")
+    set(${out_var} "\"${text}\"" PARENT_SCOPE)
+endfunction()
+
+# Parses a .def file into <prefix>_SECTIONS, <prefix>_<SECTION>_ITEMS and <prefix>_<SECTION>_<field>
+macro(parse_definitions path prefix)
+    read_encoded_lines("${path}" lines)
+    set(${prefix}_SECTIONS "")
+    set(section "")
+    set(lineNumber 0)
+    foreach(line IN LISTS lines)
+        math(EXPR lineNumber "${lineNumber} + 1")
+        if(line STREQUAL "" OR line MATCHES "^#")
+            continue()
+        elseif(line MATCHES "^@LBRACKET@([A-Z_]+)@RBRACKET@$")
+            set(section "${CMAKE_MATCH_1}")
+            list(APPEND ${prefix}_SECTIONS "${section}")
+            set(${prefix}_${section}_ITEMS "")
+        elseif(section STREQUAL "")
+            message(FATAL_ERROR "${path}:${lineNumber}: content before the first [SECTION]")
+        elseif(line MATCHES "^- (.*)$")
+            list(APPEND ${prefix}_${section}_ITEMS "${CMAKE_MATCH_1}")
+        elseif(line MATCHES "^([a-z]+): (.*)$")
+            set(${prefix}_${section}_${CMAKE_MATCH_1} "${CMAKE_MATCH_2}")
+        else()
+            message(FATAL_ERROR "${path}:${lineNumber}: expected '- item' or 'field: value'")
+        endif()
+    endforeach()
+endmacro()
+
+# Emits `inline constexpr std::string_view <name>[]` and sets <pointer_var>/<count_var> for the table row
+function(append_item_array header_var name items pointer_var count_var)
+    list(LENGTH items count)
+    set(header "${${header_var}}")
+    if(count EQUAL 0)
+        set(${pointer_var} "nullptr" PARENT_SCOPE)
+    else()
+        string(APPEND header "inline constexpr std::string_view ${name}[] = {\n")
+        foreach(item IN LISTS items)
+            cpp_literal("${item}" literal)
+            string(APPEND header "    ${literal},\n")
+        endforeach()
+        string(APPEND header "};\n\n")
+        set(${pointer_var} "${name}" PARENT_SCOPE)
+    endif()
+    set(${count_var} ${count} PARENT_SCOPE)
+    set(${header_var} "${header}" PARENT_SCOPE)
+endfunction()
+
+parse_definitions("${LESSONS}" LESSON)
+parse_definitions("${SENTENCES}" SENTENCE)
+
+get_filename_component(lessonsName "${LESSONS}" NAME)
+get_filename_component(sentencesName "${SENTENCES}" NAME)
+
+set(header "// Generated by cmake/GenerateLessonData.cmake from ${lessonsName} and ${sentencesName}; do not edit.\n\n")
+string(APPEND header "#ifndef LESSONDATA_H\n#define LESSONDATA_H\n\n#include <string_view>\n\n")
+string(APPEND header "namespace LessonData {\n\n")
+string(APPEND header "struct Lesson {\n")
+string(APPEND header "    std::string_view id; // LessonManager::LessonType enumerator name\n")
+string(APPEND header "    std::string_view title;\n")
+string(APPEND header "    std::string_view description;\n")
+string(APPEND header "    std::string_view characters;\n")
+string(APPEND header "    const std::string_view *items;\n")
+string(APPEND header "    int itemCount;\n")
+string(APPEND header "};\n\n")
+string(APPEND header "struct SentenceSet {\n")
+string(APPEND header "    std::string_view id; // TypingTest::DifficultyLevel enumerator name\n")
+string(APPEND header "    const std::string_view *sentences;\n")
+string(APPEND header "    int count;\n")
+string(APPEND header "};\n\n")
+
+set(lessonRows "")
+foreach(lesson IN LISTS LESSON_SECTIONS)
+    append_item_array(header "${lesson}_ITEMS" "${LESSON_${lesson}_ITEMS}" pointer count)
+    foreach(field title description characters)
+        cpp_literal("${LESSON_${lesson}_${field}}" ${field}Literal)
+    endforeach()
+    string(APPEND lessonRows "    {\"${lesson}\", ${titleLiteral}, ${descriptionLiteral}, ${charactersLiteral}, ${pointer}, ${count}},\n")
+endforeach()
+list(LENGTH LESSON_SECTIONS lessonCount)
+string(APPEND header "inline constexpr Lesson LESSONS[] = {\n${lessonRows}};\n")
+string(APPEND header "inline constexpr int LESSON_COUNT = ${lessonCount};\n\n")
+
+set(sentenceRows "")
+foreach(level IN LISTS SENTENCE_SECTIONS)
+    append_item_array(header "${level}_SENTENCES" "${SENTENCE_${level}_ITEMS}" pointer count)
+    string(APPEND sentenceRows "    {\"${level}\", ${pointer}, ${count}},\n")
+endforeach()
+list(LENGTH SENTENCE_SECTIONS sentenceSetCount)
+string(APPEND header "inline constexpr SentenceSet SENTENCE_SETS[] = {\n${sentenceRows}};\n")
+string(APPEND header "inline constexpr int SENTENCE_SET_COUNT = ${sentenceSetCount};\n\n")
+
+string(APPEND header "} // namespace LessonData\n\n#endif // LESSONDATA_H\n")
+
+file(WRITE "${OUTPUT}" "${header}")
@@ -0,0 +1,221 @@
+/**
+ * Typing Speed Test - Audio Engine Implementation
+ *
+ * Owns the audio thread and the output stream. The UI thread posts triggers
+ * through a wait-free queue; the audio thread drains it once per block.
+ * In offline mode there is no device or thread: the caller pulls blocks
+ * through the same queue, mixer and sequencer, faster than real time.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "audioengine.h"
+#include <QAudioFormat>
+#include <QSysInfo>
+#include <QDebug>
+#include <cmath>
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+#include <QAudioSink>
+#include <QAudioDevice>
+#include <QMediaDevices>
+#else
+#include <QAudioOutput>
+#include <QAudioDeviceInfo>
+#endif
+
+AudioStream::AudioStream(SoundTriggerQueue *queue, QObject *parent)
+    : QIODevice(parent)
+    , triggerQueue(queue)
+    , mixer(SAMPLE_RATE)
+    , mixBuffer(BLOCK_FRAMES)
+    , audioOutput(nullptr)
+{
+}
+
+bool AudioStream::startOutput()
+{
+    QAudioFormat format;
+    format.setSampleRate(SAMPLE_RATE);
+    format.setChannelCount(1);
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    format.setSampleFormat(QAudioFormat::Int16);
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+#else
+    format.setSampleSize(16);
+    format.setCodec("audio/pcm");
+    format.setByteOrder(static_cast<QAudioFormat::Endian>(QSysInfo::ByteOrder));
+    format.setSampleType(QAudioFormat::SignedInt);
+    QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+#endif
+
+    if (device.isNull() || !device.isFormatSupported(format)) {
+        qDebug() << "Audio output unavailable, sound effects disabled";
+        return false;
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    audioOutput = new QAudioSink(device, format, this);
+#else
+    audioOutput = new QAudioOutput(device, format, this);
+#endif
+    // Keep the device buffer short so keystroke feedback stays tight
+    audioOutput->setBufferSize(format.bytesForDuration(40000));
+
+    open(QIODevice::ReadOnly);
+    audioOutput->start(this);
+    return true;
+}
+
+void AudioStream::stopOutput()
+{
+    if (audioOutput) {
+        audioOutput->stop();
+    }
+    close();
+}
+
+bool AudioStream::isSequential() const
+{
+    return true;
+}
+
+qint64 AudioStream::bytesAvailable() const
+{
+    // The mixer can always produce more audio
+    return BLOCK_FRAMES * static_cast<qint64>(sizeof(qint16)) + QIODevice::bytesAvailable();
+}
+
+qint64 AudioStream::readData(char *data, qint64 maxlen)
+{
+    drainTriggers();
+
+    qint16 *output = reinterpret_cast<qint16 *>(data);
+    qint64 framesLeft = maxlen / static_cast<qint64>(sizeof(qint16));
+    const qint64 framesTotal = framesLeft;
+
+    while (framesLeft > 0) {
+        const int frames = static_cast<int>(qMin<qint64>(framesLeft, BLOCK_FRAMES));
+        mixer.render(mixBuffer.data(), frames);
+
+        for (int i = 0; i < frames; ++i) {
+            const float sample = qBound(-1.0f, mixBuffer[i], 1.0f);
+            output[i] = static_cast<qint16>(std::lround(sample * 32767.0f));
+        }
+
+        output += frames;
+        framesLeft -= frames;
+    }
+
+    return framesTotal * static_cast<qint64>(sizeof(qint16));
+}
+
+qint64 AudioStream::writeData(const char *data, qint64 len)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(len);
+    return 0;
+}
+
+void AudioStream::drainTriggers()
+{
+    SoundTrigger soundTrigger;
+    while (triggerQueue->pop(soundTrigger)) {
+        mixer.trigger(soundTrigger);
+    }
+}
+
+AudioEngine::AudioEngine(OutputMode mode, QObject *parent)
+    : QObject(parent)
+    , outputMode(mode)
+    , audioThread(nullptr)
+    , stream(nullptr)
+    , running(false)
+{
+    if (outputMode == OFFLINE_OUTPUT) {
+        offlineMixer.reset(new AudioMixer(AudioStream::SAMPLE_RATE));
+        running.store(true, std::memory_order_release);
+        return;
+    }
+
+    audioThread = new QThread(this);
+    stream = new AudioStream(&triggerQueue);
+    audioThread->setObjectName("AudioThread");
+    stream->moveToThread(audioThread);
+    connect(audioThread, &QThread::finished, stream, &QObject::deleteLater);
+    audioThread->start(QThread::TimeCriticalPriority);
+
+    // Open the device on the audio thread without holding up the UI thread
+    QMetaObject::invokeMethod(stream, [this]() {
+        const bool started = stream->startOutput();
+        running.store(started, std::memory_order_release);
+
+        // Emitted from the engine's own thread, so connections made after construction still see it
+        QMetaObject::invokeMethod(this, [this, started]() {
+            emit outputStarted(started);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+AudioEngine::~AudioEngine()
+{
+    running.store(false, std::memory_order_release);
+    if (audioThread) {
+        QMetaObject::invokeMethod(stream, "stopOutput", Qt::BlockingQueuedConnection);
+        audioThread->quit();
+        audioThread->wait();
+    }
+}
+
+bool AudioEngine::post(const SoundTrigger &soundTrigger)
+{
+    if (!running.load(std::memory_order_acquire)) {
+        return false;
+    }
+    return triggerQueue.push(soundTrigger);
+}
+
+bool AudioEngine::isRunning() const
+{
+    return running.load(std::memory_order_acquire);
+}
+
+AudioEngine::OutputMode AudioEngine::getOutputMode() const
+{
+    return outputMode;
+}
+
+int AudioEngine::getSampleRate() const
+{
+    return AudioStream::SAMPLE_RATE;
+}
+
+int AudioEngine::renderOffline(float *output, int frames)
+{
+    if (!offlineMixer) {
+        return 0;
+    }
+
+    // Same hand-off as the device stream: triggers posted since the last
+    // block take effect at the start of this one
+    SoundTrigger soundTrigger;
+    while (triggerQueue.pop(soundTrigger)) {
+        offlineMixer->trigger(soundTrigger);
+    }
+
+    offlineMixer->render(output, frames);
+    return frames;
+}
+
+quint64 AudioEngine::getOfflineFramePosition() const
+{
+    return offlineMixer ? offlineMixer->getFramePosition() : 0;
+}
+
+bool AudioEngine::isOfflineIdle() const
+{
+    return offlineMixer && triggerQueue.isEmpty()
+        && offlineMixer->getActiveVoiceCount() == 0 && offlineMixer->getActiveSequenceCount() == 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * Typing Speed Test - Audio Engine
+ *
+ * Owns the audio thread and the output stream. The UI thread posts triggers
+ * through a wait-free queue; the audio thread drains it once per block.
+ * In offline mode there is no device or thread: the caller pulls blocks
+ * through the same queue, mixer and sequencer, faster than real time.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef AUDIOENGINE_H
+#define AUDIOENGINE_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QThread>
+#include <QVector>
+#include <QScopedPointer>
+#include <atomic>
+#include "audiomixer.h"
+#include "triggerqueue.h"
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+class QAudioSink;
+#else
+class QAudioOutput;
+#endif
+
+typedef TriggerQueue<SoundTrigger, 256> SoundTriggerQueue;
+
+// Pull-mode PCM source living on the audio thread
+class AudioStream : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    static const int SAMPLE_RATE = 44100;
+    static const int BLOCK_FRAMES = 512;
+
+    explicit AudioStream(SoundTriggerQueue *queue, QObject *parent = nullptr);
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+
+public slots:
+    bool startOutput();
+    void stopOutput();
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    void drainTriggers();
+
+    SoundTriggerQueue *triggerQueue;
+    AudioMixer mixer;
+    QVector<float> mixBuffer;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    QAudioSink *audioOutput;
+#else
+    QAudioOutput *audioOutput;
+#endif
+};
+
+class AudioEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum OutputMode {
+        DEVICE_OUTPUT,  // Real-time playback on the default audio device
+        OFFLINE_OUTPUT  // Rendered on demand into caller-provided buffers
+    };
+
+    explicit AudioEngine(OutputMode mode = DEVICE_OUTPUT, QObject *parent = nullptr);
+    ~AudioEngine();
+
+    // UI thread only. Never blocks; returns false if the trigger was dropped.
+    bool post(const SoundTrigger &soundTrigger);
+    bool isRunning() const;
+    OutputMode getOutputMode() const;
+    int getSampleRate() const;
+
+    // Offline mode only: drains pending triggers, then mixes one block of mono samples
+    int renderOffline(float *output, int frames);
+    quint64 getOfflineFramePosition() const;
+    bool isOfflineIdle() const; // No trigger pending and no voice or sequence sounding
+
+signals:
+    // Device mode: emitted once the audio thread has tried to open the device
+    void outputStarted(bool success);
+
+private:
+    SoundTriggerQueue triggerQueue;
+    OutputMode outputMode;
+    QThread *audioThread;
+    AudioStream *stream;
+    QScopedPointer<AudioMixer> offlineMixer;
+    std::atomic<bool> running;
+};
+
+#endif // AUDIOENGINE_H
@@ -0,0 +1,221 @@
+/**
+ * Typing Speed Test - Audio Mixer Implementation
+ *
+ * Fixed-polyphony tone and sample mixer run on the audio thread. Bursts of identical
+ * triggers are coalesced and a voice-stealing policy caps the voice count.
+ * Pattern triggers are handed to the sequencer, which starts each note at
+ * its exact sample offset.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "audiomixer.h"
+#include <cmath>
+
+namespace {
+const double TWO_PI = 6.283185307179586;
+}
+
+AudioMixer::AudioMixer(int sampleRate)
+    : sequencer(sampleRate)
+    , sampleRate(0)
+    , attackFrames(1)
+    , releaseFrames(1)
+    , framePosition(0)
+{
+    for (Voice &voice : voices) {
+        voice.active = false;
+        voice.key = -1;
+        voice.phase = 0.0;
+        voice.phaseStep = 0.0;
+        voice.samples = nullptr;
+        voice.gain = 0.0f;
+        voice.position = 0;
+        voice.length = 0;
+        voice.startFrame = 0;
+    }
+
+    setSampleRate(sampleRate);
+}
+
+void AudioMixer::setSampleRate(int rate)
+{
+    sampleRate = qMax(8000, rate);
+    sequencer.setSampleRate(sampleRate);
+    attackFrames = qMax<qint64>(1, static_cast<qint64>(sampleRate) * ATTACK_MS / 1000);
+    releaseFrames = qMax<qint64>(1, static_cast<qint64>(sampleRate) * RELEASE_MS / 1000);
+}
+
+int AudioMixer::getSampleRate() const
+{
+    return sampleRate;
+}
+
+void AudioMixer::trigger(const SoundTrigger &soundTrigger)
+{
+    if (soundTrigger.pattern) {
+        sequencer.schedule(soundTrigger.pattern, soundTrigger.key, soundTrigger.gain, framePosition);
+        return;
+    }
+
+    const bool hasLength = soundTrigger.samples ? soundTrigger.sampleCount > 0 : soundTrigger.durationMs > 0;
+    if (!hasLength || soundTrigger.gain <= 0.0f) {
+        return;
+    }
+
+    // Coalesce bursts: a repeat of a sound that just started restarts that
+    // voice instead of stacking another copy on top of it
+    Voice *voice = findVoice(soundTrigger.key);
+    if (!voice) {
+        for (Voice &candidate : voices) {
+            if (!candidate.active) {
+                voice = &candidate;
+                break;
+            }
+        }
+    }
+    if (!voice) {
+        voice = stealVoice();
+    }
+
+    startVoice(*voice, soundTrigger);
+}
+
+AudioMixer::Voice *AudioMixer::findVoice(int key)
+{
+    if (key < 0) {
+        return nullptr;
+    }
+
+    const quint64 window = static_cast<quint64>(sampleRate) * COALESCE_WINDOW_MS / 1000;
+    for (Voice &voice : voices) {
+        if (voice.active && voice.key == key && framePosition - voice.startFrame < window) {
+            return &voice;
+        }
+    }
+    return nullptr;
+}
+
+AudioMixer::Voice *AudioMixer::stealVoice()
+{
+    // Steal the voice closest to finishing; it is the least audible to cut short
+    Voice *victim = &voices[0];
+    for (Voice &voice : voices) {
+        if (voice.length - voice.position < victim->length - victim->position) {
+            victim = &voice;
+        }
+    }
+    return victim;
+}
+
+void AudioMixer::startVoice(Voice &voice, const SoundTrigger &soundTrigger)
+{
+    voice.active = true;
+    voice.key = soundTrigger.key;
+    voice.phase = 0.0;
+    voice.phaseStep = TWO_PI * soundTrigger.frequency / sampleRate;
+    voice.samples = soundTrigger.samples;
+    voice.gain = qBound(0.0f, soundTrigger.gain, 1.0f);
+    voice.position = 0;
+    voice.length = voice.samples
+        ? soundTrigger.sampleCount
+        : qMax<qint64>(1, static_cast<qint64>(sampleRate) * soundTrigger.durationMs / 1000);
+    voice.startFrame = framePosition;
+}
+
+void AudioMixer::render(float *output, int frames)
+{
+    // Split the block at every note onset so sequenced notes start on their exact frame
+    int offset = 0;
+    while (offset < frames) {
+        sequencer.fireDueEvents(framePosition, *this);
+        const int segment = sequencer.framesUntilNextEvent(framePosition, frames - offset);
+        renderVoices(output + offset, segment);
+        framePosition += segment;
+        offset += segment;
+    }
+
+    // Soft knee above half scale so overlapping voices approach but never exceed full scale
+    for (int i = 0; i < frames; ++i) {
+        const float magnitude = std::fabs(output[i]);
+        if (magnitude > 0.5f) {
+            const float over = magnitude - 0.5f;
+            const float limited = 0.5f + 0.5f * over / (over + 0.5f);
+            output[i] = output[i] < 0.0f ? -limited : limited;
+        }
+    }
+}
+
+void AudioMixer::renderVoices(float *output, int frames)
+{
+    for (int i = 0; i < frames; ++i) {
+        output[i] = 0.0f;
+    }
+
+    for (Voice &voice : voices) {
+        if (!voice.active) {
+            continue;
+        }
+
+        const int count = static_cast<int>(qMin<qint64>(frames, voice.length - voice.position));
+        if (voice.samples) {
+            // Decoded samples carry their own envelope
+            const float *source = voice.samples + voice.position;
+            for (int i = 0; i < count; ++i) {
+                output[i] += voice.gain * source[i];
+            }
+            voice.position += count;
+            if (voice.position >= voice.length) {
+                voice.active = false;
+            }
+            continue;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const qint64 position = voice.position + i;
+            const qint64 remaining = voice.length - position;
+
+            // Linear attack and release keep note edges free of clicks
+            float envelope = 1.0f;
+            if (position < attackFrames) {
+                envelope = static_cast<float>(position) / attackFrames;
+            }
+            if (remaining < releaseFrames) {
+                envelope = qMin(envelope, static_cast<float>(remaining) / releaseFrames);
+            }
+
+            output[i] += voice.gain * envelope * static_cast<float>(std::sin(voice.phase));
+            voice.phase += voice.phaseStep;
+            if (voice.phase >= TWO_PI) {
+                voice.phase -= TWO_PI;
+            }
+        }
+
+        voice.position += count;
+        if (voice.position >= voice.length) {
+            voice.active = false;
+        }
+    }
+}
+
+int AudioMixer::getActiveVoiceCount() const
+{
+    int count = 0;
+    for (const Voice &voice : voices) {
+        if (voice.active) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+int AudioMixer::getActiveSequenceCount() const
+{
+    return sequencer.getActiveCount();
+}
+
+quint64 AudioMixer::getFramePosition() const
+{
+    return framePosition;
+}
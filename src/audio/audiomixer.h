@@ -0,0 +1,66 @@
+/**
+ * Typing Speed Test - Audio Mixer
+ *
+ * Fixed-polyphony tone and sample mixer run on the audio thread. Bursts of identical
+ * triggers are coalesced and a voice-stealing policy caps the voice count.
+ * Pattern triggers are handed to the sequencer, which starts each note at
+ * its exact sample offset.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <QtGlobal>
+#include "triggerqueue.h"
+#include "sequencer.h"
+
+class AudioMixer
+{
+public:
+    static const int MAX_VOICES = 8;
+    static const int COALESCE_WINDOW_MS = 15; // Same-key triggers closer than this merge
+    static const int ATTACK_MS = 2;
+    static const int RELEASE_MS = 15;
+
+    explicit AudioMixer(int sampleRate = 44100);
+
+    void setSampleRate(int rate);
+    int getSampleRate() const;
+
+    // Audio thread only
+    void trigger(const SoundTrigger &soundTrigger);
+    void render(float *output, int frames); // Mono, overwrites output
+    int getActiveVoiceCount() const;
+    int getActiveSequenceCount() const;
+    quint64 getFramePosition() const;
+
+private:
+    struct Voice {
+        bool active;
+        int key;
+        double phase;
+        double phaseStep;
+        const float *samples;
+        float gain;
+        qint64 position;
+        qint64 length;
+        quint64 startFrame;
+    };
+
+    Voice *findVoice(int key);
+    Voice *stealVoice();
+    void startVoice(Voice &voice, const SoundTrigger &soundTrigger);
+    void renderVoices(float *output, int frames);
+
+    Voice voices[MAX_VOICES];
+    Sequencer sequencer;
+    int sampleRate;
+    qint64 attackFrames;
+    qint64 releaseFrames;
+    quint64 framePosition;
+};
+
+#endif // AUDIOMIXER_H
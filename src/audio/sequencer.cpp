@@ -0,0 +1,119 @@
+/**
+ * Typing Speed Test - Sound Sequencer Implementation
+ *
+ * Schedules multi-note patterns by sample offset inside the audio stream so
+ * melodies keep exact timing regardless of UI thread load.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "sequencer.h"
+#include "audiomixer.h"
+#include "soundpattern.h"
+
+Sequencer::Sequencer(int sampleRate)
+    : sampleRate(sampleRate)
+{
+    for (Playback &playback : playbacks) {
+        playback.pattern = nullptr;
+        playback.key = -1;
+        playback.gain = 0.0f;
+        playback.startFrame = 0;
+        playback.nextNote = 0;
+    }
+}
+
+void Sequencer::setSampleRate(int rate)
+{
+    sampleRate = rate;
+}
+
+void Sequencer::schedule(const SoundPattern *pattern, int key, float gain, quint64 startFrame)
+{
+    if (!pattern || pattern->noteCount == 0) {
+        return;
+    }
+
+    // Restart a pattern that is already playing under the same key, otherwise
+    // take a free slot, otherwise replace the playback that started earliest
+    Playback *slot = nullptr;
+    for (Playback &playback : playbacks) {
+        if (playback.pattern && key >= 0 && playback.key == key) {
+            slot = &playback;
+            break;
+        }
+    }
+    if (!slot) {
+        for (Playback &playback : playbacks) {
+            if (!playback.pattern) {
+                slot = &playback;
+                break;
+            }
+        }
+    }
+    if (!slot) {
+        slot = &playbacks[0];
+        for (Playback &playback : playbacks) {
+            if (playback.startFrame < slot->startFrame) {
+                slot = &playback;
+            }
+        }
+    }
+
+    slot->pattern = pattern;
+    slot->key = key;
+    slot->gain = gain;
+    slot->startFrame = startFrame;
+    slot->nextNote = 0;
+}
+
+quint64 Sequencer::onsetFrame(const Playback &playback, int note) const
+{
+    const qint64 onsetMs = playback.pattern->notes[note].onsetMs;
+    return playback.startFrame + static_cast<quint64>(onsetMs * sampleRate / 1000);
+}
+
+int Sequencer::framesUntilNextEvent(quint64 now, int maxFrames) const
+{
+    quint64 frames = static_cast<quint64>(maxFrames);
+    for (const Playback &playback : playbacks) {
+        if (playback.pattern) {
+            const quint64 onset = onsetFrame(playback, playback.nextNote);
+            if (onset > now) {
+                frames = qMin(frames, onset - now);
+            }
+        }
+    }
+    return static_cast<int>(frames);
+}
+
+void Sequencer::fireDueEvents(quint64 now, AudioMixer &mixer)
+{
+    for (Playback &playback : playbacks) {
+        while (playback.pattern && onsetFrame(playback, playback.nextNote) <= now) {
+            const SoundPattern::Note &note = playback.pattern->notes[playback.nextNote];
+
+            SoundTrigger noteTrigger;
+            noteTrigger.frequency = note.frequency;
+            noteTrigger.gain = playback.gain;
+            noteTrigger.durationMs = note.durationMs;
+            mixer.trigger(noteTrigger);
+
+            if (++playback.nextNote == playback.pattern->noteCount) {
+                playback.pattern = nullptr;
+            }
+        }
+    }
+}
+
+int Sequencer::getActiveCount() const
+{
+    int count = 0;
+    for (const Playback &playback : playbacks) {
+        if (playback.pattern) {
+            ++count;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,49 @@
+/**
+ * Typing Speed Test - Sound Sequencer
+ *
+ * Schedules multi-note patterns by sample offset inside the audio stream so
+ * melodies keep exact timing regardless of UI thread load.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <QtGlobal>
+
+struct SoundPattern;
+class AudioMixer;
+
+class Sequencer
+{
+public:
+    static const int MAX_SEQUENCES = 4;
+
+    explicit Sequencer(int sampleRate = 44100);
+
+    void setSampleRate(int rate);
+
+    // Audio thread only
+    void schedule(const SoundPattern *pattern, int key, float gain, quint64 startFrame);
+    int framesUntilNextEvent(quint64 now, int maxFrames) const;
+    void fireDueEvents(quint64 now, AudioMixer &mixer);
+    int getActiveCount() const;
+
+private:
+    struct Playback {
+        const SoundPattern *pattern;
+        int key;
+        float gain;
+        quint64 startFrame;
+        int nextNote;
+    };
+
+    quint64 onsetFrame(const Playback &playback, int note) const;
+
+    Playback playbacks[MAX_SEQUENCES];
+    int sampleRate;
+};
+
+#endif // SEQUENCER_H
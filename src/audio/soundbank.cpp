@@ -0,0 +1,310 @@
+/**
+ * Typing Speed Test - Sound Bank Implementation
+ *
+ * Memory-maps WAV/raw assets from the sounds directory, decodes and resamples
+ * them once to the mixer format on a background thread, and serves them as
+ * shared immutable buffers grouped into switchable sound packs.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "soundbank.h"
+#include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const int RAW_SAMPLE_RATE = 44100; // .raw files are 16-bit signed little-endian mono
+
+const quint16 WAVE_FORMAT_PCM = 0x0001;
+const quint16 WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+const quint16 WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+float readSample(const uchar *data, quint16 format, int bits)
+{
+    if (format == WAVE_FORMAT_IEEE_FLOAT && bits == 32) {
+        const quint32 word = qFromLittleEndian<quint32>(data);
+        float value;
+        std::memcpy(&value, &word, sizeof(value));
+        return value;
+    }
+
+    switch (bits) {
+        case 8:
+            return (static_cast<int>(data[0]) - 128) / 128.0f;
+        case 16:
+            return qFromLittleEndian<qint16>(data) / 32768.0f;
+        case 24: {
+            qint32 value = data[0] | (data[1] << 8) | (data[2] << 16);
+            if (value & 0x800000) {
+                value |= ~0xFFFFFF;
+            }
+            return value / 8388608.0f;
+        }
+        case 32:
+            return qFromLittleEndian<qint32>(data) / 2147483648.0f;
+        default:
+            return 0.0f;
+    }
+}
+
+}
+
+const char *SoundBank::DEFAULT_PACK = "default";
+
+SoundBank::SoundBank(QObject *parent)
+    : QObject(parent)
+    , loaderThread(nullptr)
+    , loadComplete(false)
+{
+}
+
+SoundBank::~SoundBank()
+{
+    // The loader writes into pendingPacks, so it must finish before we go away
+    if (loaderThread) {
+        loaderThread->wait();
+    }
+}
+
+void SoundBank::loadDirectory(const QString &directory, int targetSampleRate)
+{
+    if (loaderThread || loadComplete) {
+        return;
+    }
+    if (directory.isEmpty()) {
+        loadComplete = true; // No sounds directory: built-in tones only
+        return;
+    }
+
+    loaderThread = QThread::create([this, directory, targetSampleRate]() {
+        const QStringList filters = {"*.wav", "*.raw"};
+        const QDir root(directory);
+
+        auto loadPack = [&](const QDir &dir, const QString &packName) {
+            SoundPack pack;
+            for (const QFileInfo &info : dir.entryInfoList(filters, QDir::Files)) {
+                SampleBufferPtr buffer = decodeFile(info.absoluteFilePath(), targetSampleRate);
+                if (buffer) {
+                    pack.insert(info.completeBaseName().toLower(), buffer);
+                }
+            }
+            if (!pack.isEmpty()) {
+                pendingPacks.insert(packName, pack);
+            }
+        };
+
+        loadPack(root, DEFAULT_PACK);
+        for (const QString &subdirectory : root.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            loadPack(QDir(root.filePath(subdirectory)), subdirectory);
+        }
+    });
+
+    loaderThread->setObjectName("SoundBankLoader");
+    connect(loaderThread, &QThread::finished, this, &SoundBank::onLoadFinished);
+    loaderThread->start(QThread::LowPriority);
+}
+
+void SoundBank::onLoadFinished()
+{
+    packs = pendingPacks;
+    pendingPacks.clear();
+    loaderThread->deleteLater();
+    loaderThread = nullptr;
+    loadComplete = true;
+
+    qDebug() << "Sound bank loaded packs:" << packs.keys();
+    emit loaded();
+}
+
+bool SoundBank::isLoaded() const
+{
+    return loadComplete;
+}
+
+QStringList SoundBank::getPackNames() const
+{
+    QStringList names = packs.keys();
+    names.sort();
+    return names;
+}
+
+SoundPack SoundBank::getPack(const QString &name) const
+{
+    return packs.value(name);
+}
+
+SampleBufferPtr SoundBank::decodeFile(const QString &path, int targetSampleRate)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        return SampleBufferPtr();
+    }
+
+    // Map rather than read: the decoder touches every byte exactly once
+    qint64 size = file.size();
+    uchar *data = file.map(0, size);
+    const bool mapped = data != nullptr;
+    QByteArray fallback;
+    if (!mapped) {
+        // The read may come back shorter than the size the file reported
+        fallback = file.readAll();
+        if (fallback.isEmpty()) {
+            qDebug() << "Failed to read sound file:" << path;
+            return SampleBufferPtr();
+        }
+        data = reinterpret_cast<uchar *>(fallback.data());
+        size = fallback.size();
+    }
+
+    SampleBufferPtr buffer = path.endsWith(".raw", Qt::CaseInsensitive)
+        ? decodeRaw(data, size, targetSampleRate)
+        : decodeWav(data, size, targetSampleRate);
+
+    if (mapped) {
+        file.unmap(data);
+    }
+
+    if (!buffer) {
+        qDebug() << "Unsupported sound file:" << path;
+    }
+    return buffer;
+}
+
+SampleBufferPtr SoundBank::decodeWav(const uchar *data, qint64 size, int targetSampleRate)
+{
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        return SampleBufferPtr();
+    }
+
+    quint16 format = 0;
+    int channels = 0;
+    int sampleRate = 0;
+    int bits = 0;
+    const uchar *pcm = nullptr;
+    qint64 pcmSize = 0;
+
+    qint64 offset = 12;
+    while (offset + 8 <= size) {
+        const uchar *chunk = data + offset;
+        const quint32 chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+        const qint64 bodySize = qMin<qint64>(chunkSize, size - offset - 8);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && bodySize >= 16) {
+            format = qFromLittleEndian<quint16>(chunk + 8);
+            channels = qFromLittleEndian<quint16>(chunk + 10);
+            sampleRate = static_cast<int>(qFromLittleEndian<quint32>(chunk + 12));
+            bits = qFromLittleEndian<quint16>(chunk + 22);
+            if (format == WAVE_FORMAT_EXTENSIBLE && bodySize >= 26) {
+                format = qFromLittleEndian<quint16>(chunk + 32); // First bytes of the SubFormat GUID
+            }
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            pcm = chunk + 8;
+            pcmSize = bodySize;
+        }
+
+        offset += 8 + chunkSize + (chunkSize & 1); // Chunks are word aligned
+    }
+
+    const bool supported = (format == WAVE_FORMAT_PCM && (bits == 8 || bits == 16 || bits == 24 || bits == 32))
+                        || (format == WAVE_FORMAT_IEEE_FLOAT && bits == 32);
+    if (!pcm || !supported || channels <= 0 || sampleRate <= 0) {
+        return SampleBufferPtr();
+    }
+
+    // Downmix to mono while decoding
+    const int bytesPerSample = bits / 8;
+    const int frameBytes = bytesPerSample * channels;
+    const int frames = static_cast<int>(pcmSize / frameBytes);
+    QVector<float> mono(frames);
+    for (int frame = 0; frame < frames; ++frame) {
+        const uchar *frameData = pcm + static_cast<qint64>(frame) * frameBytes;
+        float sum = 0.0f;
+        for (int channel = 0; channel < channels; ++channel) {
+            sum += readSample(frameData + channel * bytesPerSample, format, bits);
+        }
+        mono[frame] = sum / channels;
+    }
+
+    QSharedPointer<SampleBuffer> buffer(new SampleBuffer);
+    buffer->samples = resample(mono, sampleRate, targetSampleRate);
+    buffer->sampleRate = targetSampleRate;
+    return buffer;
+}
+
+SampleBufferPtr SoundBank::decodeRaw(const uchar *data, qint64 size, int targetSampleRate)
+{
+    const int frames = static_cast<int>(size / 2);
+    if (frames == 0) {
+        return SampleBufferPtr();
+    }
+
+    QVector<float> mono(frames);
+    for (int frame = 0; frame < frames; ++frame) {
+        mono[frame] = qFromLittleEndian<qint16>(data + frame * 2) / 32768.0f;
+    }
+
+    QSharedPointer<SampleBuffer> buffer(new SampleBuffer);
+    buffer->samples = resample(mono, RAW_SAMPLE_RATE, targetSampleRate);
+    buffer->sampleRate = targetSampleRate;
+    return buffer;
+}
+
+bool SoundBank::writeWav(const QString &path, const float *samples, int count, int sampleRate)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Error writing WAV file:" << file.errorString();
+        return false;
+    }
+
+    const quint32 dataSize = static_cast<quint32>(count) * 2;
+    QByteArray bytes(44 + static_cast<int>(dataSize), Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(bytes.data());
+
+    std::memcpy(out, "RIFF", 4);
+    qToLittleEndian<quint32>(36 + dataSize, out + 4);
+    std::memcpy(out + 8, "WAVEfmt ", 8);
+    qToLittleEndian<quint32>(16, out + 16);
+    qToLittleEndian<quint16>(WAVE_FORMAT_PCM, out + 20);
+    qToLittleEndian<quint16>(1, out + 22);                                    // Mono
+    qToLittleEndian<quint32>(static_cast<quint32>(sampleRate), out + 24);
+    qToLittleEndian<quint32>(static_cast<quint32>(sampleRate) * 2, out + 28); // Byte rate
+    qToLittleEndian<quint16>(2, out + 32);                                    // Block align
+    qToLittleEndian<quint16>(16, out + 34);                                   // Bits per sample
+    std::memcpy(out + 36, "data", 4);
+    qToLittleEndian<quint32>(dataSize, out + 40);
+
+    for (int i = 0; i < count; ++i) {
+        const float sample = qBound(-1.0f, samples[i], 1.0f);
+        qToLittleEndian<qint16>(static_cast<qint16>(sample * 32767.0f), out + 44 + i * 2);
+    }
+
+    return file.write(bytes) == bytes.size();
+}
+
+QVector<float> SoundBank::resample(const QVector<float> &input, int sourceRate, int targetRate)
+{
+    if (sourceRate == targetRate || input.size() < 2) {
+        return input;
+    }
+
+    // Linear interpolation is plenty for short UI effects
+    const double step = static_cast<double>(sourceRate) / targetRate;
+    const int outputSize = static_cast<int>((input.size() - 1) / step) + 1;
+    QVector<float> output(outputSize);
+    for (int i = 0; i < outputSize; ++i) {
+        const double position = i * step;
+        const int index = static_cast<int>(position);
+        const float fraction = static_cast<float>(position - index);
+        const float next = index + 1 < input.size() ? input[index + 1] : input[index];
+        output[i] = input[index] + (next - input[index]) * fraction;
+    }
+    return output;
+}
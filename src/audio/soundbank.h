@@ -0,0 +1,74 @@
+/**
+ * Typing Speed Test - Sound Bank
+ *
+ * Memory-maps WAV/raw assets from the sounds directory, decodes and resamples
+ * them once to the mixer format on a background thread, and serves them as
+ * shared immutable buffers grouped into switchable sound packs.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef SOUNDBANK_H
+#define SOUNDBANK_H
+
+#include <QObject>
+#include <QHash>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+
+class QThread;
+
+struct SampleBuffer {
+    QVector<float> samples; // Mono, at the mixer sample rate
+    int sampleRate;
+
+    SampleBuffer() : sampleRate(0) {}
+};
+
+typedef QSharedPointer<const SampleBuffer> SampleBufferPtr;
+typedef QHash<QString, SampleBufferPtr> SoundPack; // Keyed by sound name, e.g. "keystroke_correct"
+
+class SoundBank : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Pack holding files placed directly in the sounds directory
+    static const char *DEFAULT_PACK;
+
+    explicit SoundBank(QObject *parent = nullptr);
+    ~SoundBank();
+
+    // Scans <directory>/*.wav|raw and <directory>/<pack>/*.wav|raw on a background thread
+    void loadDirectory(const QString &directory, int targetSampleRate);
+    bool isLoaded() const;
+
+    QStringList getPackNames() const;
+    SoundPack getPack(const QString &name) const;
+
+    // Decoding helpers, usable from any thread
+    static SampleBufferPtr decodeFile(const QString &path, int targetSampleRate);
+    static SampleBufferPtr decodeWav(const uchar *data, qint64 size, int targetSampleRate);
+    static SampleBufferPtr decodeRaw(const uchar *data, qint64 size, int targetSampleRate);
+
+    // Writes mono float samples as a 16-bit PCM WAV file
+    static bool writeWav(const QString &path, const float *samples, int count, int sampleRate);
+
+signals:
+    void loaded();
+
+private slots:
+    void onLoadFinished();
+
+private:
+    static QVector<float> resample(const QVector<float> &input, int sourceRate, int targetRate);
+
+    QHash<QString, SoundPack> packs;
+    QHash<QString, SoundPack> pendingPacks; // Written only by the loader thread
+    QThread *loaderThread;
+    bool loadComplete;
+};
+
+#endif // SOUNDBANK_H
@@ -0,0 +1,95 @@
+/**
+ * Typing Speed Test - Sound Pattern Implementation
+ *
+ * Fixed-size multi-note pattern played by the sequencer, plus a parser for
+ * the small text format used to define them.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "soundpattern.h"
+#include <QStringList>
+#include <QDebug>
+#include <cmath>
+
+bool SoundPattern::parse(const QString &definition, SoundPattern &pattern)
+{
+    pattern = SoundPattern();
+
+    const QStringList steps = definition.simplified().split(' ');
+    int onset = 0;
+
+    for (const QString &step : steps) {
+        if (step.isEmpty()) {
+            continue;
+        }
+
+        const QStringList parts = step.split(':');
+        bool durationOk = false;
+        const int duration = parts.size() == 2 ? parts[1].toInt(&durationOk) : 0;
+        if (!durationOk || duration <= 0) {
+            qDebug() << "Invalid sound pattern step:" << step;
+            return false;
+        }
+
+        if (parts[0] != "-") {
+            bool isNumber = false;
+            float frequency = parts[0].toFloat(&isNumber);
+            if (!isNumber) {
+                frequency = noteFrequency(parts[0]);
+            }
+            if (frequency <= 0.0f) {
+                qDebug() << "Invalid sound pattern pitch:" << step;
+                return false;
+            }
+            if (pattern.noteCount == MAX_NOTES) {
+                qDebug() << "Sound pattern exceeds" << MAX_NOTES << "notes:" << definition;
+                return false;
+            }
+
+            Note &note = pattern.notes[pattern.noteCount++];
+            note.frequency = frequency;
+            note.onsetMs = onset;
+            note.durationMs = duration;
+        }
+
+        onset += duration;
+    }
+
+    pattern.lengthMs = onset;
+    return pattern.noteCount > 0;
+}
+
+float SoundPattern::noteFrequency(const QString &name)
+{
+    static const int semitones[] = {9, 11, 0, 2, 4, 5, 7}; // A B C D E F G relative to C
+
+    if (name.length() < 2) {
+        return 0.0f;
+    }
+
+    const QChar letter = name[0].toUpper();
+    if (letter < 'A' || letter > 'G') {
+        return 0.0f;
+    }
+
+    int semitone = semitones[letter.unicode() - 'A'];
+    int index = 1;
+    if (name[index] == '#') {
+        ++semitone;
+        ++index;
+    } else if (name[index] == 'b') {
+        --semitone;
+        ++index;
+    }
+
+    bool ok = false;
+    const int octave = name.mid(index).toInt(&ok);
+    if (!ok) {
+        return 0.0f;
+    }
+
+    const int midiNote = (octave + 1) * 12 + semitone;
+    return static_cast<float>(440.0 * std::pow(2.0, (midiNote - 69) / 12.0));
+}
@@ -0,0 +1,39 @@
+/**
+ * Typing Speed Test - Sound Pattern
+ *
+ * Fixed-size multi-note pattern played by the sequencer, plus a parser for
+ * the small text format used to define them.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef SOUNDPATTERN_H
+#define SOUNDPATTERN_H
+
+#include <QString>
+
+// Pattern definitions are whitespace-separated steps played back to back:
+//   <pitch>:<durationMs>    pitch is Hz ("440") or a note name ("A4", "C#5", "Eb3")
+//   -:<durationMs>          rest
+// e.g. "440:100 550:100 660:150" or "C5:80 -:40 G5:200"
+struct SoundPattern {
+    static const int MAX_NOTES = 16;
+
+    struct Note {
+        float frequency;  // 0 for a rest
+        int onsetMs;      // Offset from the start of the pattern
+        int durationMs;
+    };
+
+    Note notes[MAX_NOTES];
+    int noteCount;
+    int lengthMs;
+
+    SoundPattern() : noteCount(0), lengthMs(0) {}
+
+    static bool parse(const QString &definition, SoundPattern &pattern);
+    static float noteFrequency(const QString &name); // Returns 0 if not a note name
+};
+
+#endif // SOUNDPATTERN_H
@@ -0,0 +1,83 @@
+/**
+ * Typing Speed Test - Sound Trigger Queue
+ *
+ * Wait-free single-producer/single-consumer ring buffer used to hand sound
+ * triggers from the UI thread to the audio thread.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef TRIGGERQUEUE_H
+#define TRIGGERQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+
+struct SoundPattern;
+
+struct SoundTrigger {
+    int key;            // Coalescing key (SoundManager::SoundType, or -1 for none)
+    float frequency;    // Tone frequency in Hz
+    float gain;         // 0.0 to 1.0, volume already applied
+    int durationMs;     // Tone length in milliseconds
+    const SoundPattern *pattern; // When set, the sequencer plays this instead of a single tone
+    const float *samples;        // When set, plays this decoded sample instead of a tone
+    int sampleCount;
+
+    SoundTrigger() : key(-1), frequency(0.0f), gain(0.0f), durationMs(0), pattern(nullptr),
+                     samples(nullptr), sampleCount(0) {}
+};
+
+// Exactly one thread may call push() and exactly one other thread may call pop().
+// Neither side ever blocks or allocates: a full queue simply rejects the push.
+template <typename T, int Capacity>
+class TriggerQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "TriggerQueue capacity must be a power of two");
+
+public:
+    TriggerQueue() : head(0), tail(0) {}
+
+    // Producer side
+    bool push(const T &item)
+    {
+        const quint32 currentHead = head.load(std::memory_order_relaxed);
+        const quint32 currentTail = tail.load(std::memory_order_acquire);
+        if (currentHead - currentTail == static_cast<quint32>(Capacity)) {
+            return false;
+        }
+
+        items[currentHead & (Capacity - 1)] = item;
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T &item)
+    {
+        const quint32 currentTail = tail.load(std::memory_order_relaxed);
+        const quint32 currentHead = head.load(std::memory_order_acquire);
+        if (currentTail == currentHead) {
+            return false;
+        }
+
+        item = items[currentTail & (Capacity - 1)];
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    // Keep the indices on separate cache lines so producer and consumer don't false-share
+    alignas(64) std::atomic<quint32> head;
+    alignas(64) std::atomic<quint32> tail;
+    alignas(64) T items[Capacity];
+};
+
+#endif // TRIGGERQUEUE_H
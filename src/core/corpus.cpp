@@ -0,0 +1,213 @@
+/**
+ * Typing Speed Test - Corpus Implementation
+ *
+ * Read-only view of a prebuilt binary sentence corpus. The file is memory
+ * mapped, so opening it costs nothing regardless of size, and any sentence
+ * of any difficulty is fetched zero-copy in O(1) through its offset table.
+ * Sentences also carry a 0..1 difficulty score, and a score-sorted index
+ * answers "random sentence scored between a and b" in O(log n).
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "corpus.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QtEndian>
+#include <QDebug>
+
+Corpus::Corpus()
+    : text(nullptr)
+    , textSize(0)
+    , scoreIndex(nullptr)
+    , scoreIndexCount(0)
+{
+    for (int difficulty = 0; difficulty < DIFFICULTY_COUNT; ++difficulty) {
+        offsets[difficulty] = nullptr;
+        counts[difficulty] = 0;
+        scores[difficulty] = nullptr;
+    }
+}
+
+Corpus::~Corpus()
+{
+    close();
+}
+
+bool Corpus::open(const QString &path)
+{
+    close();
+    if (!reader.open(path, MAGIC, VERSION, "corpus")) {
+        return false;
+    }
+
+    text = reader.findSection(TEXT_SECTION, textSize);
+    for (int difficulty = 0; difficulty < DIFFICULTY_COUNT; ++difficulty) {
+        quint64 tableSize = 0;
+        const uchar *table = reader.findSection(OFFSETS_SECTION + difficulty, tableSize);
+        if (!table || tableSize < sizeof(quint64)) {
+            continue;
+        }
+
+        // A table running past the text section means a truncated or corrupt file
+        const quint32 count = static_cast<quint32>(tableSize / sizeof(quint64) - 1);
+        if (!text || qFromLittleEndian<quint64>(table + count * sizeof(quint64)) > textSize) {
+            qDebug() << "Corrupt offset table in corpus" << path;
+            close();
+            return false;
+        }
+        offsets[difficulty] = table;
+        counts[difficulty] = count;
+    }
+
+    // Score sections are optional; a short table only disables score queries
+    bool scored = true;
+    for (int difficulty = 0; difficulty < DIFFICULTY_COUNT; ++difficulty) {
+        quint64 tableSize = 0;
+        scores[difficulty] = reader.findSection(SCORES_SECTION + difficulty, tableSize);
+        scored = scored && (counts[difficulty] == 0
+                            || (scores[difficulty] && tableSize >= counts[difficulty] * sizeof(quint16)));
+    }
+    quint64 indexSize = 0;
+    scoreIndex = scored ? reader.findSection(SCORE_INDEX_SECTION, indexSize) : nullptr;
+    scoreIndexCount = scoreIndex ? indexSize / sizeof(quint64) : 0;
+    if (!scored) {
+        for (int difficulty = 0; difficulty < DIFFICULTY_COUNT; ++difficulty) {
+            scores[difficulty] = nullptr;
+        }
+    }
+
+    return true;
+}
+
+void Corpus::close()
+{
+    reader.close();
+    text = nullptr;
+    textSize = 0;
+    scoreIndex = nullptr;
+    scoreIndexCount = 0;
+    for (int difficulty = 0; difficulty < DIFFICULTY_COUNT; ++difficulty) {
+        offsets[difficulty] = nullptr;
+        counts[difficulty] = 0;
+        scores[difficulty] = nullptr;
+    }
+}
+
+bool Corpus::isOpen() const
+{
+    return reader.isOpen();
+}
+
+quint32 Corpus::getSentenceCount(int difficulty) const
+{
+    if (difficulty < 0 || difficulty >= DIFFICULTY_COUNT) {
+        return 0;
+    }
+    return counts[difficulty];
+}
+
+QByteArray Corpus::getSentenceUtf8(int difficulty, quint32 index) const
+{
+    if (index >= getSentenceCount(difficulty)) {
+        return QByteArray();
+    }
+
+    const uchar *entry = offsets[difficulty] + index * sizeof(quint64);
+    const quint64 begin = qFromLittleEndian<quint64>(entry);
+    const quint64 end = qFromLittleEndian<quint64>(entry + sizeof(quint64));
+    if (begin > end || end > textSize) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(text + begin), static_cast<int>(end - begin));
+}
+
+QString Corpus::getSentence(int difficulty, quint32 index) const
+{
+    const QByteArray utf8 = getSentenceUtf8(difficulty, index);
+    return QString::fromUtf8(utf8.constData(), utf8.size());
+}
+
+QString Corpus::getRandomSentence(int difficulty, SessionRandom &random) const
+{
+    const quint32 count = getSentenceCount(difficulty);
+    if (count == 0) {
+        return QString();
+    }
+    return getSentence(difficulty, random.bounded(count));
+}
+
+bool Corpus::hasScores() const
+{
+    return scoreIndexCount > 0;
+}
+
+float Corpus::getSentenceScore(int difficulty, quint32 index) const
+{
+    if (index >= getSentenceCount(difficulty) || !scores[difficulty]) {
+        return -1.0f;
+    }
+    return qFromLittleEndian<quint16>(scores[difficulty] + index * sizeof(quint16)) / 65535.0f;
+}
+
+QString Corpus::getRandomSentenceInRange(float minScore, float maxScore, SessionRandom &random) const
+{
+    if (!hasScores() || minScore > maxScore) {
+        return QString();
+    }
+
+    // Entries sort by score first, so a score range is one contiguous slice of the index
+    const quint64 first = lowerBound(static_cast<quint64>(quantizeScore(minScore)) << 48);
+    const quint16 maxKey = quantizeScore(maxScore);
+    const quint64 last = maxKey == 0xFFFF ? scoreIndexCount : lowerBound((static_cast<quint64>(maxKey) + 1) << 48);
+    if (first >= last) {
+        return QString();
+    }
+
+    const quint64 pick = first + random.generate64() % (last - first);
+    const quint64 entry = qFromLittleEndian<quint64>(scoreIndex + pick * sizeof(quint64));
+    return getSentence(static_cast<int>((entry >> 32) & 0xFFFF), static_cast<quint32>(entry));
+}
+
+quint16 Corpus::quantizeScore(float score)
+{
+    return static_cast<quint16>(qRound(qBound(0.0f, score, 1.0f) * 65535.0f));
+}
+
+const uchar *Corpus::getSectionData(quint32 id, quint64 &size) const
+{
+    return reader.findSection(id, size);
+}
+
+quint64 Corpus::lowerBound(quint64 key) const
+{
+    quint64 low = 0;
+    quint64 high = scoreIndexCount;
+    while (low < high) {
+        const quint64 middle = low + (high - low) / 2;
+        if (qFromLittleEndian<quint64>(scoreIndex + middle * sizeof(quint64)) < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+QString Corpus::getDefaultPath(const QString &language)
+{
+    QDir corpusDir(QCoreApplication::applicationDirPath());
+    if (!corpusDir.cd("corpus")) {
+        return QString();
+    }
+    const QString languagePath = language + "/passages.corpus";
+    if (corpusDir.exists(languagePath)) {
+        return corpusDir.filePath(languagePath);
+    }
+    // Where the English corpus was installed before there were others
+    if (language == "en" && corpusDir.exists("passages.corpus")) {
+        return corpusDir.filePath("passages.corpus");
+    }
+    return QString();
+}
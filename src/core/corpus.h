@@ -0,0 +1,88 @@
+/**
+ * Typing Speed Test - Corpus
+ *
+ * Read-only view of a prebuilt binary sentence corpus. The file is memory
+ * mapped, so opening it costs nothing regardless of size, and any sentence
+ * of any difficulty is fetched zero-copy in O(1) through its offset table.
+ * Sentences also carry a 0..1 difficulty score, and a score-sorted index
+ * answers "random sentence scored between a and b" in O(log n).
+ *
+ * A section file (see sectionfile.h) with magic "TSCP" and sections:
+ *   TEXT: UTF-8 sentences back to back
+ *   OFFSETS_<difficulty>: u64[count + 1] into TEXT, one table per difficulty
+ *   SCORES_<difficulty>: u16[count], score * 65535 (optional)
+ *   SCORE_INDEX: u64 score << 48 | difficulty << 32 | index, sorted ascending (optional)
+ *   NGRAM_DIRECTORY, NGRAM_POSTINGS: letter n-gram index, see ngramindex.h (optional)
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <QByteArray>
+#include <QString>
+#include "sectionfile.h"
+#include "sessionrandom.h"
+
+class Corpus
+{
+public:
+    static const quint32 MAGIC = 0x50435354; // "TSCP"
+    static const quint16 VERSION = 1;
+    static const int DIFFICULTY_COUNT = 3;   // Indexed by TypingTest::DifficultyLevel
+
+    enum SectionId {
+        TEXT_SECTION = 1,
+        OFFSETS_SECTION = 2, // + difficulty
+        SCORES_SECTION = 5,  // + difficulty
+        SCORE_INDEX_SECTION = 8,
+        NGRAM_DIRECTORY_SECTION = 9,
+        NGRAM_POSTINGS_SECTION = 10
+    };
+
+    Corpus();
+    ~Corpus();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+
+    quint32 getSentenceCount(int difficulty) const;
+    // Points into the mapping; valid until close()
+    QByteArray getSentenceUtf8(int difficulty, quint32 index) const;
+    QString getSentence(int difficulty, quint32 index) const;
+    QString getRandomSentence(int difficulty, SessionRandom &random) const;
+
+    // Scores are absent in corpora built before they were added
+    bool hasScores() const;
+    float getSentenceScore(int difficulty, quint32 index) const; // -1 if unscored
+    // Binary search over the score index; empty if nothing scores within [minScore, maxScore]
+    QString getRandomSentenceInRange(float minScore, float maxScore, SessionRandom &random) const;
+
+    static quint16 quantizeScore(float score);
+
+    // Raw section for indexes layered on the corpus; null if absent or not open
+    const uchar *getSectionData(quint32 id, quint64 &size) const;
+
+    // <app dir>/corpus/<language>/passages.corpus for a KeyboardLayout language code, or empty if
+    // not installed; an English corpus may also sit in corpus/ itself
+    static QString getDefaultPath(const QString &language);
+
+private:
+    Q_DISABLE_COPY(Corpus)
+
+    quint64 lowerBound(quint64 key) const; // First score index entry >= key
+
+    SectionFileReader reader;
+    const uchar *text;
+    quint64 textSize;
+    const uchar *offsets[DIFFICULTY_COUNT];
+    quint32 counts[DIFFICULTY_COUNT];
+    const uchar *scores[DIFFICULTY_COUNT];
+    const uchar *scoreIndex;
+    quint64 scoreIndexCount;
+};
+
+#endif // CORPUS_H
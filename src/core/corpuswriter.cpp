@@ -0,0 +1,239 @@
+/**
+ * Typing Speed Test - Corpus Writer Implementation
+ *
+ * Streams sentences into the binary corpus format read by Corpus. Sentence
+ * text is spooled to one temporary file per difficulty as it arrives, so
+ * memory use is only the offset and score tables plus the capped n-gram
+ * postings, and finish() assembles the file and sorts the score index.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "corpuswriter.h"
+#include "sectionfile.h"
+#include "sentencescorer.h"
+#include <QSaveFile>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+
+static_assert(Corpus::DIFFICULTY_COUNT == SentenceScorer::DIFFICULTY_COUNT, "One table per scorer difficulty");
+
+namespace {
+
+const int COPY_CHUNK_SIZE = 1 << 20;
+
+// Writes a table of integers little-endian, COPY_CHUNK_SIZE bytes at a time
+template<typename T, typename Transform>
+bool writeTable(QIODevice &device, const QVector<T> &table, Transform transform)
+{
+    const int perChunk = COPY_CHUNK_SIZE / static_cast<int>(sizeof(T));
+    QByteArray chunk;
+    for (int first = 0; first < table.size(); first += perChunk) {
+        const int count = qMin(perChunk, table.size() - first);
+        chunk.resize(count * static_cast<int>(sizeof(T)));
+        uchar *entry = reinterpret_cast<uchar *>(chunk.data());
+        for (int i = first; i < first + count; ++i) {
+            qToLittleEndian<T>(transform(table[i]), entry);
+            entry += sizeof(T);
+        }
+        if (device.write(chunk) != chunk.size()) {
+            return false;
+        }
+    }
+    return SectionFileWriter::writePadding(device, device.pos());
+}
+
+}
+
+CorpusWriter::CorpusWriter(const QString &path)
+    : outputPath(path)
+    , failed(false)
+{
+    for (int difficulty = 0; difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        spools[difficulty].reset(new QTemporaryFile());
+        if (!spools[difficulty]->open()) {
+            qDebug() << "Cannot create corpus spool file";
+            failed = true;
+        }
+        offsets[difficulty].append(0);
+    }
+}
+
+CorpusWriter::~CorpusWriter()
+{
+}
+
+bool CorpusWriter::addSentence(int difficulty, const QByteArray &utf8)
+{
+    return addSentence(difficulty, utf8, SentenceScorer::score(utf8));
+}
+
+bool CorpusWriter::addSentence(int difficulty, const QByteArray &utf8, float score)
+{
+    if (failed || difficulty < 0 || difficulty >= Corpus::DIFFICULTY_COUNT) {
+        return false;
+    }
+
+    if (spools[difficulty]->write(utf8) != utf8.size()) {
+        qDebug() << "Failed to spool corpus sentence";
+        failed = true;
+        return false;
+    }
+    indexNgrams(difficulty, static_cast<quint32>(scores[difficulty].size()), utf8);
+    offsets[difficulty].append(offsets[difficulty].last() + utf8.size());
+    scores[difficulty].append(Corpus::quantizeScore(score));
+    return true;
+}
+
+void CorpusWriter::indexNgrams(int difficulty, quint32 index, const QByteArray &utf8)
+{
+    QVarLengthArray<int, 256> keys;
+    int letters = 0;
+    NgramIndex::collectKeys(utf8, keys, letters);
+    std::sort(keys.begin(), keys.end());
+
+    auto lessDense = [](const NgramPosting &a, const NgramPosting &b) { return a.density > b.density; };
+    for (int run = 0; run < keys.size(); ) {
+        int end = run + 1;
+        while (end < keys.size() && keys[end] == keys[run]) {
+            ++end;
+        }
+
+        const quint16 occurrences = static_cast<quint16>(qMin(end - run, 0xFFFF));
+        const quint16 letterCount = static_cast<quint16>(qMin(letters, 0xFFFF));
+        const NgramPosting posting = {
+            static_cast<quint32>(occurrences) * 65536u / letterCount, index, occurrences, letterCount,
+            static_cast<quint8>(difficulty)
+        };
+
+        // Keep only the densest sentences per n-gram; the heap top is the least dense kept
+        QVector<NgramPosting> &heap = ngramPostings[keys[run]];
+        if (heap.size() < NgramIndex::POSTINGS_PER_GRAM) {
+            heap.append(posting);
+            std::push_heap(heap.begin(), heap.end(), lessDense);
+        } else if (posting.density > heap.first().density) {
+            std::pop_heap(heap.begin(), heap.end(), lessDense);
+            heap.last() = posting;
+            std::push_heap(heap.begin(), heap.end(), lessDense);
+        }
+        run = end;
+    }
+}
+
+quint32 CorpusWriter::getSentenceCount(int difficulty) const
+{
+    if (difficulty < 0 || difficulty >= Corpus::DIFFICULTY_COUNT) {
+        return 0;
+    }
+    return static_cast<quint32>(offsets[difficulty].size() - 1);
+}
+
+bool CorpusWriter::finish()
+{
+    if (failed) {
+        return false;
+    }
+
+    // Lay out: text (all spools back to back), one offset and one score table per difficulty,
+    // the score index, then the n-gram index
+    SectionFileWriter layout(Corpus::MAGIC, Corpus::VERSION);
+    quint64 textSize = 0;
+    quint64 spoolBase[Corpus::DIFFICULTY_COUNT];
+    for (int difficulty = 0; difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        spoolBase[difficulty] = textSize;
+        textSize += offsets[difficulty].last();
+    }
+    layout.addSection(Corpus::TEXT_SECTION, textSize);
+
+    for (int difficulty = 0; difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        layout.addSection(Corpus::OFFSETS_SECTION + difficulty,
+                          static_cast<quint64>(offsets[difficulty].size()) * sizeof(quint64));
+    }
+
+    quint64 totalCount = 0;
+    for (int difficulty = 0; difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        layout.addSection(Corpus::SCORES_SECTION + difficulty,
+                          static_cast<quint64>(scores[difficulty].size()) * sizeof(quint16));
+        totalCount += scores[difficulty].size();
+    }
+    layout.addSection(Corpus::SCORE_INDEX_SECTION, totalCount * sizeof(quint64));
+
+    // Postings become corpus-wide sentence numbers, densest first within each n-gram
+    quint32 firstSentence[Corpus::DIFFICULTY_COUNT];
+    quint32 sentenceBase = 0;
+    for (int difficulty = 0; difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        firstSentence[difficulty] = sentenceBase;
+        sentenceBase += getSentenceCount(difficulty);
+    }
+    QVector<quint32> ngramDirectory;
+    QVector<quint64> ngramEntries;
+    ngramDirectory.reserve(NgramIndex::KEY_COUNT + 1);
+    for (int key = 0; key < NgramIndex::KEY_COUNT; ++key) {
+        ngramDirectory.append(static_cast<quint32>(ngramEntries.size()));
+        QVector<NgramPosting> &postings = ngramPostings[key];
+        std::sort(postings.begin(), postings.end(),
+                  [](const NgramPosting &a, const NgramPosting &b) { return a.density > b.density; });
+        for (const NgramPosting &posting : postings) {
+            ngramEntries.append(static_cast<quint64>(posting.letters) << 48
+                                | static_cast<quint64>(posting.occurrences) << 32
+                                | (firstSentence[posting.difficulty] + posting.index));
+        }
+    }
+    ngramDirectory.append(static_cast<quint32>(ngramEntries.size()));
+    layout.addSection(Corpus::NGRAM_DIRECTORY_SECTION, ngramDirectory.size() * sizeof(quint32));
+    layout.addSection(Corpus::NGRAM_POSTINGS_SECTION, ngramEntries.size() * sizeof(quint64));
+
+    // Score-major keys, so sorting them orders the index by score
+    QVector<quint64> scoreIndex;
+    scoreIndex.reserve(static_cast<int>(totalCount));
+    for (int difficulty = 0; difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        const QVector<quint16> &table = scores[difficulty];
+        for (int i = 0; i < table.size(); ++i) {
+            scoreIndex.append(static_cast<quint64>(table[i]) << 48 | static_cast<quint64>(difficulty) << 32
+                              | static_cast<quint32>(i));
+        }
+    }
+    std::sort(scoreIndex.begin(), scoreIndex.end());
+
+    QSaveFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly)) {
+        qDebug() << "Cannot write corpus" << outputPath;
+        return false;
+    }
+
+    bool ok = layout.writeHeader(output);
+
+    // Text: copy each spool in order
+    for (int difficulty = 0; ok && difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        QTemporaryFile &spool = *spools[difficulty];
+        ok = spool.flush() && spool.seek(0);
+        while (ok && !spool.atEnd()) {
+            const QByteArray chunk = spool.read(COPY_CHUNK_SIZE);
+            ok = !chunk.isEmpty() && output.write(chunk) == chunk.size();
+        }
+    }
+    ok = ok && SectionFileWriter::writePadding(output, output.pos());
+
+    // Offset tables, rebased from spool-relative to text-relative
+    for (int difficulty = 0; ok && difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        const quint64 base = spoolBase[difficulty];
+        ok = writeTable(output, offsets[difficulty], [base](quint64 offset) { return base + offset; });
+    }
+
+    auto identity = [](auto value) { return value; };
+    for (int difficulty = 0; ok && difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        ok = writeTable(output, scores[difficulty], identity);
+    }
+    ok = ok && writeTable(output, scoreIndex, identity);
+    ok = ok && writeTable(output, ngramDirectory, identity);
+    ok = ok && writeTable(output, ngramEntries, identity);
+
+    if (!ok) {
+        qDebug() << "Failed writing corpus" << outputPath;
+        output.cancelWriting();
+        return false;
+    }
+    return output.commit();
+}
@@ -0,0 +1,59 @@
+/**
+ * Typing Speed Test - Corpus Writer
+ *
+ * Streams sentences into the binary corpus format read by Corpus. Sentence
+ * text is spooled to one temporary file per difficulty as it arrives, so
+ * memory use is only the offset and score tables plus the capped n-gram
+ * postings, and finish() assembles the file and sorts the score index.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef CORPUSWRITER_H
+#define CORPUSWRITER_H
+
+#include <QByteArray>
+#include <QScopedPointer>
+#include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+#include "corpus.h"
+#include "ngramindex.h"
+
+class CorpusWriter
+{
+public:
+    explicit CorpusWriter(const QString &path);
+    ~CorpusWriter();
+
+    // Scores the sentence with SentenceScorer
+    bool addSentence(int difficulty, const QByteArray &utf8);
+    bool addSentence(int difficulty, const QByteArray &utf8, float score);
+    quint32 getSentenceCount(int difficulty) const;
+
+    // Writes the corpus; nothing is written at path before this
+    bool finish();
+
+private:
+    Q_DISABLE_COPY(CorpusWriter)
+
+    struct NgramPosting {
+        quint32 density; // occurrences * 65536 / letters
+        quint32 index;
+        quint16 occurrences;
+        quint16 letters;
+        quint8 difficulty;
+    };
+
+    void indexNgrams(int difficulty, quint32 index, const QByteArray &utf8);
+
+    QString outputPath;
+    QScopedPointer<QTemporaryFile> spools[Corpus::DIFFICULTY_COUNT];
+    QVector<quint64> offsets[Corpus::DIFFICULTY_COUNT]; // Relative to the spool, count + 1 entries
+    QVector<quint16> scores[Corpus::DIFFICULTY_COUNT];  // Corpus::quantizeScore()
+    QVector<NgramPosting> ngramPostings[NgramIndex::KEY_COUNT]; // Min-heaps on density, capped
+    bool failed;
+};
+
+#endif // CORPUSWRITER_H
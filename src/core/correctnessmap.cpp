@@ -0,0 +1,216 @@
+/**
+ * Typing Speed Test - Correctness Map Implementation
+ *
+ * Per-character state of a test as two packed bitsets over the passage's
+ * grapheme clusters: whether each typed cluster is correct now, and whether
+ * it was ever mistyped. Keystrokes update single bits and a running count of
+ * correct clusters, so accuracy costs nothing per keystroke; corrected errors
+ * and error positions are popcounts and bit scans over 64 clusters per word,
+ * and the renderer reads runs of equal state straight off the bits.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "correctnessmap.h"
+#include <QtAlgorithms>
+
+CorrectnessMap::CorrectnessMap()
+    : typedCount(0)
+    , correctCount(0)
+{
+}
+
+void CorrectnessMap::clear()
+{
+    correct.clear();
+    mistyped.clear();
+    typedCount = 0;
+    correctCount = 0;
+}
+
+int CorrectnessMap::getTypedCount() const
+{
+    return typedCount;
+}
+
+void CorrectnessMap::setCorrect(int cluster, bool isCorrect)
+{
+    correctCount += static_cast<int>(isCorrect) - static_cast<int>(testBit(correct, cluster));
+    setBit(correct, cluster, isCorrect);
+    typedCount = qMax(typedCount, cluster + 1);
+}
+
+void CorrectnessMap::markMistyped(int cluster)
+{
+    setBit(mistyped, cluster, true);
+}
+
+void CorrectnessMap::truncate(int count)
+{
+    if (count >= typedCount) {
+        return;
+    }
+
+    count = qMax(0, count);
+    correctCount -= countBits(correct, count, typedCount);
+    typedCount = count;
+    correct.resize((typedCount + WORD_BITS - 1) / WORD_BITS);
+    if (typedCount % WORD_BITS != 0) {
+        correct.last() &= ~0ULL >> (WORD_BITS - typedCount % WORD_BITS);
+    }
+}
+
+void CorrectnessMap::removeFront(int count)
+{
+    count = qBound(0, count, typedCount);
+    correctCount -= countBits(correct, 0, count);
+    shiftDown(correct, count);
+    shiftDown(mistyped, count);
+    typedCount -= count;
+}
+
+bool CorrectnessMap::isCorrect(int cluster) const
+{
+    return testBit(correct, cluster);
+}
+
+bool CorrectnessMap::wasMistyped(int cluster) const
+{
+    return testBit(mistyped, cluster);
+}
+
+int CorrectnessMap::countCorrect() const
+{
+    return correctCount;
+}
+
+int CorrectnessMap::countCorrect(int from, int to) const
+{
+    return countBits(correct, from, qMin(to, typedCount));
+}
+
+int CorrectnessMap::countErrors() const
+{
+    return typedCount - countCorrect();
+}
+
+int CorrectnessMap::countMistyped() const
+{
+    int count = 0;
+    for (quint64 word : mistyped) {
+        count += qPopulationCount(word);
+    }
+    return count;
+}
+
+int CorrectnessMap::countCorrected() const
+{
+    return countCorrected(0, typedCount);
+}
+
+int CorrectnessMap::countCorrected(int from, int to) const
+{
+    to = qMin(to, typedCount);
+    int count = 0;
+    for (int word = from / WORD_BITS; word * WORD_BITS < to && word < correct.size() && word < mistyped.size(); ++word) {
+        quint64 bits = correct[word] & mistyped[word];
+        if (word == from / WORD_BITS) {
+            bits &= ~0ULL << (from % WORD_BITS);
+        }
+        if ((word + 1) * WORD_BITS > to) {
+            bits &= ~0ULL >> (WORD_BITS - to % WORD_BITS);
+        }
+        count += qPopulationCount(bits);
+    }
+    return count;
+}
+
+int CorrectnessMap::nextError(int from) const
+{
+    return findBit(correct, false, from, typedCount);
+}
+
+QVector<int> CorrectnessMap::getErrorPositions() const
+{
+    QVector<int> positions;
+    positions.reserve(countErrors());
+    for (int error = nextError(0); error < typedCount; error = nextError(error + 1)) {
+        positions.append(error);
+    }
+    return positions;
+}
+
+int CorrectnessMap::runEnd(int from, int to) const
+{
+    return findBit(correct, !isCorrect(from), from + 1, qMin(to, typedCount));
+}
+
+void CorrectnessMap::setBit(QVector<quint64> &bits, int index, bool value)
+{
+    const int word = index / WORD_BITS;
+    if (word >= bits.size()) {
+        bits.resize(word + 1); // New words are clear
+    }
+    const quint64 mask = 1ULL << (index % WORD_BITS);
+    bits[word] = value ? bits[word] | mask : bits[word] & ~mask;
+}
+
+bool CorrectnessMap::testBit(const QVector<quint64> &bits, int index)
+{
+    const int word = index / WORD_BITS;
+    return index >= 0 && word < bits.size() && (bits[word] >> (index % WORD_BITS)) & 1;
+}
+
+int CorrectnessMap::countBits(const QVector<quint64> &bits, int from, int to)
+{
+    int count = 0;
+    for (int word = from / WORD_BITS; word * WORD_BITS < to && word < bits.size(); ++word) {
+        quint64 value = bits[word];
+        if (word == from / WORD_BITS) {
+            value &= ~0ULL << (from % WORD_BITS);
+        }
+        if ((word + 1) * WORD_BITS > to) {
+            value &= ~0ULL >> (WORD_BITS - to % WORD_BITS);
+        }
+        count += qPopulationCount(value);
+    }
+    return count;
+}
+
+int CorrectnessMap::findBit(const QVector<quint64> &bits, bool value, int from, int to)
+{
+    // Whole words without a match are skipped with one test each
+    while (from < to) {
+        const int word = from / WORD_BITS;
+        quint64 candidates = word < bits.size() ? bits[word] : 0;
+        if (!value) {
+            candidates = ~candidates;
+        }
+        candidates &= ~0ULL << (from % WORD_BITS);
+        if (candidates != 0) {
+            return qMin(to, word * WORD_BITS + static_cast<int>(qCountTrailingZeroBits(candidates)));
+        }
+        from = (word + 1) * WORD_BITS;
+    }
+    return to;
+}
+
+void CorrectnessMap::shiftDown(QVector<quint64> &bits, int count)
+{
+    const int words = count / WORD_BITS;
+    const int shift = count % WORD_BITS;
+    if (words >= bits.size()) {
+        bits.clear();
+        return;
+    }
+
+    bits.remove(0, words);
+    if (shift == 0) {
+        return;
+    }
+    for (int i = 0; i < bits.size(); ++i) {
+        const quint64 next = i + 1 < bits.size() ? bits[i + 1] : 0;
+        bits[i] = (bits[i] >> shift) | (next << (WORD_BITS - shift));
+    }
+}
@@ -0,0 +1,65 @@
+/**
+ * Typing Speed Test - Correctness Map
+ *
+ * Per-character state of a test as two packed bitsets over the passage's
+ * grapheme clusters: whether each typed cluster is correct now, and whether
+ * it was ever mistyped. Keystrokes update single bits and a running count of
+ * correct clusters, so accuracy costs nothing per keystroke; corrected errors
+ * and error positions are popcounts and bit scans over 64 clusters per word,
+ * and the renderer reads runs of equal state straight off the bits.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef CORRECTNESSMAP_H
+#define CORRECTNESSMAP_H
+
+#include <QVector>
+
+class CorrectnessMap
+{
+public:
+    CorrectnessMap();
+
+    void clear();
+    int getTypedCount() const;
+
+    // Typed clusters are set in order; setting one past the end extends the typed count
+    void setCorrect(int cluster, bool correct);
+    void markMistyped(int cluster); // Kept through corrections and backspacing
+    void truncate(int typedCount);  // Backspacing; clusters past the count become untyped
+    void removeFront(int count);    // Text an endless test retired
+
+    bool isCorrect(int cluster) const; // False for untyped clusters
+    bool wasMistyped(int cluster) const;
+
+    // Over typed clusters in [from, to)
+    int countCorrect() const;
+    int countCorrect(int from, int to) const;
+    int countErrors() const;                   // Typed and wrong now
+    int countMistyped() const;                 // Wrong at some point, typed now or not
+    int countCorrected() const;                // Wrong at some point and correct now
+    int countCorrected(int from, int to) const;
+
+    int nextError(int from) const; // First wrong typed cluster at or after from; the typed count if none
+    QVector<int> getErrorPositions() const;
+    // End of the run of equal correctness starting at a typed cluster, at most to
+    int runEnd(int from, int to) const;
+
+private:
+    static const int WORD_BITS = 64;
+
+    static void setBit(QVector<quint64> &bits, int index, bool value);
+    static bool testBit(const QVector<quint64> &bits, int index);
+    static int countBits(const QVector<quint64> &bits, int from, int to);
+    static int findBit(const QVector<quint64> &bits, bool value, int from, int to);
+    static void shiftDown(QVector<quint64> &bits, int count);
+
+    QVector<quint64> correct;  // Bits past the typed count are always clear
+    QVector<quint64> mistyped;
+    int typedCount;
+    int correctCount; // Set bits of correct
+};
+
+#endif // CORRECTNESSMAP_H
@@ -0,0 +1,193 @@
+/**
+ * Typing Speed Test - Keyboard Layout Implementation
+ *
+ * Where each character is typed on the QWERTY, Dvorak, Colemak, AZERTY and
+ * QWERTZ layouts: row, column, finger and whether it needs Shift. The rows
+ * are written once per layout and compiled into a Latin-1 lookup table per
+ * layout, so a lookup is one array index and row and finger drills are read
+ * straight off the tables. Each layout also names the language whose corpus
+ * its passages come from.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "keyboardlayout.h"
+#include <array>
+#include <string_view>
+
+namespace {
+
+const int LETTER_ROWS = KeyboardLayout::SPACE_ROW;
+
+// Each row from the 1 key's column rightwards, unshifted then shifted; the key left
+// of 1 and the extra ISO key left of the bottom row are not drilled and left out
+struct LayoutRows {
+    const char *name;
+    KeyboardLayout::Language language;
+    std::u16string_view keys[LETTER_ROWS];
+    std::u16string_view shifted[LETTER_ROWS];
+};
+
+constexpr LayoutRows LAYOUTS[KeyboardLayout::LAYOUT_COUNT] = {
+    {"QWERTY", KeyboardLayout::ENGLISH,
+     {u"1234567890-=", u"qwertyuiop[]\\", u"asdfghjkl;'", u"zxcvbnm,./"},
+     {u"!@#$%^&*()_+", u"QWERTYUIOP{}|", u"ASDFGHJKL:\"", u"ZXCVBNM<>?"}},
+    {"Dvorak", KeyboardLayout::ENGLISH,
+     {u"1234567890[]", u"',.pyfgcrl/=\\", u"aoeuidhtns-", u";qjkxbmwvz"},
+     {u"!@#$%^&*(){}", u"\"<>PYFGCRL?+|", u"AOEUIDHTNS_", u":QJKXBMWVZ"}},
+    {"Colemak", KeyboardLayout::ENGLISH,
+     {u"1234567890-=", u"qwfpgjluy;[]\\", u"arstdhneio'", u"zxcvbkm,./"},
+     {u"!@#$%^&*()_+", u"QWFPGJLUY:{}|", u"ARSTDHNEIO\"", u"ZXCVBKM<>?"}},
+    {"AZERTY", KeyboardLayout::FRENCH,
+     {u"&é\"'(-è_çà)=", u"azertyuiop^$", u"qsdfghjklmù*", u"wxcvbn,;:!"},
+     {u"1234567890°+", u"AZERTYUIOP¨£", u"QSDFGHJKLM%µ", u"WXCVBN?./§"}},
+    {"QWERTZ", KeyboardLayout::GERMAN,
+     {u"1234567890ß´", u"qwertzuiopü+", u"asdfghjklöä#", u"yxcvbnm,.-"},
+     {u"!\"§$%&/()=?`", u"QWERTZUIOPÜ*", u"ASDFGHJKLÖÄ'", u"YXCVBNM;:_"}}
+};
+
+// Touch typing columns: index fingers take two each, the right pinky everything past the ring finger
+constexpr quint8 fingerForColumn(int column)
+{
+    constexpr quint8 FINGERS[] = {
+        KeyboardLayout::LEFT_PINKY, KeyboardLayout::LEFT_RING, KeyboardLayout::LEFT_MIDDLE,
+        KeyboardLayout::LEFT_INDEX, KeyboardLayout::LEFT_INDEX, KeyboardLayout::RIGHT_INDEX,
+        KeyboardLayout::RIGHT_INDEX, KeyboardLayout::RIGHT_MIDDLE, KeyboardLayout::RIGHT_RING
+    };
+    return column < 9 ? FINGERS[column] : static_cast<quint8>(KeyboardLayout::RIGHT_PINKY);
+}
+
+using KeyTable = std::array<KeyboardLayout::Key, 256>;
+
+// Unshifted keys win where a character appears twice (AZERTY's digits are shifted only)
+constexpr KeyTable buildKeyTable(const LayoutRows &layout)
+{
+    KeyTable table{};
+    for (KeyboardLayout::Key &key : table) {
+        key = {KeyboardLayout::NO_ROW, 0, 0, false};
+    }
+    table[' '] = {KeyboardLayout::SPACE_ROW, KeyboardLayout::THUMB, 0, false};
+
+    for (int shifted = 0; shifted < 2; ++shifted) {
+        for (int row = 0; row < LETTER_ROWS; ++row) {
+            const std::u16string_view keys = shifted ? layout.shifted[row] : layout.keys[row];
+            for (int column = 0; column < static_cast<int>(keys.size()); ++column) {
+                const char16_t character = keys[column];
+                if (character < table.size() && table[character].row == KeyboardLayout::NO_ROW) {
+                    table[character] = {static_cast<quint8>(row), fingerForColumn(column),
+                                        static_cast<quint8>(column), shifted != 0};
+                }
+            }
+        }
+    }
+    return table;
+}
+
+constexpr KeyTable KEY_TABLES[KeyboardLayout::LAYOUT_COUNT] = {
+    buildKeyTable(LAYOUTS[KeyboardLayout::QWERTY]),
+    buildKeyTable(LAYOUTS[KeyboardLayout::DVORAK]),
+    buildKeyTable(LAYOUTS[KeyboardLayout::COLEMAK]),
+    buildKeyTable(LAYOUTS[KeyboardLayout::AZERTY]),
+    buildKeyTable(LAYOUTS[KeyboardLayout::QWERTZ])
+};
+
+// Spot checks that the rows line up with the columns the fingers expect
+static_assert(KEY_TABLES[KeyboardLayout::QWERTY]['f'].finger == KeyboardLayout::LEFT_INDEX
+              && KEY_TABLES[KeyboardLayout::QWERTY]['f'].row == KeyboardLayout::HOME_ROW, "QWERTY home row");
+static_assert(KEY_TABLES[KeyboardLayout::QWERTY]['P'].finger == KeyboardLayout::RIGHT_PINKY
+              && KEY_TABLES[KeyboardLayout::QWERTY]['P'].shifted, "QWERTY shifted top row");
+static_assert(KEY_TABLES[KeyboardLayout::DVORAK]['u'].finger == KeyboardLayout::LEFT_INDEX, "Dvorak home row");
+static_assert(KEY_TABLES[KeyboardLayout::COLEMAK]['n'].finger == KeyboardLayout::RIGHT_INDEX, "Colemak home row");
+static_assert(KEY_TABLES[KeyboardLayout::AZERTY]['q'].finger == KeyboardLayout::LEFT_PINKY
+              && KEY_TABLES[KeyboardLayout::AZERTY]['1'].shifted, "AZERTY rows");
+static_assert(KEY_TABLES[KeyboardLayout::QWERTZ]['z'].row == KeyboardLayout::TOP_ROW
+              && KEY_TABLES[KeyboardLayout::QWERTZ][u'ö'].finger == KeyboardLayout::RIGHT_PINKY, "QWERTZ rows");
+
+const int MAX_COLUMNS = 16;
+
+KeyboardLayout::Layout validLayout(KeyboardLayout::Layout layout)
+{
+    return layout >= 0 && layout < KeyboardLayout::LAYOUT_COUNT ? layout : KeyboardLayout::QWERTY;
+}
+
+// Unshifted keys of a layout's lookup table ordered by rank, then column; rank -1 leaves a key out
+template<typename Rank>
+QString collectKeys(KeyboardLayout::Layout layout, Rank rank)
+{
+    char16_t slots[KeyboardLayout::ROW_COUNT][MAX_COLUMNS] = {};
+    const KeyTable &table = KEY_TABLES[validLayout(layout)];
+    for (int character = 0; character < static_cast<int>(table.size()); ++character) {
+        const KeyboardLayout::Key &key = table[character];
+        const int slot = key.isValid() && !key.shifted ? rank(key) : -1;
+        if (slot >= 0 && key.column < MAX_COLUMNS) {
+            slots[slot][key.column] = static_cast<char16_t>(character);
+        }
+    }
+
+    QString keys;
+    for (const auto &row : slots) {
+        for (char16_t character : row) {
+            if (character != 0) {
+                keys += QChar(character);
+            }
+        }
+    }
+    return keys;
+}
+
+}
+
+KeyboardLayout::Key KeyboardLayout::keyFor(Layout layout, QChar character)
+{
+    if (layout < 0 || layout >= LAYOUT_COUNT || character.unicode() >= 256) {
+        return {NO_ROW, 0, 0, false};
+    }
+    return KEY_TABLES[layout][character.unicode()];
+}
+
+QString KeyboardLayout::getRowKeys(Layout layout, Row row)
+{
+    return collectKeys(layout, [row](const Key &key) { return key.row == row ? 0 : -1; });
+}
+
+QString KeyboardLayout::getFingerKeys(Layout layout, Finger finger)
+{
+    // The thumb's only key is the space bar, on the last rank
+    static const int RANKS[ROW_COUNT] = {-1, 1, 0, 2, 3}; // By Row: home, top, bottom, space
+    return collectKeys(layout, [finger](const Key &key) { return key.finger == finger ? RANKS[key.row] : -1; });
+}
+
+QString KeyboardLayout::getLayoutName(Layout layout)
+{
+    return QString::fromLatin1(LAYOUTS[validLayout(layout)].name);
+}
+
+KeyboardLayout::Language KeyboardLayout::getLanguage(Layout layout)
+{
+    return LAYOUTS[validLayout(layout)].language;
+}
+
+QString KeyboardLayout::getLanguageCode(Language language)
+{
+    switch (language) {
+        case FRENCH:
+            return "fr";
+        case GERMAN:
+            return "de";
+        default:
+            return "en";
+    }
+}
+
+QString KeyboardLayout::getLanguageName(Language language)
+{
+    switch (language) {
+        case FRENCH:
+            return "French";
+        case GERMAN:
+            return "German";
+        default:
+            return "English";
+    }
+}
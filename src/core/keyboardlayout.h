@@ -0,0 +1,86 @@
+/**
+ * Typing Speed Test - Keyboard Layout
+ *
+ * Where each character is typed on the QWERTY, Dvorak, Colemak, AZERTY and
+ * QWERTZ layouts: row, column, finger and whether it needs Shift. The rows
+ * are written once per layout and compiled into a Latin-1 lookup table per
+ * layout, so a lookup is one array index and row and finger drills are read
+ * straight off the tables. Each layout also names the language whose corpus
+ * its passages come from.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef KEYBOARDLAYOUT_H
+#define KEYBOARDLAYOUT_H
+
+#include <QString>
+
+class KeyboardLayout
+{
+public:
+    enum Layout {
+        QWERTY,
+        DVORAK,
+        COLEMAK,
+        AZERTY,  // French
+        QWERTZ,  // German
+        LAYOUT_COUNT
+    };
+
+    enum Row {
+        NUMBER_ROW,
+        TOP_ROW,
+        HOME_ROW,
+        BOTTOM_ROW,
+        SPACE_ROW,
+        ROW_COUNT
+    };
+
+    enum Finger {
+        LEFT_PINKY,
+        LEFT_RING,
+        LEFT_MIDDLE,
+        LEFT_INDEX,
+        RIGHT_INDEX,
+        RIGHT_MIDDLE,
+        RIGHT_RING,
+        RIGHT_PINKY,
+        THUMB,
+        FINGER_COUNT
+    };
+
+    enum Language {
+        ENGLISH,
+        FRENCH,
+        GERMAN,
+        LANGUAGE_COUNT
+    };
+
+    static const quint8 NO_ROW = 0xFF;
+
+    // Columns count from the 1 key's, which the left pinky types on every row
+    struct Key {
+        quint8 row;    // Row, or NO_ROW if the layout has no key for the character
+        quint8 finger; // Finger
+        quint8 column;
+        bool shifted;
+
+        bool isValid() const { return row != NO_ROW; }
+    };
+
+    static Key keyFor(Layout layout, QChar character);
+
+    // Unshifted keys of a row in the lookup table, left to right from the first column
+    static QString getRowKeys(Layout layout, Row row);
+    // Unshifted keys a finger types in the lookup table: home row first, then top and bottom
+    static QString getFingerKeys(Layout layout, Finger finger);
+
+    static QString getLayoutName(Layout layout);
+    static Language getLanguage(Layout layout);
+    static QString getLanguageCode(Language language); // "en", "fr", "de"
+    static QString getLanguageName(Language language);
+};
+
+#endif // KEYBOARDLAYOUT_H
@@ -0,0 +1,174 @@
+/**
+ * Typing Speed Test - Markov Model Implementation
+ *
+ * Read-only view of a word-level trigram model trained by CorpusBuilder.
+ * The file is memory mapped like the corpus. Every state is a pair of
+ * words, and its outgoing transitions are stored as a Walker alias table,
+ * so drawing the next word is one bounded random index, one compare and no
+ * hashing or searching, whatever the vocabulary size.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "markovmodel.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QtEndian>
+#include <QDebug>
+
+MarkovModel::MarkovModel()
+    : words(nullptr)
+    , wordsSize(0)
+    , wordOffsets(nullptr)
+    , wordCount(0)
+    , states(nullptr)
+    , stateCount(0)
+    , edges(nullptr)
+    , edgeCount(0)
+{
+}
+
+MarkovModel::~MarkovModel()
+{
+    close();
+}
+
+bool MarkovModel::open(const QString &path)
+{
+    close();
+    if (!reader.open(path, MAGIC, VERSION, "Markov model")) {
+        return false;
+    }
+
+    quint64 offsetsSize = 0;
+    quint64 statesSize = 0;
+    quint64 edgesSize = 0;
+    words = reader.findSection(WORDS_SECTION, wordsSize);
+    wordOffsets = reader.findSection(WORD_OFFSETS_SECTION, offsetsSize);
+    states = reader.findSection(STATES_SECTION, statesSize);
+    edges = reader.findSection(EDGES_SECTION, edgesSize);
+    if (!words || !wordOffsets || !states || !edges || offsetsSize < sizeof(quint32) || statesSize < STATE_SIZE) {
+        qDebug() << "Missing sections in Markov model" << path;
+        close();
+        return false;
+    }
+
+    wordCount = static_cast<quint32>(offsetsSize / sizeof(quint32) - 1);
+    stateCount = static_cast<quint32>(statesSize / STATE_SIZE);
+    edgeCount = static_cast<quint32>(edgesSize / EDGE_SIZE);
+    if (qFromLittleEndian<quint32>(wordOffsets + wordCount * sizeof(quint32)) > wordsSize) {
+        qDebug() << "Corrupt word table in Markov model" << path;
+        close();
+        return false;
+    }
+
+    // Edge and state references are bounds-checked as they are followed, so opening stays O(1)
+    return true;
+}
+
+void MarkovModel::close()
+{
+    reader.close();
+    words = nullptr;
+    wordsSize = 0;
+    wordOffsets = nullptr;
+    wordCount = 0;
+    states = nullptr;
+    stateCount = 0;
+    edges = nullptr;
+    edgeCount = 0;
+}
+
+bool MarkovModel::isOpen() const
+{
+    return reader.isOpen();
+}
+
+quint32 MarkovModel::getWordCount() const
+{
+    return wordCount;
+}
+
+quint32 MarkovModel::getStateCount() const
+{
+    return stateCount;
+}
+
+QByteArray MarkovModel::getWordUtf8(quint32 word) const
+{
+    if (word >= wordCount) {
+        return QByteArray();
+    }
+
+    const uchar *entry = wordOffsets + word * sizeof(quint32);
+    const quint32 begin = qFromLittleEndian<quint32>(entry);
+    const quint32 end = qFromLittleEndian<quint32>(entry + sizeof(quint32));
+    if (begin > end || end > wordsSize) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(words + begin), static_cast<int>(end - begin));
+}
+
+quint32 MarkovModel::nextState(quint32 state, SessionRandom &random) const
+{
+    const uchar *entry = states + static_cast<quint64>(state) * STATE_SIZE;
+    const quint32 first = qFromLittleEndian<quint32>(entry + 4);
+    const quint32 count = qFromLittleEndian<quint32>(entry + 8);
+    if (count == 0 || first >= edgeCount || count > edgeCount - first) {
+        return 0; // Dead end: finish the sentence
+    }
+
+    // Walker's method: a uniform column, then a biased coin between it and its alias
+    quint32 edge = first + random.bounded(count);
+    const uchar *column = edges + static_cast<quint64>(edge) * EDGE_SIZE;
+    if (random.generate() >= qFromLittleEndian<quint32>(column + 8)) {
+        edge = qFromLittleEndian<quint32>(column + 4);
+        if (edge >= edgeCount) {
+            return 0;
+        }
+        column = edges + static_cast<quint64>(edge) * EDGE_SIZE;
+    }
+
+    const quint32 next = qFromLittleEndian<quint32>(column);
+    return next < stateCount ? next : 0;
+}
+
+QByteArray MarkovModel::generateSentenceUtf8(SessionRandom &random) const
+{
+    QByteArray sentence;
+    if (!isOpen()) {
+        return sentence;
+    }
+
+    sentence.reserve(128);
+    quint32 state = 0;
+    for (int count = 0; count < MAX_SENTENCE_WORDS; ++count) {
+        state = nextState(state, random);
+        if (state == 0) {
+            break;
+        }
+
+        const quint32 word = qFromLittleEndian<quint32>(states + static_cast<quint64>(state) * STATE_SIZE);
+        if (!sentence.isEmpty()) {
+            sentence += ' ';
+        }
+        sentence += getWordUtf8(word);
+    }
+    return sentence;
+}
+
+QString MarkovModel::generateSentence(SessionRandom &random) const
+{
+    const QByteArray utf8 = generateSentenceUtf8(random);
+    return QString::fromUtf8(utf8.constData(), utf8.size());
+}
+
+QString MarkovModel::getDefaultPath()
+{
+    QDir corpusDir(QCoreApplication::applicationDirPath());
+    if (corpusDir.cd("corpus") && corpusDir.exists("passages.model")) {
+        return corpusDir.filePath("passages.model");
+    }
+    return QString();
+}
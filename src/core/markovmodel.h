@@ -0,0 +1,80 @@
+/**
+ * Typing Speed Test - Markov Model
+ *
+ * Read-only view of a word-level trigram model trained by CorpusBuilder.
+ * The file is memory mapped like the corpus. Every state is a pair of
+ * words, and its outgoing transitions are stored as a Walker alias table,
+ * so drawing the next word is one bounded random index, one compare and no
+ * hashing or searching, whatever the vocabulary size.
+ *
+ * A section file (see sectionfile.h) with magic "TSMM" and sections:
+ *   WORDS: UTF-8 words back to back
+ *   WORD_OFFSETS: u32[word count + 1] into WORDS; word 0 is the empty sentence boundary
+ *   STATES: per state u32 last word, u32 first edge, u32 edge count; state 0 starts a sentence
+ *   EDGES: per transition u32 next state, u32 alias edge, u32 threshold (probability * 2^32)
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef MARKOVMODEL_H
+#define MARKOVMODEL_H
+
+#include <QByteArray>
+#include <QString>
+#include "sectionfile.h"
+#include "sessionrandom.h"
+
+class MarkovModel
+{
+public:
+    static const quint32 MAGIC = 0x4D4D5354; // "TSMM"
+    static const quint16 VERSION = 1;
+
+    enum SectionId {
+        WORDS_SECTION = 1,
+        WORD_OFFSETS_SECTION = 2,
+        STATES_SECTION = 3,
+        EDGES_SECTION = 4
+    };
+
+    static const int STATE_SIZE = 12;
+    static const int EDGE_SIZE = 12;
+
+    MarkovModel();
+    ~MarkovModel();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+
+    quint32 getWordCount() const;
+    quint32 getStateCount() const;
+    QByteArray getWordUtf8(quint32 word) const; // Points into the mapping; valid until close()
+
+    // One generated sentence, words separated by single spaces; thread-safe with a per-thread generator
+    QByteArray generateSentenceUtf8(SessionRandom &random) const;
+    QString generateSentence(SessionRandom &random) const;
+
+    // <app dir>/corpus/passages.model, or empty if not installed
+    static QString getDefaultPath();
+
+private:
+    Q_DISABLE_COPY(MarkovModel)
+
+    static const int MAX_SENTENCE_WORDS = 60; // Caps runaway chains in cyclic models
+
+    quint32 nextState(quint32 state, SessionRandom &random) const;
+
+    SectionFileReader reader;
+    const uchar *words;
+    quint64 wordsSize;
+    const uchar *wordOffsets;
+    quint32 wordCount;
+    const uchar *states;
+    quint32 stateCount;
+    const uchar *edges;
+    quint32 edgeCount;
+};
+
+#endif // MARKOVMODEL_H
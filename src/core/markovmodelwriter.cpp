@@ -0,0 +1,197 @@
+/**
+ * Typing Speed Test - Markov Model Writer Implementation
+ *
+ * Trains the word-level trigram model read by MarkovModel from whole
+ * sentences and writes it with a precomputed alias table per state.
+ * Training keeps the vocabulary and transition counts in memory.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "markovmodelwriter.h"
+#include "markovmodel.h"
+#include "sectionfile.h"
+#include <algorithm>
+
+namespace {
+
+struct Transition {
+    quint32 state;
+    quint32 next;
+    quint32 count;
+
+    bool operator<(const Transition &other) const
+    {
+        return state != other.state ? state < other.state : next < other.next;
+    }
+};
+
+// Vose's alias method over one state's transitions; thresholds are probability * 2^32
+void buildAliasTable(const QVector<Transition> &transitions, int first, int count,
+                     QVector<quint32> &aliases, QVector<quint32> &thresholds)
+{
+    double total = 0.0;
+    for (int i = first; i < first + count; ++i) {
+        total += transitions[i].count;
+    }
+
+    QVector<double> scaled(count);
+    QVector<int> small;
+    QVector<int> large;
+    for (int i = 0; i < count; ++i) {
+        scaled[i] = transitions[first + i].count * count / total;
+        (scaled[i] < 1.0 ? small : large).append(i);
+    }
+
+    while (!small.isEmpty() && !large.isEmpty()) {
+        const int lesser = small.takeLast();
+        const int greater = large.last();
+        thresholds[first + lesser] = static_cast<quint32>(qMax(0.0, scaled[lesser]) * 4294967296.0);
+        aliases[first + lesser] = static_cast<quint32>(first + greater);
+
+        scaled[greater] -= 1.0 - scaled[lesser];
+        if (scaled[greater] < 1.0) {
+            large.removeLast();
+            small.append(greater);
+        }
+    }
+
+    // Whatever is left is 1.0 up to rounding error
+    for (int i : small + large) {
+        thresholds[first + i] = 0xFFFFFFFFu;
+        aliases[first + i] = static_cast<quint32>(first + i);
+    }
+}
+
+}
+
+MarkovModelWriter::MarkovModelWriter()
+{
+    words.append(QByteArray());
+    stateIds.insert(0, 0);
+    stateWords.append(0);
+}
+
+void MarkovModelWriter::addSentence(const QByteArray &utf8)
+{
+    quint32 previous = 0;
+    quint32 current = 0;
+    quint32 state = 0;
+
+    for (const QByteArray &word : utf8.split(' ')) {
+        if (word.isEmpty()) {
+            continue;
+        }
+        previous = current;
+        current = wordId(word);
+
+        const quint32 next = stateId(previous, current);
+        ++transitionCounts[static_cast<quint64>(state) << 32 | next];
+        state = next;
+    }
+
+    if (state != 0) {
+        ++transitionCounts[static_cast<quint64>(state) << 32]; // Sentence end returns to the start state
+    }
+}
+
+quint32 MarkovModelWriter::getWordCount() const
+{
+    return static_cast<quint32>(words.size());
+}
+
+quint32 MarkovModelWriter::getStateCount() const
+{
+    return static_cast<quint32>(stateWords.size());
+}
+
+quint32 MarkovModelWriter::getTransitionCount() const
+{
+    return static_cast<quint32>(transitionCounts.size());
+}
+
+quint32 MarkovModelWriter::wordId(const QByteArray &word)
+{
+    auto it = vocabulary.constFind(word);
+    if (it != vocabulary.constEnd()) {
+        return it.value();
+    }
+
+    const quint32 id = static_cast<quint32>(words.size());
+    vocabulary.insert(word, id);
+    words.append(word);
+    return id;
+}
+
+quint32 MarkovModelWriter::stateId(quint32 previousWord, quint32 word)
+{
+    const quint64 key = static_cast<quint64>(previousWord) << 32 | word;
+    auto it = stateIds.constFind(key);
+    if (it != stateIds.constEnd()) {
+        return it.value();
+    }
+
+    const quint32 id = static_cast<quint32>(stateWords.size());
+    stateIds.insert(key, id);
+    stateWords.append(word);
+    return id;
+}
+
+bool MarkovModelWriter::write(const QString &path) const
+{
+    // Transitions grouped by state become each state's contiguous edge range
+    QVector<Transition> transitions;
+    transitions.reserve(transitionCounts.size());
+    for (auto it = transitionCounts.constBegin(); it != transitionCounts.constEnd(); ++it) {
+        transitions.append({static_cast<quint32>(it.key() >> 32), static_cast<quint32>(it.key()), it.value()});
+    }
+    std::sort(transitions.begin(), transitions.end());
+
+    QVector<quint32> firstEdge(stateWords.size(), 0);
+    QVector<quint32> edgeCount(stateWords.size(), 0);
+    QVector<quint32> aliases(transitions.size());
+    QVector<quint32> thresholds(transitions.size());
+    for (int first = 0; first < transitions.size(); ) {
+        int end = first + 1;
+        while (end < transitions.size() && transitions[end].state == transitions[first].state) {
+            ++end;
+        }
+        firstEdge[transitions[first].state] = static_cast<quint32>(first);
+        edgeCount[transitions[first].state] = static_cast<quint32>(end - first);
+        buildAliasTable(transitions, first, end - first, aliases, thresholds);
+        first = end;
+    }
+
+    // Sections are assembled in memory; models are a small fraction of the corpus they come from
+    QByteArray wordText;
+    QByteArray wordOffsets;
+    SectionFileWriter::appendLittleEndian(wordOffsets, 0, 4);
+    for (const QByteArray &word : words) {
+        wordText += word;
+        SectionFileWriter::appendLittleEndian(wordOffsets, static_cast<quint64>(wordText.size()), 4);
+    }
+
+    QByteArray stateTable;
+    stateTable.reserve(stateWords.size() * MarkovModel::STATE_SIZE);
+    for (int state = 0; state < stateWords.size(); ++state) {
+        SectionFileWriter::appendLittleEndian(stateTable, stateWords[state], 4);
+        SectionFileWriter::appendLittleEndian(stateTable, firstEdge[state], 4);
+        SectionFileWriter::appendLittleEndian(stateTable, edgeCount[state], 4);
+    }
+
+    QByteArray edgeTable;
+    edgeTable.reserve(transitions.size() * MarkovModel::EDGE_SIZE);
+    for (int edge = 0; edge < transitions.size(); ++edge) {
+        SectionFileWriter::appendLittleEndian(edgeTable, transitions[edge].next, 4);
+        SectionFileWriter::appendLittleEndian(edgeTable, aliases[edge], 4);
+        SectionFileWriter::appendLittleEndian(edgeTable, thresholds[edge], 4);
+    }
+
+    SectionFileWriter writer(MarkovModel::MAGIC, MarkovModel::VERSION);
+    writer.addSection(MarkovModel::WORDS_SECTION, wordText);
+    writer.addSection(MarkovModel::WORD_OFFSETS_SECTION, wordOffsets);
+    writer.addSection(MarkovModel::STATES_SECTION, stateTable);
+    writer.addSection(MarkovModel::EDGES_SECTION, edgeTable);
+    return writer.writeFile(path, "Markov model");
+}
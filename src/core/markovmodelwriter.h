@@ -0,0 +1,45 @@
+/**
+ * Typing Speed Test - Markov Model Writer
+ *
+ * Trains the word-level trigram model read by MarkovModel from whole
+ * sentences and writes it with a precomputed alias table per state.
+ * Training keeps the vocabulary and transition counts in memory.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef MARKOVMODELWRITER_H
+#define MARKOVMODELWRITER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class MarkovModelWriter
+{
+public:
+    MarkovModelWriter();
+
+    // Words are split on spaces and keep their punctuation
+    void addSentence(const QByteArray &utf8);
+
+    quint32 getWordCount() const;
+    quint32 getStateCount() const;
+    quint32 getTransitionCount() const;
+
+    bool write(const QString &path) const;
+
+private:
+    quint32 wordId(const QByteArray &word);
+    quint32 stateId(quint32 previousWord, quint32 word);
+
+    QHash<QByteArray, quint32> vocabulary;
+    QVector<QByteArray> words;                 // By id; 0 is the sentence boundary
+    QHash<quint64, quint32> stateIds;          // previous word << 32 | word
+    QVector<quint32> stateWords;               // Last word of each state
+    QHash<quint64, quint32> transitionCounts;  // state << 32 | next state
+};
+
+#endif // MARKOVMODELWRITER_H
@@ -0,0 +1,172 @@
+/**
+ * Typing Speed Test - N-gram Index Implementation
+ *
+ * Inverted index from letter bigrams and trigrams to the corpus sentences
+ * that contain them most densely. Each n-gram keeps a capped postings list
+ * (its POSTINGS_PER_GRAM densest sentences), so a weighted query merges a
+ * few thousand postings regardless of corpus size and answers in well under
+ * a millisecond. Sentences outside a list count as not containing that
+ * n-gram, which only ever demotes weaker matches.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "ngramindex.h"
+#include "corpus.h"
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+
+int letterOf(uchar byte)
+{
+    if (byte >= 'a' && byte <= 'z') {
+        return byte - 'a';
+    }
+    if (byte >= 'A' && byte <= 'Z') {
+        return byte - 'A';
+    }
+    return -1;
+}
+
+}
+
+NgramIndex::NgramIndex()
+    : corpus(nullptr)
+    , directory(nullptr)
+    , postings(nullptr)
+    , postingCount(0)
+{
+}
+
+bool NgramIndex::attach(const Corpus &source)
+{
+    detach();
+
+    quint64 directorySize = 0;
+    quint64 postingsSize = 0;
+    const uchar *table = source.getSectionData(Corpus::NGRAM_DIRECTORY_SECTION, directorySize);
+    const uchar *entries = source.getSectionData(Corpus::NGRAM_POSTINGS_SECTION, postingsSize);
+    if (!table || !entries || directorySize < (KEY_COUNT + 1) * sizeof(quint32)) {
+        return false;
+    }
+
+    corpus = &source;
+    directory = table;
+    postings = entries;
+    postingCount = static_cast<quint32>(postingsSize / POSTING_SIZE);
+    return true;
+}
+
+void NgramIndex::detach()
+{
+    corpus = nullptr;
+    directory = nullptr;
+    postings = nullptr;
+    postingCount = 0;
+}
+
+bool NgramIndex::isValid() const
+{
+    return corpus != nullptr;
+}
+
+QVector<quint32> NgramIndex::findSentences(const QHash<QString, float> &weights, int count) const
+{
+    QVector<quint32> result;
+    if (!isValid() || count <= 0) {
+        return result;
+    }
+
+    QHash<quint32, float> scores;
+    for (auto it = weights.constBegin(); it != weights.constEnd(); ++it) {
+        const int key = keyOf(it.key());
+        if (key < 0 || it.value() <= 0.0f) {
+            continue;
+        }
+
+        const quint32 first = qFromLittleEndian<quint32>(directory + key * sizeof(quint32));
+        const quint32 last = qMin(qFromLittleEndian<quint32>(directory + (key + 1) * sizeof(quint32)), postingCount);
+        for (quint32 posting = first; posting < last; ++posting) {
+            const uchar *entry = postings + static_cast<quint64>(posting) * POSTING_SIZE;
+            const quint16 occurrences = qFromLittleEndian<quint16>(entry + 4);
+            const quint16 letters = qFromLittleEndian<quint16>(entry + 6);
+            scores[qFromLittleEndian<quint32>(entry)] += it.value() * occurrences / qMax<quint16>(letters, 1);
+        }
+    }
+
+    QVector<QPair<float, quint32>> ranked;
+    ranked.reserve(scores.size());
+    for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+        ranked.append(qMakePair(it.value(), it.key()));
+    }
+
+    const int kept = qMin(count, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + kept, ranked.end(),
+                      [](const QPair<float, quint32> &a, const QPair<float, quint32> &b) {
+                          return a.first > b.first;
+                      });
+    result.reserve(kept);
+    for (int i = 0; i < kept; ++i) {
+        result.append(ranked[i].second);
+    }
+    return result;
+}
+
+QString NgramIndex::getSentence(quint32 sentence) const
+{
+    if (!isValid()) {
+        return QString();
+    }
+
+    // Corpus-wide numbering runs through the difficulties in order
+    for (int difficulty = 0; difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        const quint32 count = corpus->getSentenceCount(difficulty);
+        if (sentence < count) {
+            return corpus->getSentence(difficulty, sentence);
+        }
+        sentence -= count;
+    }
+    return QString();
+}
+
+int NgramIndex::keyOf(const QString &ngram)
+{
+    if (ngram.length() != 2 && ngram.length() != 3) {
+        return -1;
+    }
+
+    int key = 0;
+    for (const QChar c : ngram) {
+        const int letter = c.unicode() < 0x80 ? letterOf(static_cast<uchar>(c.unicode())) : -1;
+        if (letter < 0) {
+            return -1;
+        }
+        key = key * 26 + letter;
+    }
+    return ngram.length() == 2 ? key : BIGRAM_COUNT + key;
+}
+
+void NgramIndex::collectKeys(const QByteArray &utf8, QVarLengthArray<int, 256> &keys, int &letters)
+{
+    keys.clear();
+    letters = 0;
+
+    int previous = -1;
+    int beforePrevious = -1;
+    for (char c : utf8) {
+        const int letter = letterOf(static_cast<uchar>(c));
+        if (letter >= 0) {
+            ++letters;
+            if (previous >= 0) {
+                keys.append(previous * 26 + letter);
+                if (beforePrevious >= 0) {
+                    keys.append(BIGRAM_COUNT + (beforePrevious * 26 + previous) * 26 + letter);
+                }
+            }
+        }
+        beforePrevious = letter >= 0 ? previous : -1;
+        previous = letter;
+    }
+}
@@ -0,0 +1,61 @@
+/**
+ * Typing Speed Test - N-gram Index
+ *
+ * Inverted index from letter bigrams and trigrams to the corpus sentences
+ * that contain them most densely. Each n-gram keeps a capped postings list
+ * (its POSTINGS_PER_GRAM densest sentences), so a weighted query merges a
+ * few thousand postings regardless of corpus size and answers in well under
+ * a millisecond. Sentences outside a list count as not containing that
+ * n-gram, which only ever demotes weaker matches.
+ *
+ * Corpus sections (see corpus.h):
+ *   NGRAM_DIRECTORY: u32[KEY_COUNT + 1] first posting of each key
+ *   NGRAM_POSTINGS:  per posting u32 corpus-wide sentence, u16 occurrences, u16 letters; densest first
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef NGRAMINDEX_H
+#define NGRAMINDEX_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVarLengthArray>
+#include <QVector>
+
+class Corpus;
+
+class NgramIndex
+{
+public:
+    static const int BIGRAM_COUNT = 26 * 26;
+    static const int KEY_COUNT = BIGRAM_COUNT + 26 * 26 * 26; // Bigram keys first, then trigrams
+    static const int POSTINGS_PER_GRAM = 1024;
+    static const int POSTING_SIZE = 8;
+
+    NgramIndex();
+
+    // Reads the index sections of an open corpus; false if it has none
+    bool attach(const Corpus &corpus);
+    void detach();
+    bool isValid() const;
+
+    // Corpus-wide sentence numbers, best first, scored by sum of weight * occurrences / letters
+    QVector<quint32> findSentences(const QHash<QString, float> &weights, int count) const;
+    QString getSentence(quint32 sentence) const;
+
+    // Key of a lowercase or uppercase ASCII bigram or trigram, or -1
+    static int keyOf(const QString &ngram);
+    // Every bigram and trigram key in a sentence, with repeats, plus its letter count
+    static void collectKeys(const QByteArray &utf8, QVarLengthArray<int, 256> &keys, int &letters);
+
+private:
+    const Corpus *corpus;
+    const uchar *directory;
+    const uchar *postings;
+    quint32 postingCount;
+};
+
+#endif // NGRAMINDEX_H
@@ -0,0 +1,220 @@
+/**
+ * Typing Speed Test - Passage Model Implementation
+ *
+ * Text split into grapheme clusters, the unit a reader sees as one
+ * character: a letter with its combining marks, a surrogate pair, or a
+ * whole emoji sequence. Boundaries are found once with QTextBoundaryFinder
+ * and kept as an offset array; changing the text re-segments only what
+ * follows the common prefix, so typed input costs one cluster per keystroke.
+ * Pure ASCII text is one cluster per code unit and keeps no table at all.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "passagemodel.h"
+#include <QTextBoundaryFinder>
+#include <algorithm>
+
+PassageModel::PassageModel()
+    : ascii(true)
+{
+}
+
+PassageModel::PassageModel(const QString &text)
+    : ascii(true)
+{
+    setText(text);
+}
+
+int PassageModel::setText(const QString &newText)
+{
+    if (newText.isSharedWith(text)) {
+        return getClusterCount();
+    }
+
+    // Clusters before the last one the common prefix touches stay; that one may have grown
+    const QChar *oldData = text.constData();
+    const QChar *newData = newText.constData();
+    const int limit = qMin(text.length(), newText.length());
+    int prefix = 0;
+    while (prefix < limit && oldData[prefix] == newData[prefix]) {
+        ++prefix;
+    }
+    const int keep = prefix > 0 ? clusterAt(prefix - 1) : 0;
+
+    text = newText;
+    resegment(keep, prefix);
+    return keep;
+}
+
+int PassageModel::replaceFrom(int position, const QString &tail)
+{
+    position = qBound(0, position, text.length());
+    const QChar *oldData = text.constData() + position;
+    const QChar *newData = tail.constData();
+    const int limit = qMin(text.length() - position, tail.length());
+    int prefix = 0;
+    while (prefix < limit && oldData[prefix] == newData[prefix]) {
+        ++prefix;
+    }
+    const int changed = position + prefix;
+    if (prefix == tail.length() && changed == text.length()) {
+        return getClusterCount();
+    }
+
+    // Truncating and appending reuse the text's buffer, so this never copies the kept front
+    const int keep = changed > 0 ? clusterAt(changed - 1) : 0;
+    text.truncate(changed);
+    text.append(newData + prefix, tail.length() - prefix);
+    resegment(keep, changed);
+    return keep;
+}
+
+const QString &PassageModel::getText() const
+{
+    return text;
+}
+
+void PassageModel::clear()
+{
+    text.clear();
+    boundaries.clear();
+    ascii = true;
+}
+
+bool PassageModel::isEmpty() const
+{
+    return text.isEmpty();
+}
+
+bool PassageModel::isAscii() const
+{
+    return ascii;
+}
+
+int PassageModel::getClusterCount() const
+{
+    return ascii ? text.length() : boundaries.size() - 1;
+}
+
+int PassageModel::getClusterStart(int cluster) const
+{
+    return ascii ? cluster : boundaries[cluster];
+}
+
+int PassageModel::getClusterEnd(int cluster) const
+{
+    return ascii ? cluster + 1 : boundaries[cluster + 1];
+}
+
+int PassageModel::getClusterLength(int cluster) const
+{
+    return ascii ? 1 : boundaries[cluster + 1] - boundaries[cluster];
+}
+
+int PassageModel::clusterAt(int position) const
+{
+    if (position >= text.length()) {
+        return getClusterCount();
+    }
+    if (ascii) {
+        return qMax(0, position);
+    }
+    return static_cast<int>(std::upper_bound(boundaries.constBegin(), boundaries.constEnd(), position)
+                            - boundaries.constBegin()) - 1;
+}
+
+void PassageModel::append(const QString &more)
+{
+    if (more.isEmpty()) {
+        return;
+    }
+
+    const int length = text.length();
+    const int keep = length > 0 ? clusterAt(length - 1) : 0;
+    text += more;
+    resegment(keep, length);
+}
+
+void PassageModel::removeClusters(int count)
+{
+    count = qBound(0, count, getClusterCount());
+    if (ascii) {
+        text.remove(0, count);
+        return;
+    }
+
+    const int removed = boundaries[count];
+    text.remove(0, removed);
+    boundaries.remove(0, count);
+    for (int &boundary : boundaries) {
+        boundary -= removed;
+    }
+}
+
+bool PassageModel::clusterEquals(const PassageModel &a, int clusterA, const PassageModel &b, int clusterB)
+{
+    if (a.ascii && b.ascii) {
+        return a.text[clusterA] == b.text[clusterB];
+    }
+
+    const int lengthA = a.getClusterLength(clusterA);
+    const int lengthB = b.getClusterLength(clusterB);
+    const QChar *dataA = a.text.constData() + a.getClusterStart(clusterA);
+    const QChar *dataB = b.text.constData() + b.getClusterStart(clusterB);
+    if (lengthA == lengthB && std::equal(dataA, dataA + lengthA, dataB)) {
+        return true;
+    }
+    if (lengthA == 1 && lengthB == 1) {
+        return false;
+    }
+
+    // An input method may compose "é" where the passage has "e" plus a combining accent
+    return QString::fromRawData(dataA, lengthA).normalized(QString::NormalizationForm_C)
+        == QString::fromRawData(dataB, lengthB).normalized(QString::NormalizationForm_C);
+}
+
+bool PassageModel::clusterStartsWith(const PassageModel &a, int clusterA, const PassageModel &prefix, int clusterPrefix)
+{
+    const int length = prefix.getClusterLength(clusterPrefix);
+    const QChar *dataA = a.text.constData() + a.getClusterStart(clusterA);
+    const QChar *dataPrefix = prefix.text.constData() + prefix.getClusterStart(clusterPrefix);
+    return length < a.getClusterLength(clusterA) && std::equal(dataPrefix, dataPrefix + length, dataA);
+}
+
+bool PassageModel::isAsciiRun(const QChar *text, int length)
+{
+    // CR LF is one cluster, so CR leaves the fast path
+    for (int i = 0; i < length; ++i) {
+        const ushort unit = text[i].unicode();
+        if (unit >= 0x80 || unit == '\r') {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PassageModel::resegment(int keep, int changedFrom)
+{
+    if (ascii && isAsciiRun(text.constData() + changedFrom, text.length() - changedFrom)) {
+        return;
+    }
+
+    if (ascii) {
+        // Leaving the fast path: the kept ASCII clusters become table entries
+        boundaries.resize(keep + 1);
+        for (int cluster = 0; cluster <= keep; ++cluster) {
+            boundaries[cluster] = cluster;
+        }
+        ascii = false;
+    }
+
+    // Segmentation restarts at a known boundary, so it needs no context from before it
+    const int start = boundaries[keep];
+    boundaries.resize(keep + 1);
+    QTextBoundaryFinder finder(QTextBoundaryFinder::Grapheme, text.constData() + start, text.length() - start);
+    for (int boundary = finder.toNextBoundary(); boundary > 0; boundary = finder.toNextBoundary()) {
+        boundaries.append(start + boundary);
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * Typing Speed Test - Passage Model
+ *
+ * Text split into grapheme clusters, the unit a reader sees as one
+ * character: a letter with its combining marks, a surrogate pair, or a
+ * whole emoji sequence. Boundaries are found once with QTextBoundaryFinder
+ * and kept as an offset array; changing the text re-segments only what
+ * follows the common prefix, so typed input costs one cluster per keystroke.
+ * Pure ASCII text is one cluster per code unit and keeps no table at all.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef PASSAGEMODEL_H
+#define PASSAGEMODEL_H
+
+#include <QString>
+#include <QVector>
+
+class PassageModel
+{
+public:
+    PassageModel();
+    explicit PassageModel(const QString &text);
+
+    int setText(const QString &text); // Returns the first cluster that may differ from before
+    // Keeps the text before a code unit on a cluster boundary and replaces the rest; scans only the
+    // replaced part, so input whose front is kept elsewhere costs its own length, not the whole text's
+    int replaceFrom(int position, const QString &tail);
+    const QString &getText() const;
+    void clear();
+    bool isEmpty() const;
+    bool isAscii() const; // One cluster per code unit; no boundary table is kept
+
+    int getClusterCount() const;
+    int getClusterStart(int cluster) const; // The text length for getClusterCount()
+    int getClusterEnd(int cluster) const;
+    int getClusterLength(int cluster) const;
+    int clusterAt(int position) const; // Cluster holding a code unit; the count past the end
+
+    void append(const QString &text);
+    void removeClusters(int count); // From the front
+
+    // Same cluster, or canonically equivalent (precomposed against combining marks)
+    static bool clusterEquals(const PassageModel &a, int clusterA, const PassageModel &b, int clusterB);
+    // The cluster of a is longer and starts with the one of prefix, as while an input method composes it
+    static bool clusterStartsWith(const PassageModel &a, int clusterA, const PassageModel &prefix, int clusterPrefix);
+
+private:
+    static bool isAsciiRun(const QChar *text, int length);
+    // Redoes clusters from keep on, after the text changed from code unit changedFrom
+    void resegment(int keep, int changedFrom);
+
+    QString text;
+    QVector<int> boundaries; // Start of every cluster, then the text length; empty while ascii
+    bool ascii;
+};
+
+#endif // PASSAGEMODEL_H
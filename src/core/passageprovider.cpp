@@ -0,0 +1,384 @@
+/**
+ * Typing Speed Test - Passage Provider Implementation
+ *
+ * Keeps a few pre-generated passages queued for each recently used test
+ * configuration and refills them on a background thread, so starting or
+ * resetting a test is a constant-time pop instead of a generation pass.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "passageprovider.h"
+#include "typingtest.h"
+#include "sentencescorer.h"
+#include "lessondata.h"
+#include <QThread>
+#include <QMutexLocker>
+
+static_assert(LessonData::SENTENCE_SET_COUNT == TypingTest::HARD + 1, "data/sentences.def needs one section per difficulty");
+static_assert(LessonData::SENTENCE_SETS[TypingTest::EASY].id == "EASY", "data/sentences.def sections are out of order");
+static_assert(LessonData::SENTENCE_SETS[TypingTest::MEDIUM].id == "MEDIUM", "data/sentences.def sections are out of order");
+static_assert(LessonData::SENTENCE_SETS[TypingTest::HARD].id == "HARD", "data/sentences.def sections are out of order");
+
+quint32 PassageRequest::key() const
+{
+    if (lessonMode) {
+        return 0x80000000u | (static_cast<quint32>(keyboardLayout) << 16) | (static_cast<quint32>(lessonType) << 8)
+             | static_cast<quint32>(lessonLevel);
+    }
+    if (code) {
+        return 0x20000000u | (static_cast<quint32>(language) << 8) | static_cast<quint32>(difficulty);
+    }
+    // Layouts of the same language share passages
+    return static_cast<quint32>(difficulty) | static_cast<quint32>(scoreStep + 1) << 8
+         | static_cast<quint32>(KeyboardLayout::getLanguage(keyboardLayout)) << 16 | (generated ? 0x40000000u : 0u);
+}
+
+QString PassageRequest::toString() const
+{
+    return QString("lesson=%1;generated=%2;code=%3;language=%4;difficulty=%5;score=%6;type=%7;level=%8;layout=%9")
+        .arg(lessonMode ? 1 : 0)
+        .arg(generated ? 1 : 0)
+        .arg(code ? 1 : 0)
+        .arg(language)
+        .arg(difficulty)
+        .arg(scoreStep)
+        .arg(static_cast<int>(lessonType))
+        .arg(lessonLevel)
+        .arg(static_cast<int>(keyboardLayout));
+}
+
+PassageRequest PassageRequest::fromString(const QString &text)
+{
+    PassageRequest request;
+    for (const QString &field : text.split(QLatin1Char(';'))) {
+        const int separator = field.indexOf(QLatin1Char('='));
+        bool ok = false;
+        const int value = field.mid(separator + 1).toInt(&ok);
+        if (separator < 0 || !ok) {
+            continue;
+        }
+
+        const QString name = field.left(separator);
+        if (name == "lesson") {
+            request.lessonMode = value != 0;
+        } else if (name == "generated") {
+            request.generated = value != 0;
+        } else if (name == "code") {
+            request.code = value != 0;
+        } else if (name == "language") {
+            request.language = value;
+        } else if (name == "difficulty") {
+            request.difficulty = qBound(0, value, 2);
+        } else if (name == "score") {
+            request.scoreStep = qBound(-1, value, SCORE_STEPS);
+        } else if (name == "type") {
+            request.lessonType = static_cast<LessonManager::LessonType>(qBound(0, value, static_cast<int>(LessonManager::WEAK_NGRAMS)));
+        } else if (name == "level") {
+            request.lessonLevel = qBound(1, value, 5);
+        } else if (name == "layout" && value >= 0 && value < KeyboardLayout::LAYOUT_COUNT) {
+            request.keyboardLayout = static_cast<KeyboardLayout::Layout>(value);
+        }
+    }
+    return request;
+}
+
+PassageProvider::PassageProvider(QObject *parent)
+    : QObject(parent)
+    , inlineLessons(new LessonManager(this))
+    , weakNgramGeneration(0)
+    , inlineSeeds(SessionRandom::systemSeed())
+    , stopping(false)
+    , refillThread(nullptr)
+{
+    // Corpora are mapped per language when first asked for
+    const QString modelPath = MarkovModel::getDefaultPath();
+    if (!modelPath.isEmpty()) {
+        model.open(modelPath);
+    }
+    const QString snippetPath = SnippetIndex::getDefaultPath();
+    if (!snippetPath.isEmpty()) {
+        snippets.open(snippetPath);
+    }
+    
+    refillThread = QThread::create([this]() {
+        refillLoop();
+    });
+    refillThread->setObjectName("PassageRefill");
+    refillThread->start(QThread::LowPriority);
+}
+
+PassageProvider::~PassageProvider()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        refillNeeded.wakeAll();
+    }
+    refillThread->wait();
+    delete refillThread;
+}
+
+QString PassageProvider::takePassage(const PassageRequest &request, quint64 &seed)
+{
+    const quint32 key = request.key();
+    {
+        QMutexLocker locker(&mutex);
+        touch(request);
+        QQueue<QueuedPassage> &queue = queues[key];
+        if (!queue.isEmpty()) {
+            const QueuedPassage passage = queue.dequeue();
+            refillNeeded.wakeOne();
+            seed = passage.seed;
+            return passage.text;
+        }
+        refillNeeded.wakeOne();
+    }
+    
+    // Only the first request for a configuration normally gets here
+    seed = inlineSeeds.generate64();
+    return generatePassage(request, seed);
+}
+
+QString PassageProvider::generatePassage(const PassageRequest &request, quint64 seed)
+{
+    return generatePassage(request, *inlineLessons, seed);
+}
+
+void PassageProvider::prefetch(const PassageRequest &request)
+{
+    QMutexLocker locker(&mutex);
+    touch(request);
+    refillNeeded.wakeOne();
+}
+
+void PassageProvider::touch(const PassageRequest &request)
+{
+    const quint32 key = request.key();
+    recentKeys.removeOne(key);
+    recentKeys.prepend(key);
+    requests.insert(key, request);
+    
+    while (recentKeys.size() > MAX_CONFIGURATIONS) {
+        const quint32 evicted = recentKeys.takeLast();
+        queues.remove(evicted);
+        requests.remove(evicted);
+    }
+}
+
+void PassageProvider::refillLoop()
+{
+    LessonManager lessons; // Owned by this thread
+    SessionRandom seeds(SessionRandom::systemSeed());
+    
+    QMutexLocker locker(&mutex);
+    while (!stopping) {
+        // Most recently used configuration that is short of passages
+        bool found = false;
+        PassageRequest request;
+        for (quint32 key : recentKeys) {
+            if (queues.value(key).size() < QUEUE_DEPTH) {
+                request = requests.value(key);
+                found = true;
+                break;
+            }
+        }
+        
+        if (!found) {
+            refillNeeded.wait(&mutex);
+            continue;
+        }
+        
+        locker.unlock();
+        const quint64 seed = seeds.generate64();
+        quint64 weightsGeneration = 0;
+        const QueuedPassage passage = {generatePassage(request, lessons, seed, &weightsGeneration), seed};
+        locker.relock();
+        
+        // A drill built from weights that were replaced meanwhile would outlive setWeakNgrams() dropping the queue
+        if (request.lessonMode && request.lessonType == LessonManager::WEAK_NGRAMS) {
+            QMutexLocker weightsLocker(&weakNgramMutex);
+            if (weightsGeneration != weakNgramGeneration) {
+                continue;
+            }
+        }
+        
+        // The configuration may have been evicted while we generated
+        const quint32 key = request.key();
+        if (requests.contains(key) && queues[key].size() < QUEUE_DEPTH) {
+            queues[key].enqueue(passage);
+        }
+    }
+}
+
+QString PassageProvider::generatePassage(const PassageRequest &request, LessonManager &lessons, quint64 seed,
+                                         quint64 *weightsGeneration) const
+{
+    QString passage;
+    lessons.setSeed(seed);
+    lessons.setKeyboardLayout(request.keyboardLayout);
+    
+    if (request.lessonMode && request.lessonType == LessonManager::WEAK_NGRAMS) {
+        QHash<QString, float> weights;
+        {
+            QMutexLocker locker(&weakNgramMutex);
+            weights = weakNgrams;
+            if (weightsGeneration) {
+                *weightsGeneration = weakNgramGeneration;
+            }
+        }
+        if (!weights.isEmpty()) {
+            return lessons.generateNgramDrill(getCorpus(request).ngramIndex, weights, 100 + request.lessonLevel * 30);
+        }
+    }
+    
+    if (request.lessonMode && request.lessonLevel >= KEY_WORD_LEVEL) {
+        // Empty for lessons other than rows and fingers, or when too few words fit the keys
+        passage = lessons.generateKeyWordDrill(&getCorpus(request).corpus, request.lessonType, request.lessonLevel,
+                                               60 + request.lessonLevel * 20);
+        if (!passage.isEmpty()) {
+            return passage;
+        }
+    }
+    
+    if (request.lessonMode) {
+        // Generate lesson-specific text
+        passage = lessons.getProgressiveLesson(request.lessonType, request.lessonLevel);
+        
+        // Ensure minimum length for lessons
+        if (passage.length() < 50) {
+            passage = lessons.getLessonText(request.lessonType, 100);
+        }
+        return passage;
+    }
+    
+    // One generator per call keeps sampling lock-free on both threads
+    SessionRandom random(seed);
+    if (request.code) {
+        // One whole function per passage, never trimmed
+        const QString snippet = getSnippet(request, random);
+        return snippet.isEmpty() ? lessons.getLessonText(LessonManager::PROGRAMMING, 100) : snippet;
+    }
+    
+    const bool generate = request.generated && model.isOpen();
+    
+    // Standard test mode - generate about 200-300 characters of text
+    while (passage.length() < 200) {
+        if (!passage.isEmpty()) {
+            passage += " ";
+        }
+        passage += generate ? getGeneratedSentence(request, random) : getRandomSentence(request, random);
+    }
+    
+    // Trim to a reasonable length
+    if (passage.length() > 250) {
+        int lastSpace = passage.lastIndexOf(' ', 250);
+        if (lastSpace > 0) {
+            passage = passage.left(lastSpace);
+        }
+    }
+    return passage;
+}
+
+const PassageProvider::LanguageCorpus &PassageProvider::getCorpus(const PassageRequest &request) const
+{
+    const KeyboardLayout::Language language = KeyboardLayout::getLanguage(request.keyboardLayout);
+    QMutexLocker locker(&corpusMutex);
+    LanguageCorpus &entry = corpora[language];
+    if (!entry.loaded) {
+        // Only maps the file; sentences are paged in as they are sampled
+        entry.loaded = true;
+        const QString path = Corpus::getDefaultPath(KeyboardLayout::getLanguageCode(language));
+        if (!path.isEmpty() && entry.corpus.open(path)) {
+            entry.ngramIndex.attach(entry.corpus);
+        }
+    }
+    return entry;
+}
+
+QString PassageProvider::getRandomSentence(const PassageRequest &request, SessionRandom &random) const
+{
+    const Corpus &corpus = getCorpus(request).corpus;
+    int difficulty = request.difficulty;
+    if (request.scoreStep >= 0) {
+        // Widen the window around the target until it catches something, for sparse score ranges
+        const float target = static_cast<float>(request.scoreStep) / PassageRequest::SCORE_STEPS;
+        if (corpus.hasScores()) {
+            for (float radius = 0.5f / PassageRequest::SCORE_STEPS; radius < 2.0f; radius *= 2.0f) {
+                const QString sentence = corpus.getRandomSentenceInRange(target - radius, target + radius, random);
+                if (!sentence.isEmpty()) {
+                    return sentence;
+                }
+            }
+        }
+        difficulty = SentenceScorer::difficultyFor(target);
+    }
+    
+    if (corpus.getSentenceCount(difficulty) > 0) {
+        return corpus.getRandomSentence(difficulty, random);
+    }
+    
+    // Built-in sentences are constexpr tables generated from data/sentences.def
+    const LessonData::SentenceSet &sentences = LessonData::SENTENCE_SETS[qBound(0, difficulty, LessonData::SENTENCE_SET_COUNT - 1)];
+    const std::string_view sentence = sentences.sentences[random.bounded(sentences.count)];
+    return QString::fromUtf8(sentence.data(), static_cast<int>(sentence.size()));
+}
+
+QString PassageProvider::getGeneratedSentence(const PassageRequest &request, SessionRandom &random) const
+{
+    // Rejection sampling against the scorer; a draw and a score take microseconds
+    const float target = static_cast<float>(request.scoreStep) / PassageRequest::SCORE_STEPS;
+    QByteArray sentence;
+    for (int attempt = 0; attempt < GENERATION_ATTEMPTS; ++attempt) {
+        sentence = model.generateSentenceUtf8(random);
+        const float score = SentenceScorer::score(sentence);
+        const bool matches = request.scoreStep >= 0
+            ? qAbs(score - target) <= 2.0f / PassageRequest::SCORE_STEPS
+            : SentenceScorer::difficultyFor(score) == request.difficulty;
+        if (matches) {
+            break;
+        }
+    }
+    return sentence.isEmpty() ? getRandomSentence(request, random) : QString::fromUtf8(sentence);
+}
+
+QString PassageProvider::getSnippet(const PassageRequest &request, SessionRandom &random) const
+{
+    // The length the difficulty asks for, else the nearest length that has snippets
+    for (int distance = 0; distance < SnippetIndex::LENGTH_COUNT; ++distance) {
+        for (int length : {request.difficulty - distance, request.difficulty + distance}) {
+            if (snippets.getSnippetCount(request.language, length) > 0) {
+                return snippets.getRandomSnippet(request.language, length, random);
+            }
+        }
+    }
+    return QString();
+}
+
+bool PassageProvider::hasModel() const
+{
+    return model.isOpen();
+}
+
+quint32 PassageProvider::getSnippetCount(int language) const
+{
+    return snippets.getSnippetCount(language);
+}
+
+void PassageProvider::setWeakNgrams(const QHash<QString, float> &weights)
+{
+    {
+        QMutexLocker locker(&weakNgramMutex);
+        weakNgrams = weights;
+        ++weakNgramGeneration;
+    }
+    
+    QMutexLocker locker(&mutex);
+    for (auto it = requests.constBegin(); it != requests.constEnd(); ++it) {
+        if (it.value().lessonMode && it.value().lessonType == LessonManager::WEAK_NGRAMS) {
+            queues.remove(it.key());
+        }
+    }
+    refillNeeded.wakeOne();
+}
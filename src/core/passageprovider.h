@@ -0,0 +1,133 @@
+/**
+ * Typing Speed Test - Passage Provider
+ *
+ * Keeps a few pre-generated passages queued for each recently used test
+ * configuration and refills them on a background thread, so starting or
+ * resetting a test is a constant-time pop instead of a generation pass.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef PASSAGEPROVIDER_H
+#define PASSAGEPROVIDER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QQueue>
+#include <QStringList>
+#include <QWaitCondition>
+#include "../managers/lessonmanager.h"
+#include "corpus.h"
+#include "keyboardlayout.h"
+#include "markovmodel.h"
+#include "ngramindex.h"
+#include "snippetindex.h"
+
+class QThread;
+
+// What a passage is generated for; lesson fields are ignored in standard mode and vice versa
+struct PassageRequest {
+    static const int SCORE_STEPS = 20; // Target scores are rounded to 1/SCORE_STEPS so queues can be shared
+
+    bool lessonMode;
+    bool generated; // Fresh sentences from the Markov model instead of corpus sentences
+    bool code;      // A source code snippet; the difficulty picks its length
+    int language;   // SnippetIndex::Language, for code
+    int difficulty; // TypingTest::DifficultyLevel
+    int scoreStep;  // Target score * SCORE_STEPS, or -1 for any sentence of the difficulty
+    LessonManager::LessonType lessonType;
+    int lessonLevel;
+    KeyboardLayout::Layout keyboardLayout; // Keys of row and finger lessons; its language picks the corpus
+
+    PassageRequest()
+        : lessonMode(false), generated(false), code(false), language(SnippetIndex::CPP), difficulty(1), scoreStep(-1)
+        , lessonType(LessonManager::HOME_ROW), lessonLevel(1), keyboardLayout(KeyboardLayout::QWERTY) {}
+    quint32 key() const;
+
+    // "field=value;..." text stored with a result; fields missing from the text keep their defaults
+    QString toString() const;
+    static PassageRequest fromString(const QString &text);
+};
+
+class PassageProvider : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int QUEUE_DEPTH = 3;       // Passages kept ready per configuration
+    static const int MAX_CONFIGURATIONS = 8; // Least recently used queues beyond this are dropped
+    static const int GENERATION_ATTEMPTS = 8; // Generated sentences tried per slot to match the difficulty
+    static const int KEY_WORD_LEVEL = 3;      // Row and finger lessons type real words from this level on
+
+    explicit PassageProvider(QObject *parent = nullptr);
+    ~PassageProvider();
+
+    // Pops a ready passage, or generates one inline if the queue ran dry; never waits on the worker.
+    // seed receives the value that regenerates the passage through generatePassage()
+    QString takePassage(const PassageRequest &request, quint64 &seed);
+    // Starts filling the queue for a configuration that is likely to be used soon
+    void prefetch(const PassageRequest &request);
+
+    // Same request and seed give the same passage (for a given corpus, model and weak n-grams); UI thread
+    QString generatePassage(const PassageRequest &request, quint64 seed);
+    // Generation, usable from any thread with a LessonManager owned by that thread.
+    // weightsGeneration receives the setWeakNgrams() generation a WEAK_NGRAMS drill was built from
+    QString generatePassage(const PassageRequest &request, LessonManager &lessons, quint64 seed,
+                            quint64 *weightsGeneration = nullptr) const;
+    
+    // Whether generated requests get Markov text rather than corpus sentences
+    bool hasModel() const;
+    // Indexed snippets of a language; code requests for a language without any get lesson text
+    quint32 getSnippetCount(int language) const;
+    
+    // Weighted bigrams/trigrams the WEAK_NGRAMS lesson drills; drops passages queued for older weights
+    void setWeakNgrams(const QHash<QString, float> &weights);
+
+private:
+    struct LanguageCorpus {
+        Corpus corpus;
+        NgramIndex ngramIndex;
+        bool loaded; // Opening was attempted; never reset
+
+        LanguageCorpus() : loaded(false) {}
+    };
+    // Maps a language's corpus on first use, from either thread
+    const LanguageCorpus &getCorpus(const PassageRequest &request) const;
+    QString getRandomSentence(const PassageRequest &request, SessionRandom &random) const;
+    QString getGeneratedSentence(const PassageRequest &request, SessionRandom &random) const;
+    QString getSnippet(const PassageRequest &request, SessionRandom &random) const;
+    void touch(const PassageRequest &request); // Caller holds mutex
+    void refillLoop();
+
+    // Read-only after construction, shared by both threads
+    MarkovModel model;
+    SnippetIndex snippets;
+    
+    // Read-only once loaded; a corpus is preferred over the built-in sentences when installed
+    mutable QMutex corpusMutex;
+    mutable LanguageCorpus corpora[KeyboardLayout::LANGUAGE_COUNT];
+    
+    mutable QMutex weakNgramMutex;
+    QHash<QString, float> weakNgrams;
+    quint64 weakNgramGeneration; // Bumped by every setWeakNgrams()
+
+    LessonManager *inlineLessons; // UI thread only, for inline generation
+    SessionRandom inlineSeeds;    // UI thread only, seeds passages generated inline
+
+    QMutex mutex;
+    QWaitCondition refillNeeded;
+    struct QueuedPassage {
+        QString text;
+        quint64 seed;
+    };
+    QHash<quint32, QQueue<QueuedPassage>> queues;
+    QHash<quint32, PassageRequest> requests;
+    QList<quint32> recentKeys; // Most recently used first
+    bool stopping;
+    QThread *refillThread;
+};
+
+#endif // PASSAGEPROVIDER_H
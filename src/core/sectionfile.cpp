@@ -0,0 +1,178 @@
+/**
+ * Typing Speed Test - Section File Implementation
+ *
+ * The container shared by the corpus, Markov model and snippet index: a
+ * header naming the format, a directory of sections, and the sections
+ * themselves. SectionFileReader memory maps a file and finds sections by
+ * id in place; SectionFileWriter lays out and writes one.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "sectionfile.h"
+#include <QSaveFile>
+#include <QtEndian>
+#include <QDebug>
+
+SectionFileReader::SectionFileReader()
+    : data(nullptr)
+    , dataSize(0)
+{
+}
+
+SectionFileReader::~SectionFileReader()
+{
+    close();
+}
+
+bool SectionFileReader::open(const QString &path, quint32 magic, quint16 version, const char *format)
+{
+    close();
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open" << format << path;
+        return false;
+    }
+
+    dataSize = file.size();
+    data = dataSize >= HEADER_SIZE ? file.map(0, dataSize) : nullptr;
+    if (!data || qFromLittleEndian<quint32>(data) != magic
+        || qFromLittleEndian<quint16>(data + 4) != version) {
+        qDebug() << "Not a version" << version << format << "file:" << path;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SectionFileReader::close()
+{
+    if (data) {
+        file.unmap(const_cast<uchar *>(data));
+    }
+    file.close();
+
+    data = nullptr;
+    dataSize = 0;
+}
+
+bool SectionFileReader::isOpen() const
+{
+    return data != nullptr;
+}
+
+const uchar *SectionFileReader::findSection(quint32 id, quint64 &size) const
+{
+    if (!data) {
+        return nullptr;
+    }
+
+    const int sectionCount = qFromLittleEndian<quint16>(data + 6);
+    if (HEADER_SIZE + static_cast<qint64>(sectionCount) * SECTION_ENTRY_SIZE > dataSize) {
+        return nullptr;
+    }
+
+    for (int i = 0; i < sectionCount; ++i) {
+        const uchar *entry = data + HEADER_SIZE + i * SECTION_ENTRY_SIZE;
+        if (qFromLittleEndian<quint32>(entry) != id) {
+            continue;
+        }
+
+        const quint64 offset = qFromLittleEndian<quint64>(entry + 8);
+        size = qFromLittleEndian<quint64>(entry + 16);
+        if (offset > static_cast<quint64>(dataSize) || size > static_cast<quint64>(dataSize) - offset) {
+            return nullptr;
+        }
+        return data + offset;
+    }
+    return nullptr;
+}
+
+SectionFileWriter::SectionFileWriter(quint32 fileMagic, quint16 fileVersion)
+    : magic(fileMagic)
+    , version(fileVersion)
+{
+}
+
+void SectionFileWriter::addSection(quint32 id, quint64 size)
+{
+    sections.append({id, size, nullptr});
+}
+
+void SectionFileWriter::addSection(quint32 id, const QByteArray &data)
+{
+    sections.append({id, static_cast<quint64>(data.size()), &data});
+}
+
+quint64 SectionFileWriter::firstSectionOffset() const
+{
+    return alignTo8(SectionFileReader::HEADER_SIZE
+                    + static_cast<quint64>(sections.size()) * SectionFileReader::SECTION_ENTRY_SIZE);
+}
+
+bool SectionFileWriter::writeHeader(QIODevice &device) const
+{
+    bool ok = writeLittleEndian(device, magic, 4)
+           && writeLittleEndian(device, version, 2)
+           && writeLittleEndian(device, static_cast<quint64>(sections.size()), 2)
+           && writeLittleEndian(device, 0, 4);
+
+    quint64 position = firstSectionOffset();
+    for (const Section &section : sections) {
+        ok = ok && writeLittleEndian(device, section.id, 4)
+                && writeLittleEndian(device, 0, 4)
+                && writeLittleEndian(device, position, 8)
+                && writeLittleEndian(device, section.size, 8);
+        position = alignTo8(position + section.size);
+    }
+    return ok && writePadding(device, device.pos());
+}
+
+bool SectionFileWriter::writePadding(QIODevice &device, quint64 position)
+{
+    const int padding = static_cast<int>(alignTo8(position) - position);
+    return padding == 0 || device.write(QByteArray(padding, '\0')) == padding;
+}
+
+bool SectionFileWriter::writeFile(const QString &path, const char *format) const
+{
+    QSaveFile output(path);
+    if (!output.open(QIODevice::WriteOnly)) {
+        qDebug() << "Cannot write" << format << path;
+        return false;
+    }
+
+    bool ok = writeHeader(output);
+    for (const Section &section : sections) {
+        ok = ok && section.data && output.write(*section.data) == section.data->size()
+                && writePadding(output, output.pos());
+    }
+
+    if (!ok) {
+        qDebug() << "Failed writing" << format << path;
+        output.cancelWriting();
+        return false;
+    }
+    return output.commit();
+}
+
+quint64 SectionFileWriter::alignTo8(quint64 value)
+{
+    return (value + 7) & ~quint64(7);
+}
+
+bool SectionFileWriter::writeLittleEndian(QIODevice &device, quint64 value, int bytes)
+{
+    uchar buffer[8];
+    qToLittleEndian<quint64>(value, buffer);
+    return device.write(reinterpret_cast<const char *>(buffer), bytes) == bytes;
+}
+
+void SectionFileWriter::appendLittleEndian(QByteArray &buffer, quint64 value, int bytes)
+{
+    uchar encoded[8];
+    qToLittleEndian<quint64>(value, encoded);
+    buffer.append(reinterpret_cast<const char *>(encoded), bytes);
+}
@@ -0,0 +1,88 @@
+/**
+ * Typing Speed Test - Section File
+ *
+ * The container shared by the corpus, Markov model and snippet index: a
+ * header naming the format, a directory of sections, and the sections
+ * themselves. SectionFileReader memory maps a file and finds sections by
+ * id in place; SectionFileWriter lays out and writes one.
+ *
+ * File layout (little-endian, sections 8-byte aligned):
+ *   header     magic, u16 version, u16 section count, u32 reserved
+ *   directory  per section: u32 id, u32 reserved, u64 offset, u64 size
+ *   sections   at their offsets, each padded to a multiple of 8 bytes
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef SECTIONFILE_H
+#define SECTIONFILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+class SectionFileReader
+{
+public:
+    static const int HEADER_SIZE = 12;
+    static const int SECTION_ENTRY_SIZE = 24;
+
+    SectionFileReader();
+    ~SectionFileReader();
+
+    // Maps the file and checks its magic and version; format names the file in messages
+    bool open(const QString &path, quint32 magic, quint16 version, const char *format);
+    void close();
+    bool isOpen() const;
+
+    // Points into the mapping; null if the section is absent or runs past the file
+    const uchar *findSection(quint32 id, quint64 &size) const;
+
+private:
+    Q_DISABLE_COPY(SectionFileReader)
+
+    QFile file;
+    const uchar *data;
+    qint64 dataSize;
+};
+
+class SectionFileWriter
+{
+public:
+    SectionFileWriter(quint32 fileMagic, quint16 fileVersion);
+
+    // Sections are laid out in the order they are added
+    void addSection(quint32 id, quint64 size);
+    void addSection(quint32 id, const QByteArray &data); // Kept by pointer until writeFile()
+
+    // Streaming: the header and directory, padded to the first section. The caller then writes
+    // each section's bytes in order, followed by writePadding()
+    bool writeHeader(QIODevice &device) const;
+    static bool writePadding(QIODevice &device, quint64 position);
+
+    // Every section held in memory; written atomically, nothing exists at path before it succeeds
+    bool writeFile(const QString &path, const char *format) const;
+
+    static quint64 alignTo8(quint64 value);
+    static bool writeLittleEndian(QIODevice &device, quint64 value, int bytes);
+    static void appendLittleEndian(QByteArray &buffer, quint64 value, int bytes);
+
+private:
+    struct Section {
+        quint32 id;
+        quint64 size;
+        const QByteArray *data;
+    };
+
+    quint64 firstSectionOffset() const;
+
+    quint32 magic;
+    quint16 version;
+    QVector<Section> sections;
+};
+
+#endif // SECTIONFILE_H
@@ -0,0 +1,123 @@
+/**
+ * Typing Speed Test - Sentence Scorer Implementation
+ *
+ * Estimates how hard a sentence is to type from its average word length,
+ * the share of characters outside the lowercase home alphabet and the share
+ * of letter pairs that are rare in English, and maps the score onto the
+ * EASY/MEDIUM/HARD difficulty levels.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "sentencescorer.h"
+#include <QtGlobal>
+
+namespace {
+
+// The most frequent letter pairs in English text, roughly 70% of all pairs
+const char COMMON_BIGRAMS[] =
+    "th he in er an re on at en nd ti es or te of ed is it al ar st to nt ng se ha as ou io le ve "
+    "co me de hi ri ro ic ne ea ra ce li ch ll be ma si om ur ca el ta la ns di fo ho pe ec pr no";
+
+// 26x26 lookup built once from COMMON_BIGRAMS
+struct BigramTable {
+    bool common[26][26];
+
+    BigramTable()
+    {
+        for (int first = 0; first < 26; ++first) {
+            for (int second = 0; second < 26; ++second) {
+                common[first][second] = false;
+            }
+        }
+        for (size_t i = 0; i + 1 < sizeof(COMMON_BIGRAMS); i += 3) {
+            common[COMMON_BIGRAMS[i] - 'a'][COMMON_BIGRAMS[i + 1] - 'a'] = true;
+        }
+    }
+};
+
+const float WORD_LENGTH_WEIGHT = 0.45f;
+const float RARE_CHARACTER_WEIGHT = 0.25f;
+const float RARE_BIGRAM_WEIGHT = 0.30f;
+
+}
+
+float SentenceScorer::score(const QByteArray &utf8)
+{
+    static const BigramTable bigrams;
+
+    int letters = 0;
+    int words = 0;
+    int characters = 0;
+    int rareCharacters = 0;
+    int pairs = 0;
+    int rarePairs = 0;
+    int previousLetter = -1;
+
+    for (int i = 0; i < utf8.size(); ++i) {
+        const uchar byte = static_cast<uchar>(utf8[i]);
+        if ((byte & 0xC0) == 0x80) {
+            continue; // UTF-8 continuation byte; the lead byte already counted the character
+        }
+        ++characters;
+
+        int letter = -1;
+        if (byte >= 'a' && byte <= 'z') {
+            letter = byte - 'a';
+        } else if (byte >= 'A' && byte <= 'Z') {
+            letter = byte - 'A';
+            if (previousLetter >= 0) {
+                ++rareCharacters; // Capitals are only cheap at the start of a word
+            }
+        } else if (byte != ' ' && byte != '.' && byte != ',') {
+            ++rareCharacters; // Digits, symbols, quotes and anything non-ASCII
+        }
+
+        if (letter >= 0) {
+            if (previousLetter < 0) {
+                ++words;
+            } else {
+                ++pairs;
+                if (!bigrams.common[previousLetter][letter]) {
+                    ++rarePairs;
+                }
+            }
+            ++letters;
+        }
+        previousLetter = letter;
+    }
+
+    if (characters == 0 || words == 0) {
+        return 0.0f;
+    }
+
+    // Each component is normalized to 0..1 over the range seen in practice texts
+    const float wordLength = qBound(0.0f, (static_cast<float>(letters) / words - 3.0f) / 4.0f, 1.0f);
+    const float rareCharacterShare = qBound(0.0f, 4.0f * rareCharacters / characters, 1.0f);
+    const float rareBigramShare = pairs > 0 ? qBound(0.0f, 1.5f * rarePairs / pairs, 1.0f) : 0.0f;
+
+    return WORD_LENGTH_WEIGHT * wordLength
+         + RARE_CHARACTER_WEIGHT * rareCharacterShare
+         + RARE_BIGRAM_WEIGHT * rareBigramShare;
+}
+
+int SentenceScorer::difficultyFor(float score)
+{
+    if (score < EASY_MAX) {
+        return EASY;
+    }
+    return score < HARD_MIN ? MEDIUM : HARD;
+}
+
+float SentenceScorer::centerOf(int difficulty)
+{
+    switch (difficulty) {
+        case EASY:
+            return EASY_MAX / 2.0f;
+        case HARD:
+            return (HARD_MIN + 1.0f) / 2.0f;
+        default:
+            return (EASY_MAX + HARD_MIN) / 2.0f;
+    }
+}
@@ -0,0 +1,39 @@
+/**
+ * Typing Speed Test - Sentence Scorer
+ *
+ * Estimates how hard a sentence is to type from its average word length,
+ * the share of characters outside the lowercase home alphabet and the share
+ * of letter pairs that are rare in English, and maps the score onto the
+ * EASY/MEDIUM/HARD difficulty levels.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef SENTENCESCORER_H
+#define SENTENCESCORER_H
+
+#include <QByteArray>
+
+class SentenceScorer
+{
+public:
+    // Difficulty levels, in the order of TypingTest::DifficultyLevel and the corpus's tables
+    enum Difficulty {
+        EASY,
+        MEDIUM,
+        HARD,
+        DIFFICULTY_COUNT
+    };
+
+    // Scores below EASY_MAX are easy, at or above HARD_MIN hard, the rest medium
+    static constexpr float EASY_MAX = 0.25f;
+    static constexpr float HARD_MIN = 0.58f;
+
+    // 0.0 (trivial) to 1.0 (hardest); thread-safe
+    static float score(const QByteArray &utf8);
+    static int difficultyFor(float score); // Difficulty
+    static float centerOf(int difficulty); // Middle of a level's score range
+};
+
+#endif // SENTENCESCORER_H
@@ -0,0 +1,113 @@
+/**
+ * Typing Speed Test - Session Random
+ *
+ * Small seedable generator (xoshiro256**, seeded through splitmix64) for
+ * everything that picks passage text. Each owner keeps its own instance, so
+ * generating on several threads never contends on a shared generator, and a
+ * passage regenerated from its recorded seed comes out identical.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef SESSIONRANDOM_H
+#define SESSIONRANDOM_H
+
+#include <QRandomGenerator>
+#include <QtGlobal>
+
+class SessionRandom
+{
+public:
+    explicit SessionRandom(quint64 seed = 0)
+    {
+        setSeed(seed);
+    }
+
+    // An unpredictable seed for sessions that need not be reproduced
+    static quint64 systemSeed()
+    {
+        return QRandomGenerator::system()->generate64();
+    }
+
+    void setSeed(quint64 value)
+    {
+        seed = value;
+
+        // splitmix64 spreads any seed, including 0, over the whole state
+        quint64 mix = value;
+        for (quint64 &word : state) {
+            mix += 0x9E3779B97F4A7C15ull;
+            quint64 z = mix;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    quint64 getSeed() const
+    {
+        return seed;
+    }
+
+    quint64 generate64()
+    {
+        const quint64 result = rotateLeft(state[1] * 5, 7) * 9;
+        const quint64 shifted = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= shifted;
+        state[3] = rotateLeft(state[3], 45);
+        return result;
+    }
+
+    quint32 generate()
+    {
+        return static_cast<quint32>(generate64() >> 32);
+    }
+
+    // Uniform in [0, bound) without modulo bias (Lemire's multiply-and-reject)
+    quint32 bounded(quint32 bound)
+    {
+        if (bound == 0) {
+            return 0;
+        }
+        quint64 product = static_cast<quint64>(generate()) * bound;
+        if (static_cast<quint32>(product) < bound) {
+            const quint32 threshold = (0u - bound) % bound;
+            while (static_cast<quint32>(product) < threshold) {
+                product = static_cast<quint64>(generate()) * bound;
+            }
+        }
+        return static_cast<quint32>(product >> 32);
+    }
+
+    int bounded(int bound)
+    {
+        return bound > 0 ? static_cast<int>(bounded(static_cast<quint32>(bound))) : 0;
+    }
+
+    qint64 bounded(qint64 bound)
+    {
+        if (bound <= 0) {
+            return 0;
+        }
+        if (bound <= 0xFFFFFFFFll) {
+            return bounded(static_cast<quint32>(bound));
+        }
+        return static_cast<qint64>(generate64() % static_cast<quint64>(bound));
+    }
+
+private:
+    static quint64 rotateLeft(quint64 value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    quint64 seed;
+    quint64 state[4];
+};
+
+#endif // SESSIONRANDOM_H
@@ -0,0 +1,194 @@
+/**
+ * Typing Speed Test - Snippet Index Implementation
+ *
+ * Read-only view of an index of function-sized source code snippets built
+ * by SnippetIndexWriter from a local source tree. The file is memory mapped
+ * like the corpus, and snippets are grouped by language and length, so a
+ * random snippet of a given language and length is one table lookup and
+ * one bounded random index, whatever the size of the indexed tree.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "snippetindex.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QHash>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <QDebug>
+
+SnippetIndex::SnippetIndex()
+    : text(nullptr)
+    , textSize(0)
+    , offsets(nullptr)
+    , totalCount(0)
+{
+    close();
+}
+
+SnippetIndex::~SnippetIndex()
+{
+    close();
+}
+
+bool SnippetIndex::open(const QString &path)
+{
+    close();
+    if (!reader.open(path, MAGIC, VERSION, "snippet index")) {
+        return false;
+    }
+
+    quint64 offsetsSize = 0;
+    quint64 groupsSize = 0;
+    text = reader.findSection(TEXT_SECTION, textSize);
+    offsets = reader.findSection(OFFSETS_SECTION, offsetsSize);
+    const uchar *groups = reader.findSection(GROUPS_SECTION, groupsSize);
+    if (!text || !offsets || offsetsSize < sizeof(quint64)
+        || !groups || groupsSize < static_cast<quint64>(LANGUAGE_COUNT * LENGTH_COUNT * GROUP_SIZE)) {
+        qDebug() << "Incomplete snippet index" << path;
+        close();
+        return false;
+    }
+
+    // Groups or offsets running past their tables mean a truncated or corrupt file
+    totalCount = static_cast<quint32>(offsetsSize / sizeof(quint64) - 1);
+    bool valid = qFromLittleEndian<quint64>(offsets + totalCount * sizeof(quint64)) <= textSize;
+    for (int language = 0; language < LANGUAGE_COUNT; ++language) {
+        for (int length = 0; length < LENGTH_COUNT; ++length) {
+            const uchar *group = groups + (language * LENGTH_COUNT + length) * GROUP_SIZE;
+            groupFirst[language][length] = qFromLittleEndian<quint32>(group);
+            groupCount[language][length] = qFromLittleEndian<quint32>(group + 4);
+            valid = valid && static_cast<quint64>(groupFirst[language][length]) + groupCount[language][length] <= totalCount;
+        }
+    }
+    if (!valid) {
+        qDebug() << "Corrupt snippet index" << path;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void SnippetIndex::close()
+{
+    reader.close();
+    text = nullptr;
+    textSize = 0;
+    offsets = nullptr;
+    totalCount = 0;
+    for (int language = 0; language < LANGUAGE_COUNT; ++language) {
+        for (int length = 0; length < LENGTH_COUNT; ++length) {
+            groupFirst[language][length] = 0;
+            groupCount[language][length] = 0;
+        }
+    }
+}
+
+bool SnippetIndex::isOpen() const
+{
+    return reader.isOpen();
+}
+
+quint32 SnippetIndex::getSnippetCount(int language, int length) const
+{
+    if (language < 0 || language >= LANGUAGE_COUNT || length < 0 || length >= LENGTH_COUNT) {
+        return 0;
+    }
+    return groupCount[language][length];
+}
+
+quint32 SnippetIndex::getSnippetCount(int language) const
+{
+    quint32 count = 0;
+    for (int length = 0; length < LENGTH_COUNT; ++length) {
+        count += getSnippetCount(language, length);
+    }
+    return count;
+}
+
+QByteArray SnippetIndex::getSnippetUtf8(int language, int length, quint32 index) const
+{
+    if (index >= getSnippetCount(language, length)) {
+        return QByteArray();
+    }
+
+    const uchar *entry = offsets + (groupFirst[language][length] + static_cast<quint64>(index)) * sizeof(quint64);
+    const quint64 begin = qFromLittleEndian<quint64>(entry);
+    const quint64 end = qFromLittleEndian<quint64>(entry + sizeof(quint64));
+    if (begin > end || end > textSize) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(text + begin), static_cast<int>(end - begin));
+}
+
+QString SnippetIndex::getSnippet(int language, int length, quint32 index) const
+{
+    const QByteArray utf8 = getSnippetUtf8(language, length, index);
+    return QString::fromUtf8(utf8.constData(), utf8.size());
+}
+
+QString SnippetIndex::getRandomSnippet(int language, int length, SessionRandom &random) const
+{
+    const quint32 count = getSnippetCount(language, length);
+    if (count == 0) {
+        return QString();
+    }
+    return getSnippet(language, length, random.bounded(count));
+}
+
+QString SnippetIndex::getLanguageName(int language)
+{
+    switch (language) {
+        case CPP:        return "C++";
+        case C:          return "C";
+        case JAVA:       return "Java";
+        case CSHARP:     return "C#";
+        case JAVASCRIPT: return "JavaScript";
+        case TYPESCRIPT: return "TypeScript";
+        case GO:         return "Go";
+        case RUST:       return "Rust";
+        case PYTHON:     return "Python";
+        default:         return QString();
+    }
+}
+
+int SnippetIndex::languageForSuffix(const QString &suffix)
+{
+    static const QHash<QString, int> languages = {
+        {"cpp", CPP}, {"cc", CPP}, {"cxx", CPP}, {"hpp", CPP}, {"hh", CPP}, {"hxx", CPP}, {"h", CPP},
+        {"c", C},
+        {"java", JAVA},
+        {"cs", CSHARP},
+        {"js", JAVASCRIPT}, {"mjs", JAVASCRIPT}, {"jsx", JAVASCRIPT},
+        {"ts", TYPESCRIPT}, {"tsx", TYPESCRIPT},
+        {"go", GO},
+        {"rs", RUST},
+        {"py", PYTHON}
+    };
+    return languages.value(suffix.toLower(), -1);
+}
+
+int SnippetIndex::lengthFor(int characters)
+{
+    if (characters >= LONG_MIN_CHARS) {
+        return 2;
+    }
+    return characters >= MEDIUM_MIN_CHARS ? 1 : 0;
+}
+
+QString SnippetIndex::getDefaultPath()
+{
+    const QDir userDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    if (userDir.exists("snippets.index")) {
+        return userDir.filePath("snippets.index");
+    }
+
+    QDir codeDir(QCoreApplication::applicationDirPath());
+    if (codeDir.cd("code") && codeDir.exists("snippets.index")) {
+        return codeDir.filePath("snippets.index");
+    }
+    return QString();
+}
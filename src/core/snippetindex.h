@@ -0,0 +1,92 @@
+/**
+ * Typing Speed Test - Snippet Index
+ *
+ * Read-only view of an index of function-sized source code snippets built
+ * by SnippetIndexWriter from a local source tree. The file is memory mapped
+ * like the corpus, and snippets are grouped by language and length, so a
+ * random snippet of a given language and length is one table lookup and
+ * one bounded random index, whatever the size of the indexed tree.
+ *
+ * A section file (see sectionfile.h) with magic "TSCS" and sections:
+ *   TEXT: UTF-8 snippets back to back, indentation normalized, lines separated by '\n'
+ *   OFFSETS: u64[count + 1] into TEXT, snippets grouped by language, then length
+ *   GROUPS: per language, per length: u32 first snippet, u32 count
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef SNIPPETINDEX_H
+#define SNIPPETINDEX_H
+
+#include <QByteArray>
+#include <QString>
+#include "sectionfile.h"
+#include "sessionrandom.h"
+
+class SnippetIndex
+{
+public:
+    static const quint32 MAGIC = 0x53435354; // "TSCS"
+    static const quint16 VERSION = 1;
+
+    enum Language {
+        CPP,
+        C,
+        JAVA,
+        CSHARP,
+        JAVASCRIPT,
+        TYPESCRIPT,
+        GO,
+        RUST,
+        PYTHON,
+        LANGUAGE_COUNT
+    };
+
+    // Indexed by TypingTest::DifficultyLevel: longer snippets for harder tests
+    static const int LENGTH_COUNT = 3;
+    static const int MEDIUM_MIN_CHARS = 200;
+    static const int LONG_MIN_CHARS = 450;
+
+    enum SectionId {
+        TEXT_SECTION = 1,
+        OFFSETS_SECTION = 2,
+        GROUPS_SECTION = 3
+    };
+
+    static const int GROUP_SIZE = 8;
+
+    SnippetIndex();
+    ~SnippetIndex();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+
+    quint32 getSnippetCount(int language, int length) const;
+    quint32 getSnippetCount(int language) const;
+    // Points into the mapping; valid until close()
+    QByteArray getSnippetUtf8(int language, int length, quint32 index) const;
+    QString getSnippet(int language, int length, quint32 index) const;
+    QString getRandomSnippet(int language, int length, SessionRandom &random) const;
+
+    static QString getLanguageName(int language);
+    static int languageForSuffix(const QString &suffix); // -1 for files that are not indexed
+    static int lengthFor(int characters);
+
+    // <user data dir>/snippets.index, then <app dir>/code/snippets.index; empty if neither exists
+    static QString getDefaultPath();
+
+private:
+    Q_DISABLE_COPY(SnippetIndex)
+
+    SectionFileReader reader;
+    const uchar *text;
+    quint64 textSize;
+    const uchar *offsets;
+    quint32 totalCount;
+    quint32 groupFirst[LANGUAGE_COUNT][LENGTH_COUNT];
+    quint32 groupCount[LANGUAGE_COUNT][LENGTH_COUNT];
+};
+
+#endif // SNIPPETINDEX_H
@@ -0,0 +1,434 @@
+/**
+ * Typing Speed Test - Snippet Index Writer Implementation
+ *
+ * Builds the snippet index read by SnippetIndex from local source trees.
+ * Source files are memory mapped and split on all cores into function-sized
+ * snippets (brace-matched bodies, or indented blocks for Python) with their
+ * indentation normalized; duplicates are dropped as snippets are added, and
+ * finish() writes them grouped by language and length.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "snippetindexwriter.h"
+#include "sectionfile.h"
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+
+namespace {
+
+const int MAX_HEADER_LINES = 6; // Lines a parameter list may span
+
+struct Line {
+    const char *begin;
+    const char *end; // Excludes the newline
+};
+
+QVector<Line> splitLines(const char *source, qint64 size)
+{
+    QVector<Line> lines;
+    const char *end = source + size;
+    for (const char *begin = source; begin < end; ) {
+        const char *newline = static_cast<const char *>(memchr(begin, '\n', static_cast<size_t>(end - begin)));
+        const char *lineEnd = newline ? newline : end;
+        lines.append({begin, lineEnd});
+        begin = lineEnd + 1;
+    }
+    return lines;
+}
+
+QByteArray toBytes(const Line &line)
+{
+    return QByteArray(line.begin, static_cast<int>(line.end - line.begin));
+}
+
+QByteArray trimmed(const Line &line)
+{
+    return toBytes(line).trimmed();
+}
+
+// Leading whitespace in columns, or -1 for a blank line
+int indentOf(const Line &line)
+{
+    int column = 0;
+    for (const char *c = line.begin; c < line.end; ++c) {
+        if (*c == ' ') {
+            ++column;
+        } else if (*c == '\t') {
+            column += SnippetIndexWriter::TAB_WIDTH - column % SnippetIndexWriter::TAB_WIDTH;
+        } else if (*c != '\r') {
+            return column;
+        }
+    }
+    return -1;
+}
+
+int parenBalance(const QByteArray &text)
+{
+    return text.count('(') - text.count(')');
+}
+
+bool startsWithWord(const QByteArray &text, const char *word)
+{
+    const int length = static_cast<int>(qstrlen(word));
+    if (!text.startsWith(word)) {
+        return false;
+    }
+    const char next = text.size() > length ? text[length] : ' ';
+    return !((next >= 'a' && next <= 'z') || (next >= 'A' && next <= 'Z') || (next >= '0' && next <= '9') || next == '_');
+}
+
+// Statements that open a block with a parenthesized head but are not functions
+bool isStatement(const QByteArray &text)
+{
+    static const char *const keywords[] = {
+        "if", "else", "for", "foreach", "while", "do", "switch", "case", "try", "catch", "finally",
+        "return", "using", "lock", "synchronized", "with", "match", "select", "defer", "go", "throw"
+    };
+    if (text.startsWith('}') || text.startsWith('#') || text.startsWith("//") || text.startsWith("/*")
+        || text.startsWith('*')) {
+        return true;
+    }
+    for (const char *keyword : keywords) {
+        if (startsWithWord(text, keyword)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// First line of a function whose body opens on line i or i + 1, or -1
+int functionStart(const QVector<Line> &lines, int i)
+{
+    const QByteArray text = trimmed(lines[i]);
+    if (text.isEmpty() || text.endsWith(';')) {
+        return -1;
+    }
+    const bool opensHere = text.endsWith('{');
+    const bool opensNext = !opensHere && i + 1 < lines.size() && trimmed(lines[i + 1]) == "{";
+    if (!opensHere && !opensNext) {
+        return -1;
+    }
+
+    // Walk back over a parameter list spread across lines
+    int start = i;
+    int balance = parenBalance(text);
+    bool parenthesized = text.contains('(');
+    while (balance < 0 && start > 0 && i - start < MAX_HEADER_LINES) {
+        const QByteArray previous = trimmed(lines[--start]);
+        balance += parenBalance(previous);
+        parenthesized = parenthesized || previous.contains('(');
+    }
+    if (balance != 0 || !parenthesized || isStatement(trimmed(lines[start]))) {
+        return -1;
+    }
+
+    // Annotations, attributes and template heads belong to the function
+    while (start > 0) {
+        const QByteArray previous = trimmed(lines[start - 1]);
+        if (!previous.startsWith('@') && !previous.startsWith("#[") && !startsWithWord(previous, "template")) {
+            break;
+        }
+        --start;
+    }
+    return start;
+}
+
+// Line holding the brace that closes the first block opened from line start, or -1 if that
+// takes more than MAX_LINES; strings, character literals and comments are skipped
+int functionEnd(const QVector<Line> &lines, int start, int language)
+{
+    const bool quotedStrings = language == SnippetIndex::JAVASCRIPT || language == SnippetIndex::TYPESCRIPT;
+    const bool templateStrings = quotedStrings || language == SnippetIndex::GO;
+    int depth = 0;
+    bool blockComment = false;
+    char quote = 0; // Open string delimiter
+    for (int i = start; i < lines.size() && i - start < SnippetIndexWriter::MAX_LINES; ++i) {
+        const char *c = lines[i].begin;
+        const char *end = lines[i].end;
+        if (quote != '`') {
+            quote = 0; // Only template strings span lines
+        }
+        while (c < end) {
+            if (blockComment) {
+                if (c[0] == '*' && c + 1 < end && c[1] == '/') {
+                    blockComment = false;
+                    ++c;
+                }
+            } else if (quote) {
+                if (*c == '\\') {
+                    ++c;
+                } else if (*c == quote) {
+                    quote = 0;
+                }
+            } else if (c[0] == '/' && c + 1 < end && c[1] == '/') {
+                break;
+            } else if (c[0] == '/' && c + 1 < end && c[1] == '*') {
+                blockComment = true;
+                ++c;
+            } else if (*c == '"' || (*c == '`' && templateStrings) || (*c == '\'' && quotedStrings)) {
+                quote = *c;
+            } else if (*c == '\'') {
+                // A character literal closes within a few bytes; anything else is a Rust lifetime
+                const char *close = c + 1 < end && c[1] == '\\' ? c + 3 : c + 2;
+                while (close < end && close - c < 8 && *close != '\'') {
+                    ++close;
+                }
+                if (close < end && *close == '\'' && close - c <= 7) {
+                    c = close;
+                }
+            } else if (*c == '{') {
+                ++depth;
+            } else if (*c == '}' && depth > 0 && --depth == 0) {
+                return i;
+            }
+            ++c;
+        }
+    }
+    return -1;
+}
+
+// Last line of the Python function starting on line i, or -1
+int pythonFunctionEnd(const QVector<Line> &lines, int i)
+{
+    const int defIndent = indentOf(lines[i]);
+
+    // The signature ends at a colon with its parentheses closed
+    int header = i;
+    QByteArray text = trimmed(lines[i]);
+    int balance = parenBalance(text);
+    while ((balance > 0 || !text.endsWith(':')) && header + 1 < lines.size() && header - i < MAX_HEADER_LINES) {
+        text = trimmed(lines[++header]);
+        balance += parenBalance(text);
+    }
+    if (balance != 0 || !text.endsWith(':')) {
+        return -1;
+    }
+
+    // The body is every following line indented deeper, blank lines included
+    int end = header;
+    for (int line = header + 1; line < lines.size(); ++line) {
+        const int indent = indentOf(lines[line]);
+        if (indent < 0) {
+            continue;
+        }
+        if (indent <= defIndent) {
+            break;
+        }
+        end = line;
+        if (end - i >= SnippetIndexWriter::MAX_LINES) {
+            return -1;
+        }
+    }
+    return end > header ? end : -1;
+}
+
+}
+
+SnippetIndexWriter::SnippetIndexWriter(const QString &path)
+    : outputPath(path)
+{
+}
+
+int SnippetIndexWriter::addTree(const QString &root, int threads)
+{
+    struct SourceFile {
+        QString path;
+        int language;
+    };
+    QVector<SourceFile> files;
+    QDirIterator iterator(root, QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+    while (iterator.hasNext()) {
+        const QString path = iterator.next();
+        const QFileInfo info = iterator.fileInfo();
+        const int language = SnippetIndex::languageForSuffix(info.suffix());
+        if (language >= 0 && info.size() <= MAX_FILE_SIZE && !path.contains("/node_modules/")) {
+            files.append({path, language});
+        }
+    }
+
+    // Sorted, so the same tree always gives the same index and the same passages per seed
+    std::sort(files.begin(), files.end(), [](const SourceFile &a, const SourceFile &b) { return a.path < b.path; });
+
+    // Workers claim files through a shared counter and fill only their file's slot
+    QVector<QVector<QByteArray>> found(files.size());
+    QVector<QByteArray> *foundSlots = found.data();
+    std::atomic<int> nextFile(0);
+    const int workerCount = qBound(1, threads > 0 ? threads : QThread::idealThreadCount(), qMax(1, files.size()));
+    QVector<QThread *> workers;
+    for (int worker = 0; worker < workerCount; ++worker) {
+        workers.append(QThread::create([&files, &nextFile, foundSlots]() {
+            for (int i = nextFile++; i < files.size(); i = nextFile++) {
+                QFile file(files[i].path);
+                if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+                    continue;
+                }
+                const uchar *source = file.map(0, file.size());
+                if (source) {
+                    foundSlots[i] = extractSnippets(files[i].language, reinterpret_cast<const char *>(source), file.size());
+                    file.unmap(const_cast<uchar *>(source));
+                }
+            }
+        }));
+        workers.last()->start();
+    }
+    for (QThread *worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+
+    for (int i = 0; i < files.size(); ++i) {
+        for (const QByteArray &snippet : found[i]) {
+            addSnippet(files[i].language, snippet);
+        }
+    }
+    return files.size();
+}
+
+QVector<QByteArray> SnippetIndexWriter::extractSnippets(int language, const char *source, qint64 size)
+{
+    QVector<QByteArray> snippets;
+    const QVector<Line> lines = splitLines(source, size);
+    for (int i = 0; i < lines.size(); ++i) {
+        int start = i;
+        int end = -1;
+        if (language == SnippetIndex::PYTHON) {
+            const QByteArray text = trimmed(lines[i]);
+            if (startsWithWord(text, "def") || text.startsWith("async def ")) {
+                end = pythonFunctionEnd(lines, i);
+                const int defIndent = indentOf(lines[i]);
+                while (start > 0 && indentOf(lines[start - 1]) == defIndent && trimmed(lines[start - 1]).startsWith('@')) {
+                    --start;
+                }
+            }
+        } else {
+            start = functionStart(lines, i);
+            end = start >= 0 ? functionEnd(lines, start, language) : -1;
+        }
+        if (start < 0 || end < 0 || end - start + 1 < MIN_LINES) {
+            continue;
+        }
+
+        QList<QByteArray> snippetLines;
+        for (int line = start; line <= end; ++line) {
+            snippetLines.append(toBytes(lines[line]));
+        }
+        const QByteArray snippet = normalize(snippetLines);
+        if (!snippet.isEmpty()) {
+            // Functions nested in a kept one are not indexed again
+            snippets.append(snippet);
+            i = end;
+        }
+    }
+    return snippets;
+}
+
+QByteArray SnippetIndexWriter::normalize(const QList<QByteArray> &lines)
+{
+    QList<QByteArray> expanded;
+    int commonIndent = INT_MAX;
+    for (const QByteArray &line : lines) {
+        QByteArray out;
+        out.reserve(line.size());
+        for (char c : line) {
+            const uchar byte = static_cast<uchar>(c);
+            if (c == '\t') {
+                out.append(TAB_WIDTH - out.size() % TAB_WIDTH, ' ');
+            } else if (c == '\r') {
+                continue;
+            } else if (byte < 0x20 || byte >= 0x7F) {
+                return QByteArray(); // Only what every keyboard can type
+            } else {
+                out.append(c);
+            }
+        }
+        while (out.endsWith(' ')) {
+            out.chop(1);
+        }
+        if (!out.isEmpty()) {
+            int indent = 0;
+            while (out[indent] == ' ') {
+                ++indent;
+            }
+            commonIndent = qMin(commonIndent, indent);
+        }
+        expanded.append(out);
+    }
+
+    // Leading and trailing blank lines dropped, runs of blank lines collapsed to one
+    QByteArray snippet;
+    int lineCount = 0;
+    bool blank = false;
+    for (const QByteArray &line : expanded) {
+        if (line.isEmpty()) {
+            blank = !snippet.isEmpty();
+            continue;
+        }
+        if (!snippet.isEmpty()) {
+            snippet += blank ? "\n\n" : "\n";
+            lineCount += blank ? 2 : 1;
+        }
+        snippet += line.mid(commonIndent);
+        blank = false;
+    }
+    ++lineCount;
+
+    if (lineCount < MIN_LINES || lineCount > MAX_LINES || snippet.size() < MIN_CHARS || snippet.size() > MAX_CHARS) {
+        return QByteArray();
+    }
+    return snippet;
+}
+
+bool SnippetIndexWriter::addSnippet(int language, const QByteArray &utf8)
+{
+    if (language < 0 || language >= SnippetIndex::LANGUAGE_COUNT || utf8.isEmpty() || seen.contains(utf8)) {
+        return false;
+    }
+    seen.insert(utf8);
+    snippets[language].append(utf8);
+    return true;
+}
+
+quint32 SnippetIndexWriter::getSnippetCount(int language) const
+{
+    if (language < 0 || language >= SnippetIndex::LANGUAGE_COUNT) {
+        return 0;
+    }
+    return static_cast<quint32>(snippets[language].size());
+}
+
+bool SnippetIndexWriter::finish()
+{
+    // Sections are assembled in memory; snippets are capped at MAX_CHARS and deduplicated
+    QByteArray text;
+    QByteArray offsets;
+    QByteArray groups;
+    quint32 count = 0;
+    SectionFileWriter::appendLittleEndian(offsets, 0, 8);
+    for (int language = 0; language < SnippetIndex::LANGUAGE_COUNT; ++language) {
+        for (int length = 0; length < SnippetIndex::LENGTH_COUNT; ++length) {
+            SectionFileWriter::appendLittleEndian(groups, count, 4);
+            const quint32 first = count;
+            for (const QByteArray &snippet : snippets[language]) {
+                if (SnippetIndex::lengthFor(snippet.size()) == length) {
+                    text += snippet;
+                    SectionFileWriter::appendLittleEndian(offsets, static_cast<quint64>(text.size()), 8);
+                    ++count;
+                }
+            }
+            SectionFileWriter::appendLittleEndian(groups, count - first, 4);
+        }
+    }
+
+    SectionFileWriter writer(SnippetIndex::MAGIC, SnippetIndex::VERSION);
+    writer.addSection(SnippetIndex::TEXT_SECTION, text);
+    writer.addSection(SnippetIndex::OFFSETS_SECTION, offsets);
+    writer.addSection(SnippetIndex::GROUPS_SECTION, groups);
+    return writer.writeFile(outputPath, "snippet index");
+}
@@ -0,0 +1,58 @@
+/**
+ * Typing Speed Test - Snippet Index Writer
+ *
+ * Builds the snippet index read by SnippetIndex from local source trees.
+ * Source files are memory mapped and split on all cores into function-sized
+ * snippets (brace-matched bodies, or indented blocks for Python) with their
+ * indentation normalized; duplicates are dropped as snippets are added, and
+ * finish() writes them grouped by language and length.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef SNIPPETINDEXWRITER_H
+#define SNIPPETINDEXWRITER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include "snippetindex.h"
+
+class SnippetIndexWriter
+{
+public:
+    static const int MIN_LINES = 3;
+    static const int MAX_LINES = 40;
+    static const int MIN_CHARS = 60;
+    static const int MAX_CHARS = 1500;
+    static const int TAB_WIDTH = 4;
+    static const qint64 MAX_FILE_SIZE = 4 << 20; // Larger files are generated or vendored
+
+    explicit SnippetIndexWriter(const QString &path);
+
+    // Indexes every recognized source file under root on the given number of threads (0 for
+    // all cores); returns the number of files read. Hidden directories are skipped
+    int addTree(const QString &root, int threads = 0);
+    // Takes a snippet already normalized; false for duplicates and untypeable text
+    bool addSnippet(int language, const QByteArray &utf8);
+    quint32 getSnippetCount(int language) const;
+
+    // Writes the index; nothing is written at path before this
+    bool finish();
+
+    // Function-sized snippets of one source file, normalized; thread-safe
+    static QVector<QByteArray> extractSnippets(int language, const char *source, qint64 size);
+    // Tabs expanded, trailing spaces and common indentation removed, blank line runs collapsed;
+    // empty if the result is not a typeable snippet
+    static QByteArray normalize(const QList<QByteArray> &lines);
+
+private:
+    QString outputPath;
+    QVector<QByteArray> snippets[SnippetIndex::LANGUAGE_COUNT];
+    QSet<QByteArray> seen;
+};
+
+#endif // SNIPPETINDEXWRITER_H
@@ -0,0 +1,106 @@
+/**
+ * Typing Speed Test - Speed Tracker Implementation
+ *
+ * Live speed figures for a running test, each kept up to date in constant
+ * time per keystroke: raw and net WPM, WPM over the last five seconds from
+ * a ring buffer of keystroke times, the best such burst, and the rhythm's
+ * consistency from the running standard deviation of inter-key intervals
+ * (Welford's algorithm). Results are read as one SpeedSnapshot.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "speedtracker.h"
+#include <QtMath>
+
+SpeedTracker::SpeedTracker()
+{
+    reset();
+}
+
+void SpeedTracker::reset()
+{
+    first = 0;
+    count = 0;
+    windowCorrect = 0;
+    keystrokes = 0;
+    lastKeystrokeMs = -1;
+    burstWPM = 0.0;
+    intervals = 0;
+    intervalMean = 0.0;
+    intervalM2 = 0.0;
+}
+
+void SpeedTracker::recordKeystroke(qint64 elapsedMs, bool correct)
+{
+    advance(elapsedMs);
+
+    // A full ring means an impossible typing speed; the oldest keystroke leaves early
+    if (count == WINDOW_CAPACITY) {
+        windowCorrect -= hits[first];
+        first = (first + 1) % WINDOW_CAPACITY;
+        --count;
+    }
+    const int slot = (first + count) % WINDOW_CAPACITY;
+    times[slot] = elapsedMs;
+    hits[slot] = correct;
+    ++count;
+    windowCorrect += correct;
+    ++keystrokes;
+
+    if (lastKeystrokeMs >= 0 && elapsedMs - lastKeystrokeMs <= PAUSE_MS) {
+        const double interval = static_cast<double>(elapsedMs - lastKeystrokeMs);
+        ++intervals;
+        const double delta = interval - intervalMean;
+        intervalMean += delta / intervals;
+        intervalM2 += delta * (interval - intervalMean);
+    }
+    lastKeystrokeMs = elapsedMs;
+
+    // The first seconds are too short a window to call a burst
+    if (elapsedMs >= ROLLING_WINDOW_MS) {
+        burstWPM = qMax(burstWPM, getRollingWPM(elapsedMs));
+    }
+}
+
+void SpeedTracker::advance(qint64 elapsedMs)
+{
+    while (count > 0 && times[first] <= elapsedMs - ROLLING_WINDOW_MS) {
+        windowCorrect -= hits[first];
+        first = (first + 1) % WINDOW_CAPACITY;
+        --count;
+    }
+}
+
+SpeedSnapshot SpeedTracker::getSnapshot(qint64 elapsedMs, int correctCharacters) const
+{
+    SpeedSnapshot snapshot;
+    snapshot.elapsedMs = elapsedMs;
+    snapshot.keystrokes = keystrokes;
+    snapshot.wpm = toWPM(correctCharacters, elapsedMs);
+    snapshot.rawWPM = toWPM(keystrokes, elapsedMs);
+    snapshot.rollingWPM = getRollingWPM(elapsedMs);
+    snapshot.burstWPM = burstWPM;
+    snapshot.meanIntervalMs = intervalMean;
+    if (intervals > 1) {
+        snapshot.intervalStdDevMs = qSqrt(intervalM2 / (intervals - 1));
+        snapshot.consistency = qBound(0.0, 100.0 * (1.0 - snapshot.intervalStdDevMs / intervalMean), 100.0);
+    }
+    return snapshot;
+}
+
+double SpeedTracker::toWPM(double characters, qint64 elapsedMs)
+{
+    if (elapsedMs <= 0) {
+        return 0.0;
+    }
+    return characters / CHARACTERS_PER_WORD / (elapsedMs / 60000.0);
+}
+
+double SpeedTracker::getRollingWPM(qint64 elapsedMs) const
+{
+    // Until a whole window has passed, the window is the test so far (at least a second, against spikes)
+    const qint64 span = qBound<qint64>(1000, elapsedMs, ROLLING_WINDOW_MS);
+    return toWPM(windowCorrect, span);
+}
@@ -0,0 +1,75 @@
+/**
+ * Typing Speed Test - Speed Tracker
+ *
+ * Live speed figures for a running test, each kept up to date in constant
+ * time per keystroke: raw and net WPM, WPM over the last five seconds from
+ * a ring buffer of keystroke times, the best such burst, and the rhythm's
+ * consistency from the running standard deviation of inter-key intervals
+ * (Welford's algorithm). Results are read as one SpeedSnapshot.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef SPEEDTRACKER_H
+#define SPEEDTRACKER_H
+
+#include <QtGlobal>
+
+// Everything a live chart needs at one moment of a test; cheap to copy
+struct SpeedSnapshot {
+    qint64 elapsedMs;
+    int keystrokes;          // Characters typed, counting ones later deleted
+    double wpm;              // Net: correct characters
+    double rawWPM;           // Every keystroke, right or wrong
+    double rollingWPM;       // Correct keystrokes of the last ROLLING_WINDOW_MS
+    double burstWPM;         // Best rolling WPM since a whole window had passed
+    double meanIntervalMs;   // Between keystrokes, pauses left out
+    double intervalStdDevMs;
+    double consistency;      // 100 for a perfectly even rhythm, 0 once the deviation reaches the mean
+
+    SpeedSnapshot()
+        : elapsedMs(0), keystrokes(0), wpm(0.0), rawWPM(0.0), rollingWPM(0.0), burstWPM(0.0)
+        , meanIntervalMs(0.0), intervalStdDevMs(0.0), consistency(0.0) {}
+};
+
+class SpeedTracker
+{
+public:
+    static const int ROLLING_WINDOW_MS = 5000;
+    static const int PAUSE_MS = 2000;        // Longer gaps are pauses, not part of the rhythm
+    static const int WINDOW_CAPACITY = 256;  // Keystrokes one window holds; over 50 per second
+    static const int CHARACTERS_PER_WORD = 5;
+
+    SpeedTracker();
+
+    void reset();
+    void recordKeystroke(qint64 elapsedMs, bool correct);
+    void advance(qint64 elapsedMs); // Drops keystrokes that have left the rolling window
+
+    // Net WPM comes from the caller, which knows which characters are correct after corrections
+    SpeedSnapshot getSnapshot(qint64 elapsedMs, int correctCharacters) const;
+
+    static double toWPM(double characters, qint64 elapsedMs);
+
+private:
+    double getRollingWPM(qint64 elapsedMs) const;
+
+    // Ring buffer of the rolling window's keystrokes, oldest at first
+    qint64 times[WINDOW_CAPACITY];
+    bool hits[WINDOW_CAPACITY];
+    int first;
+    int count;
+    int windowCorrect;
+
+    int keystrokes;
+    qint64 lastKeystrokeMs;
+    double burstWPM;
+
+    // Welford's running mean and sum of squared deviations of the intervals
+    qint64 intervals;
+    double intervalMean;
+    double intervalM2;
+};
+
+#endif // SPEEDTRACKER_H
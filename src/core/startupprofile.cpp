@@ -0,0 +1,112 @@
+/**
+ * Typing Speed Test - Startup Profile Implementation
+ *
+ * Records how long each startup phase takes, relative to the start of
+ * main(), and prints a per-phase table when the application was started
+ * with --startup-profile. Recording is a no-op otherwise.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "startupprofile.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+
+namespace {
+
+struct Phase {
+    QString name;
+    qint64 startNs;
+    qint64 endNs;
+    bool concurrent;
+};
+
+QElapsedTimer clock;
+QMutex phasesMutex;
+QVector<Phase> phases;
+qint64 lastMarkNs = 0;
+bool profileEnabled = false;
+
+QString formatMs(qint64 ns)
+{
+    return QString::number(ns / 1e6, 'f', 1);
+}
+
+}
+
+void StartupProfile::start(bool enabled)
+{
+    profileEnabled = enabled;
+    clock.start();
+}
+
+bool StartupProfile::isEnabled()
+{
+    return profileEnabled;
+}
+
+qint64 StartupProfile::now()
+{
+    return clock.isValid() ? clock.nsecsElapsed() : 0;
+}
+
+void StartupProfile::mark(const QString &phase)
+{
+    if (!profileEnabled) return;
+
+    QMutexLocker locker(&phasesMutex);
+    const qint64 endNs = now();
+    phases.append({phase, lastMarkNs, endNs, false});
+    lastMarkNs = endNs;
+}
+
+void StartupProfile::markAsync(const QString &phase, qint64 startNs)
+{
+    if (!profileEnabled) return;
+
+    QMutexLocker locker(&phasesMutex);
+    phases.append({phase, startNs, now(), true});
+}
+
+void StartupProfile::report()
+{
+    if (!profileEnabled) return;
+
+    QMutexLocker locker(&phasesMutex);
+    QVector<Phase> sorted = phases;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Phase &a, const Phase &b) {
+        return a.endNs < b.endNs;
+    });
+
+    QTextStream err(stderr);
+    err << "Startup profile (ms since main)\n";
+    err << "  " << QString("phase").leftJustified(28) << QString("start").rightJustified(9)
+        << QString("duration").rightJustified(10) << QString("end").rightJustified(9) << "\n";
+
+    qint64 firstPaintNs = -1;
+    qint64 interactiveNs = 0;
+    for (const Phase &phase : sorted) {
+        err << "  " << (phase.concurrent ? QString("| ") + phase.name : phase.name).leftJustified(28)
+            << formatMs(phase.startNs).rightJustified(9)
+            << formatMs(phase.endNs - phase.startNs).rightJustified(10)
+            << formatMs(phase.endNs).rightJustified(9) << "\n";
+        if (phase.name == "first paint") {
+            firstPaintNs = phase.endNs;
+        }
+        interactiveNs = qMax(interactiveNs, phase.endNs);
+    }
+    err << "  ('|' phases ran on worker threads, concurrently with the others)\n";
+
+    if (firstPaintNs >= 0) {
+        const bool withinBudget = firstPaintNs / 1000000 < COLD_START_BUDGET_MS;
+        err << "First paint: " << formatMs(firstPaintNs) << " ms ("
+            << (withinBudget ? "within" : "OVER") << " the " << COLD_START_BUDGET_MS << " ms budget)\n";
+    }
+    err << "Fully initialized: " << formatMs(interactiveNs) << " ms\n";
+    err.flush();
+}
@@ -0,0 +1,37 @@
+/**
+ * Typing Speed Test - Startup Profile
+ *
+ * Records how long each startup phase takes, relative to the start of
+ * main(), and prints a per-phase table when the application was started
+ * with --startup-profile. Recording is a no-op otherwise.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+#include <QString>
+#include <QtGlobal>
+
+class StartupProfile
+{
+public:
+    static const int COLD_START_BUDGET_MS = 150; // Target for the first paint
+
+    // Anchors all timings; call first thing in main()
+    static void start(bool enabled);
+    static bool isEnabled();
+    static qint64 now(); // Nanoseconds since start()
+
+    // A sequential phase on the UI thread, ending now and starting at the previous mark
+    static void mark(const QString &phase);
+    // A phase that ran concurrently with others, from startNs until now
+    static void markAsync(const QString &phase, qint64 startNs);
+
+    // Prints the recorded phases to stderr
+    static void report();
+};
+
+#endif // STARTUPPROFILE_H
@@ -1,34 +1,58 @@
 #include "typingtest.h"
+#include "sentencescorer.h"
 #include <QDebug>
+#include <algorithm>
+
+static_assert(TypingTest::EASY == SentenceScorer::EASY && TypingTest::MEDIUM == SentenceScorer::MEDIUM
+              && TypingTest::HARD == SentenceScorer::HARD, "Difficulty levels match the scorer's");
 
 TypingTest::TypingTest(QObject *parent)
     : QObject(parent)
     , timer(new QTimer(this))
     , correctCharacters(0)
     , totalCharacters(0)
+    , retiredCharacters(0)
+    , retiredCorrectCharacters(0)
+    , retiredCorrectedErrors(0)
+    , committedClusters(0)
+    , inputOffset(0)
     , wordsTyped(0)
     , testActive(false)
     , testComplete(false)
     , currentWPM(0.0)
     , currentAccuracy(100.0)
     , currentTime(0)
+    , speedHistoryInterval(1)
+    , seededSession(false)
+    , passageSeed(0)
+    , replayPending(false)
     , currentDifficulty(MEDIUM)
+    , difficultyScore(-1.0f)
+    , adaptiveDifficulty(false)
     , testDuration(60)
     , currentTestMode(STANDARD_TEST)
     , currentLessonType(LessonManager::HOME_ROW)
     , currentLessonLevel(1)
-    , lessonManager(new LessonManager(this))
+    , currentCodeLanguage(SnippetIndex::CPP)
+    , currentKeyboardLayout(KeyboardLayout::QWERTY)
+    , passageProvider(new PassageProvider(this))
 {
     connect(timer, &QTimer::timeout, this, &TypingTest::updateTimer);
     timer->setInterval(100); // Update every 100ms for smooth display
     
-    initializeDifficultyTexts();
+    // Standard passages for every difficulty are queued up front; lessons fill on first use
+    PassageRequest request;
+    for (int difficulty = EASY; difficulty <= HARD; ++difficulty) {
+        request.difficulty = difficulty;
+        passageProvider->prefetch(request);
+    }
     generateSampleText();
 }
 
 void TypingTest::startTest()
 {
     resetTest();
+    replayPending = false;
     testActive = true;
     testComplete = false;
     elapsedTimer.start();
@@ -45,135 +69,171 @@ void TypingTest::resetTest()
     
     correctCharacters = 0;
     totalCharacters = 0;
+    retiredCharacters = 0;
+    retiredCorrectCharacters = 0;
+    retiredCorrectedErrors = 0;
+    committedClusters = 0;
+    inputOffset = 0;
     wordsTyped = 0;
     currentWPM = 0.0;
     currentAccuracy = 100.0;
     currentTime = 0;
+    speedTracker.reset();
+    speed = SpeedSnapshot();
+    speedHistory.clear();
+    speedHistoryInterval = 1;
     
-    currentInput.clear();
+    typed.clear();
+    correctness.clear();
+    adaptDifficulty();
     generateSampleText();
     
     emit statsUpdated();
 }
 
+void TypingTest::stopTest()
+{
+    if (!testActive) {
+        return;
+    }
+    
+    currentTime = elapsedTimer.elapsed() / 1000;
+    calculateStats();
+    finishTest();
+    emit statsUpdated();
+}
+
 QString TypingTest::getSampleText() const
 {
-    return sampleText;
+    return passage.getText();
 }
 
 void TypingTest::generateSampleText()
 {
-    sampleText.clear();
+    if (currentTestMode == LOADED_TEXT_TEST) {
+        passage.setText(loadedText);
+        passageSeed = 0;
+        return;
+    }
     
-    if (currentTestMode == LESSON_MODE) {
-        // Generate lesson-specific text
-        sampleText = lessonManager->getProgressiveLesson(currentLessonType, currentLessonLevel);
-        
-        // Ensure minimum length for lessons
-        if (sampleText.length() < 50) {
-            sampleText = lessonManager->getLessonText(currentLessonType, 100);
-        }
+    // A seeded session draws one seed per test and keeps it through regenerations until the test starts
+    if (seededSession && !replayPending) {
+        passageSeed = random.generate64();
+        replayPending = true;
+    }
+    
+    if (replayPending) {
+        passage.setText(passageProvider->generatePassage(currentPassageRequest(), passageSeed));
     } else {
-        // Standard test mode - generate about 200-300 characters of text
-        while (sampleText.length() < 200) {
-            if (!sampleText.isEmpty()) {
-                sampleText += " ";
-            }
-            sampleText += getRandomSentence();
-        }
-        
-        // Trim to a reasonable length
-        if (sampleText.length() > 250) {
-            int lastSpace = sampleText.lastIndexOf(' ', 250);
-            if (lastSpace > 0) {
-                sampleText = sampleText.left(lastSpace);
-            }
-        }
+        // Prefetched passages come with the seed they were generated from
+        passage.setText(passageProvider->takePassage(currentPassageRequest(), passageSeed));
+    }
+    
+    if (isEndless()) {
+        chunkRandom.setSeed(passageSeed);
+        extendPassage();
     }
 }
 
-QString TypingTest::getRandomSentence()
+void TypingTest::extendPassage()
 {
-    QStringList* currentSentences = &mediumSentences;
+    if (currentTestMode == LOADED_TEXT_TEST) {
+        return;
+    }
     
-    switch (currentDifficulty) {
-        case EASY:
-            currentSentences = &easySentences;
-            break;
-        case MEDIUM:
-            currentSentences = &mediumSentences;
-            break;
-        case HARD:
-            currentSentences = &hardSentences;
+    // Whole passages are appended as the cursor nears the end, seeded from the first passage's seed
+    // so the recorded passageSeed regenerates the whole endless text
+    while (passage.getClusterCount() - typed.getClusterCount() < ENDLESS_LOOKAHEAD) {
+        const QString next = passageProvider->generatePassage(currentPassageRequest(), chunkRandom.generate64());
+        if (next.isEmpty()) {
             break;
+        }
+        passage.append(QLatin1Char(currentTestMode == CODE_TEST ? '\n' : ' ') + next);
+    }
+}
+
+int TypingTest::retireTypedText()
+{
+    // The input stays short however long the passage, so a keystroke only rescans the input
+    const int retired = qMin(typed.getClusterCount(), passage.getClusterCount()) - INPUT_KEPT_BEHIND;
+    if (!testActive || retired - committedClusters < INPUT_RETIRE_CHUNK) {
+        return 0;
     }
     
-    int index = QRandomGenerator::global()->bounded(currentSentences->size());
-    return (*currentSentences)[index];
-}
-
-void TypingTest::initializeDifficultyTexts()
-{
-    // Easy level: Simple, common words and short sentences
-    easySentences << "The cat sat on the mat."
-                 << "I like to eat pizza."
-                 << "The sun is bright today."
-                 << "Dogs are good pets."
-                 << "She went to the store."
-                 << "We play games at home."
-                 << "The book is on the table."
-                 << "He likes to read books."
-                 << "The car is red and fast."
-                 << "They live in a big house."
-                 << "Water is good for you."
-                 << "The bird can fly high."
-                 << "I want to go home now."
-                 << "The tree has green leaves."
-                 << "She has a nice smile.";
+    if (!isEndless()) {
+        const int committedInput = typed.getClusterStart(retired) - inputOffset;
+        committedClusters = retired;
+        inputOffset += committedInput;
+        return committedInput;
+    }
     
-    // Medium level: Current difficulty level
-    mediumSentences << "The quick brown fox jumps over the lazy dog."
-                   << "A journey of a thousand miles begins with a single step."
-                   << "To be or not to be, that is the question."
-                   << "All that glitters is not gold."
-                   << "The early bird catches the worm."
-                   << "Actions speak louder than words."
-                   << "Better late than never."
-                   << "Don't count your chickens before they hatch."
-                   << "Every cloud has a silver lining."
-                   << "Fortune favors the bold."
-                   << "Good things come to those who wait."
-                   << "Haste makes waste."
-                   << "If at first you don't succeed, try, try again."
-                   << "Knowledge is power."
-                   << "Laughter is the best medicine."
-                   << "Make hay while the sun shines."
-                   << "No pain, no gain."
-                   << "Opportunity knocks but once."
-                   << "Practice makes perfect."
-                   << "Rome wasn't built in a day.";
+    // The statistics keep what the retired text contributed
+    retiredCorrectCharacters += correctness.countCorrect(0, retired);
+    retiredCorrectedErrors += correctness.countCorrected(0, retired);
+    retiredCharacters += retired;
     
-    // Hard level: Complex vocabulary, technical terms, and programming concepts
-    hardSentences << "The implementation of polymorphism requires understanding inheritance hierarchies."
-                 << "Asynchronous programming paradigms utilize event-driven architectures effectively."
-                 << "Quantum entanglement demonstrates non-local correlations between particles."
-                 << "The algorithm's time complexity exhibits exponential growth characteristics."
-                 << "Microservices architecture facilitates scalable distributed system design."
-                 << "Cryptographic hash functions ensure data integrity and authenticity."
-                 << "Machine learning algorithms optimize parameters through gradient descent."
-                 << "Blockchain technology implements decentralized consensus mechanisms."
-                 << "Neuroplasticity enables synaptic reorganization throughout human development."
-                 << "Bioinformatics algorithms analyze genomic sequences for pattern recognition."
-                 << "Electromagnetic radiation propagates through vacuum at light speed."
-                 << "Thermodynamic equilibrium requires energy conservation across system boundaries."
-                 << "Pharmaceutical compounds undergo rigorous clinical trial protocols."
-                 << "Semiconductor fabrication utilizes photolithography for circuit patterning."
-                 << "Epidemiological studies investigate disease transmission patterns statistically.";
+    const int retiredInput = typed.getClusterStart(retired);
+    typed.removeClusters(retired);
+    passage.removeClusters(retired);
+    correctness.removeFront(retired);
+    return retiredInput;
+}
+
+int TypingTest::getInputOffset() const
+{
+    return inputOffset;
+}
+
+void TypingTest::setSessionSeed(quint64 seed)
+{
+    random.setSeed(seed);
+    seededSession = true;
+    replayPending = false;
+    generateSampleText();
+}
+
+quint64 TypingTest::getSessionSeed() const
+{
+    return seededSession ? random.getSeed() : 0;
+}
+
+void TypingTest::setPassageSeed(quint64 seed)
+{
+    passageSeed = seed;
+    replayPending = true;
+    generateSampleText();
+}
+
+quint64 TypingTest::getPassageSeed() const
+{
+    return passageSeed;
+}
+
+PassageRequest TypingTest::getPassageRequest() const
+{
+    return currentPassageRequest();
+}
+
+PassageRequest TypingTest::currentPassageRequest() const
+{
+    PassageRequest request;
+    request.lessonMode = (currentTestMode == LESSON_MODE);
+    request.generated = (currentTestMode == GENERATED_TEST);
+    request.code = (currentTestMode == CODE_TEST);
+    request.language = currentCodeLanguage;
+    request.difficulty = currentDifficulty;
+    request.scoreStep = difficultyScore < 0 ? -1 : qRound(difficultyScore * PassageRequest::SCORE_STEPS);
+    request.lessonType = currentLessonType;
+    request.lessonLevel = currentLessonLevel;
+    request.keyboardLayout = currentKeyboardLayout;
+    return request;
 }
 
 void TypingTest::setDifficulty(DifficultyLevel level)
 {
     currentDifficulty = level;
+    difficultyScore = -1.0f;
+    adaptiveDifficulty = false;
     generateSampleText();
 }
 
@@ -182,36 +242,175 @@ TypingTest::DifficultyLevel TypingTest::getDifficulty() const
     return currentDifficulty;
 }
 
+void TypingTest::setDifficultyScore(float score)
+{
+    difficultyScore = qBound(0.0f, score, 1.0f);
+    currentDifficulty = static_cast<DifficultyLevel>(SentenceScorer::difficultyFor(difficultyScore));
+    generateSampleText();
+}
+
+float TypingTest::getDifficultyScore() const
+{
+    return difficultyScore;
+}
+
+void TypingTest::setAdaptiveDifficulty(bool enabled)
+{
+    adaptiveDifficulty = enabled;
+    if (enabled && difficultyScore < 0) {
+        setDifficultyScore(SentenceScorer::centerOf(currentDifficulty));
+    }
+}
+
+bool TypingTest::isAdaptiveDifficulty() const
+{
+    return adaptiveDifficulty;
+}
+
+void TypingTest::adaptDifficulty()
+{
+    if (!adaptiveDifficulty || recentWPM.isEmpty()) {
+        return;
+    }
+    
+    double averageWPM = 0.0;
+    for (double wpm : recentWPM) {
+        averageWPM += wpm;
+    }
+    averageWPM /= recentWPM.size();
+    
+    const float score = qBound(0.0f, static_cast<float>((averageWPM - ADAPTIVE_MIN_WPM)
+                                                        / (ADAPTIVE_MAX_WPM - ADAPTIVE_MIN_WPM)), 1.0f);
+    if (qRound(score * PassageRequest::SCORE_STEPS) != qRound(difficultyScore * PassageRequest::SCORE_STEPS)) {
+        difficultyScore = score;
+        currentDifficulty = static_cast<DifficultyLevel>(SentenceScorer::difficultyFor(score));
+        emit difficultyAdapted(score);
+    }
+}
+
+void TypingTest::finishTest()
+{
+    testComplete = true;
+    testActive = false;
+    timer->stop();
+    
+    // Lessons and code have their own pace; only prose results steer the adaptive difficulty
+    if ((currentTestMode == STANDARD_TEST || currentTestMode == GENERATED_TEST) && totalCharacters > 0) {
+        recentWPM.append(currentWPM);
+        while (recentWPM.size() > ADAPTIVE_WINDOW) {
+            recentWPM.removeFirst();
+        }
+    }
+    
+    passageProvider->setWeakNgrams(getWeakNgrams());
+    
+    // Older tests count for less, and n-grams not seen for a while are forgotten
+    for (auto it = ngramStats.begin(); it != ngramStats.end(); ) {
+        it->attempts *= 0.8f;
+        it->errors *= 0.8f;
+        if (it->attempts < 0.5f) {
+            it = ngramStats.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TypingTest::recordKeystroke(int position, bool correct)
+{
+    // The bigram and trigram ending at the typed character, letters only
+    for (int length = 2; length <= 3 && position + 1 >= length; ++length) {
+        QString ngram;
+        for (int cluster = position + 1 - length; cluster <= position; ++cluster) {
+            if (passage.getClusterLength(cluster) == 1) {
+                ngram += passage.getText()[passage.getClusterStart(cluster)].toLower();
+            }
+        }
+        bool letters = ngram.length() == length;
+        for (const QChar c : ngram) {
+            letters = letters && c >= QLatin1Char('a') && c <= QLatin1Char('z');
+        }
+        if (!letters) {
+            break;
+        }
+        
+        NgramStats &stats = ngramStats[ngram];
+        stats.attempts += 1.0f;
+        if (!correct) {
+            stats.errors += 1.0f;
+        }
+    }
+}
+
+QHash<QString, float> TypingTest::getWeakNgrams() const
+{
+    // Error rate pulled towards zero for rarely seen n-grams
+    QVector<QPair<float, QString>> ranked;
+    for (auto it = ngramStats.constBegin(); it != ngramStats.constEnd(); ++it) {
+        if (it->errors >= 1.0f) {
+            ranked.append(qMakePair(it->errors / (it->attempts + 4.0f), it.key()));
+        }
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const QPair<float, QString> &a, const QPair<float, QString> &b) {
+        return a.first > b.first;
+    });
+    
+    QHash<QString, float> weights;
+    for (int i = 0; i < ranked.size() && i < WEAK_NGRAM_COUNT; ++i) {
+        weights.insert(ranked[i].second, ranked[i].first);
+    }
+    return weights;
+}
+
 void TypingTest::onTextChanged(const QString &text)
 {
     if (!testActive || testComplete) {
         return;
     }
     
-    currentInput = text;
+    // Single keystrokes only; pastes and deletions say nothing about n-grams
+    const int position = typed.getClusterCount();
+    updateCorrectness(typed.replaceFrom(inputOffset, text));
+    if (typed.getClusterCount() == position + 1 && position < passage.getClusterCount()) {
+        recordKeystroke(position, correctness.isCorrect(position));
+        speedTracker.recordKeystroke(elapsedTimer.elapsed(), correctness.isCorrect(position));
+    }
+    
+    if (isEndless()) {
+        extendPassage();
+    }
     calculateStats();
     
     // Check if test is complete
-    if (currentInput.length() >= sampleText.length()) {
-        testComplete = true;
-        testActive = false;
-        timer->stop();
+    if (typed.getClusterCount() >= passage.getClusterCount()) {
+        finishTest();
     }
     
     emit statsUpdated();
 }
 
-void TypingTest::calculateStats()
+void TypingTest::updateCorrectness(int changedCluster)
 {
-    totalCharacters = currentInput.length();
-    correctCharacters = 0;
-    
-    // Calculate correct characters
-    for (int i = 0; i < totalCharacters && i < sampleText.length(); ++i) {
-        if (currentInput[i] == sampleText[i]) {
-            correctCharacters++;
+    // Clusters before the first one the edit touched keep their bits
+    const int count = qMin(typed.getClusterCount(), passage.getClusterCount());
+    correctness.truncate(qMin(changedCluster, count));
+    for (int cluster = correctness.getTypedCount(); cluster < count; ++cluster) {
+        const bool correct = PassageModel::clusterEquals(typed, cluster, passage, cluster);
+        correctness.setCorrect(cluster, correct);
+        
+        // A letter still waiting for its accent is not a mistake yet
+        const bool composing = cluster == typed.getClusterCount() - 1
+            && PassageModel::clusterStartsWith(passage, cluster, typed, cluster);
+        if (!correct && !composing) {
+            correctness.markMistyped(cluster);
         }
     }
+}
+
+void TypingTest::calculateStats()
+{
+    totalCharacters = retiredCharacters + typed.getClusterCount();
+    correctCharacters = retiredCorrectCharacters + correctness.countCorrect();
     
     // Calculate accuracy
     if (totalCharacters > 0) {
@@ -220,19 +419,11 @@ void TypingTest::calculateStats()
         currentAccuracy = 100.0;
     }
     
-    // Calculate WPM
-    double timeInMinutes = elapsedTimer.elapsed() / 60000.0; // Convert to minutes
-    if (timeInMinutes > 0) {
-        // Standard WPM calculation: (characters typed / 5) / time in minutes
-        currentWPM = (correctCharacters / WORDS_PER_MINUTE_DIVISOR) / timeInMinutes;
-    } else {
-        currentWPM = 0.0;
-    }
-    
-    // Ensure WPM is not negative
-    if (currentWPM < 0) {
-        currentWPM = 0.0;
-    }
+    // Standard WPM calculation: (correct characters / 5) / time in minutes, with the live figures
+    const qint64 elapsed = elapsedTimer.elapsed();
+    speedTracker.advance(elapsed);
+    speed = speedTracker.getSnapshot(elapsed, correctCharacters);
+    currentWPM = speed.wpm;
 }
 
 void TypingTest::updateTimer()
@@ -243,14 +434,25 @@ void TypingTest::updateTimer()
     
     currentTime = elapsedTimer.elapsed() / 1000; // Convert to seconds
     
+    calculateStats();
+    if ((speedHistory.size() + 1) * speedHistoryInterval <= currentTime) {
+        speedHistory.append(speed);
+        
+        // Long endless tests halve the resolution instead of growing the history without bound
+        if (speedHistory.size() == SPEED_HISTORY_LIMIT) {
+            for (int i = 0; i < SPEED_HISTORY_LIMIT / 2; ++i) {
+                speedHistory[i] = speedHistory[2 * i + 1];
+            }
+            speedHistory.resize(SPEED_HISTORY_LIMIT / 2);
+            speedHistoryInterval *= 2;
+        }
+    }
+    
     // Check if test duration exceeded
-    if (currentTime >= testDuration) {
-        testComplete = true;
-        testActive = false;
-        timer->stop();
+    if (!isEndless() && currentTime >= testDuration) {
+        finishTest();
     }
     
-    calculateStats();
     emit statsUpdated();
 }
 
@@ -264,6 +466,21 @@ double TypingTest::getAccuracy() const
     return currentAccuracy;
 }
 
+const SpeedSnapshot &TypingTest::getSpeedSnapshot() const
+{
+    return speed;
+}
+
+const QVector<SpeedSnapshot> &TypingTest::getSpeedHistory() const
+{
+    return speedHistory;
+}
+
+int TypingTest::getSpeedHistoryInterval() const
+{
+    return speedHistoryInterval;
+}
+
 int TypingTest::getElapsedTime() const
 {
     return currentTime;
@@ -271,11 +488,11 @@ int TypingTest::getElapsedTime() const
 
 int TypingTest::getProgress() const
 {
-    if (sampleText.isEmpty()) {
+    if (passage.isEmpty() || isEndless()) {
         return 0;
     }
     
-    int progress = (currentInput.length() * 100) / sampleText.length();
+    int progress = (typed.getClusterCount() * 100) / passage.getClusterCount();
     return qMin(progress, 100);
 }
 
@@ -294,6 +511,26 @@ int TypingTest::getTotalCharacters() const
     return totalCharacters;
 }
 
+bool TypingTest::isLastCharacterCorrect() const
+{
+    return correctness.isCorrect(typed.getClusterCount() - 1);
+}
+
+int TypingTest::getCorrectedErrors() const
+{
+    return retiredCorrectedErrors + correctness.countCorrected();
+}
+
+QVector<int> TypingTest::getErrorPositions() const
+{
+    return correctness.getErrorPositions();
+}
+
+const CorrectnessMap &TypingTest::getCorrectness() const
+{
+    return correctness;
+}
+
 void TypingTest::setTestDuration(int seconds)
 {
     testDuration = seconds;
@@ -304,6 +541,11 @@ int TypingTest::getTestDuration() const
     return testDuration;
 }
 
+bool TypingTest::isEndless() const
+{
+    return testDuration <= 0;
+}
+
 void TypingTest::setTestMode(TestMode mode)
 {
     currentTestMode = mode;
@@ -315,6 +557,56 @@ TypingTest::TestMode TypingTest::getTestMode() const
     return currentTestMode;
 }
 
+bool TypingTest::hasGeneratedText() const
+{
+    return passageProvider->hasModel();
+}
+
+void TypingTest::setCodeLanguage(int language)
+{
+    currentCodeLanguage = language;
+    if (currentTestMode == CODE_TEST) {
+        generateSampleText();
+    }
+}
+
+void TypingTest::setLoadedText(const QString &text)
+{
+    loadedText = text.simplified();
+    if (currentTestMode == LOADED_TEXT_TEST) {
+        generateSampleText();
+    }
+}
+
+int TypingTest::getCodeLanguage() const
+{
+    return currentCodeLanguage;
+}
+
+QList<int> TypingTest::getCodeLanguages() const
+{
+    QList<int> languages;
+    for (int language = 0; language < SnippetIndex::LANGUAGE_COUNT; ++language) {
+        if (passageProvider->getSnippetCount(language) > 0) {
+            languages.append(language);
+        }
+    }
+    return languages;
+}
+
+void TypingTest::setKeyboardLayout(KeyboardLayout::Layout layout)
+{
+    currentKeyboardLayout = layout;
+    if (currentTestMode != CODE_TEST) {
+        generateSampleText();
+    }
+}
+
+KeyboardLayout::Layout TypingTest::getKeyboardLayout() const
+{
+    return currentKeyboardLayout;
+}
+
 void TypingTest::setLessonType(LessonManager::LessonType type)
 {
     currentLessonType = type;
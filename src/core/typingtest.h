@@ -7,8 +7,12 @@
 #include <QString>
 #include <QStringList>
 #include <QElapsedTimer>
-#include <QRandomGenerator>
 #include "../managers/lessonmanager.h"
+#include "correctnessmap.h"
+#include "passageprovider.h"
+#include "passagemodel.h"
+#include "sessionrandom.h"
+#include "speedtracker.h"
 
 class TypingTest : public QObject
 {
@@ -23,31 +27,77 @@ public:
     
     enum TestMode {
         STANDARD_TEST,
-        LESSON_MODE
+        LESSON_MODE,
+        GENERATED_TEST, // Standard test on Markov-generated text
+        CODE_TEST,      // Functions from an indexed source tree; Enter types the line breaks
+        LOADED_TEXT_TEST // Text from a file; nothing regenerates it, so its results record no seed
     };
     
     explicit TypingTest(QObject *parent = nullptr);
     
     void startTest();
     void resetTest();
+    void stopTest(); // Ends a running test as if its time had run out
     QString getSampleText() const;
     
+    // Seeds every later passage of the session, so the same seed replays the same sequence of tests
+    void setSessionSeed(quint64 seed);
+    quint64 getSessionSeed() const;
+    // The next test (until it starts) uses this passage seed, e.g. to retake a recorded result exactly
+    void setPassageSeed(quint64 seed);
+    quint64 getPassageSeed() const; // Regenerates the current passage; stored with each result
+    PassageRequest getPassageRequest() const; // The settings the seed regenerates it under; stored with the seed
+    
     void setDifficulty(DifficultyLevel level);
     DifficultyLevel getDifficulty() const;
-    void setTestDuration(int seconds);
+    // Continuous difficulty, 0.0 (easiest) to 1.0; the level follows the score
+    void setDifficultyScore(float score);
+    float getDifficultyScore() const; // -1 while a plain difficulty level is selected
+    // Moves the score after each test to follow the average of the recent WPM results
+    void setAdaptiveDifficulty(bool enabled);
+    bool isAdaptiveDifficulty() const;
+    void setTestDuration(int seconds); // 0 runs an endless test
     int getTestDuration() const;
+    // No time limit; the passage streams in ahead of the cursor until stopTest()
+    bool isEndless() const;
+    // Lets go of input well behind the cursor and returns how many characters of it went; the caller
+    // removes as many from the start of its input, which can no longer be backspaced into. An endless
+    // test also drops that text from the passage; any other test keeps it for scoring
+    int retireTypedText();
+    int getInputOffset() const; // Typed characters before the caller's input
     void setTestMode(TestMode mode);
     TestMode getTestMode() const;
     void setLessonType(LessonManager::LessonType type);
     void setLessonLevel(int level);
+    bool hasGeneratedText() const; // A Markov model is installed
+    void setCodeLanguage(int language); // SnippetIndex::Language
+    void setLoadedText(const QString &text); // For LOADED_TEXT_TEST; whitespace runs become single spaces
+    int getCodeLanguage() const;
+    QList<int> getCodeLanguages() const; // Languages with indexed snippets
+    // Row and finger lessons drill this layout's keys; standard passages come from its language's corpus
+    void setKeyboardLayout(KeyboardLayout::Layout layout);
+    KeyboardLayout::Layout getKeyboardLayout() const;
+    // Letter bigrams/trigrams by how often they are mistyped, strongest first
+    QHash<QString, float> getWeakNgrams() const;
     
     double getWPM() const;
     double getAccuracy() const;
+    // Raw, net, rolling and burst WPM and consistency, as of the last keystroke or timer tick
+    const SpeedSnapshot &getSpeedSnapshot() const;
+    // One snapshot per interval of the test; the interval doubles whenever the history fills up
+    const QVector<SpeedSnapshot> &getSpeedHistory() const;
+    int getSpeedHistoryInterval() const; // Seconds
     int getElapsedTime() const;
     int getProgress() const;
     bool isTestComplete() const;
     int getCorrectCharacters() const;
     int getTotalCharacters() const;
+    bool isLastCharacterCorrect() const; // The last typed character against the passage
+    // Characters mistyped at some point and correct now, including text an endless test retired
+    int getCorrectedErrors() const;
+    QVector<int> getErrorPositions() const; // Wrong characters of the current passage
+    // Per-character correctness of the current passage and input, for display and analysis
+    const CorrectnessMap &getCorrectness() const;
 
 public slots:
     void onTextChanged(const QString &text);
@@ -55,24 +105,36 @@ public slots:
 signals:
     void statsUpdated();
     void testCompleted();
+    void difficultyAdapted(float score);
 
 private slots:
     void updateTimer();
 
 private:
     void generateSampleText();
+    void extendPassage();
     void calculateStats();
-    QString getRandomSentence();
-    void initializeDifficultyTexts();
+    void finishTest();
+    void adaptDifficulty();
+    void recordKeystroke(int position, bool correct);
+    void updateCorrectness(int changedCluster);
+    PassageRequest currentPassageRequest() const;
     
     QTimer *timer;
     QElapsedTimer elapsedTimer;
     
-    QString sampleText;
-    QString currentInput;
+    // Characters are grapheme clusters, so accents and emoji count once and compare whole
+    PassageModel passage;
+    PassageModel typed;
+    CorrectnessMap correctness; // Typed clusters against the passage, updated from the first changed one
     
     int correctCharacters;
     int totalCharacters;
+    int retiredCharacters;        // Typed characters an endless test no longer keeps
+    int retiredCorrectCharacters;
+    int retiredCorrectedErrors;
+    int committedClusters;        // Typed clusters before the input, kept for scoring
+    int inputOffset;              // Their length in code units
     int wordsTyped;
     bool testActive;
     bool testComplete;
@@ -80,19 +142,45 @@ private:
     double currentWPM;
     double currentAccuracy;
     int currentTime;
+    SpeedTracker speedTracker;
+    SpeedSnapshot speed;
+    QVector<SpeedSnapshot> speedHistory;
+    int speedHistoryInterval; // Seconds per speedHistory entry
+    
+    SessionRandom random;  // Draws passage seeds once the session is seeded
+    bool seededSession;
+    quint64 passageSeed;
+    bool replayPending;    // passageSeed was set explicitly or drawn for a seeded test, and survives until it starts
+    SessionRandom chunkRandom; // Seeded with passageSeed; seeds the passages an endless test appends
     
     DifficultyLevel currentDifficulty;
-    QStringList easySentences;
-    QStringList mediumSentences;
-    QStringList hardSentences;
+    float difficultyScore;
+    bool adaptiveDifficulty;
+    QList<double> recentWPM; // Most recent last
+    
+    struct NgramStats {
+        float attempts;
+        float errors;
+    };
+    QHash<QString, NgramStats> ngramStats; // Decays after every test
     
     int testDuration; // Test duration in seconds
     TestMode currentTestMode;
     LessonManager::LessonType currentLessonType;
     int currentLessonLevel;
-    LessonManager *lessonManager;
+    int currentCodeLanguage;
+    QString loadedText;
+    KeyboardLayout::Layout currentKeyboardLayout;
+    PassageProvider *passageProvider;
     
-    static const int WORDS_PER_MINUTE_DIVISOR = 5; // Average word length
+    static const int ADAPTIVE_WINDOW = 5;          // Results the adaptive score averages over
+    static const int ADAPTIVE_MIN_WPM = 20;        // Speed mapped to score 0.0
+    static const int ADAPTIVE_MAX_WPM = 100;       // Speed mapped to score 1.0
+    static const int WEAK_NGRAM_COUNT = 12;        // N-grams handed to the weak letter pairs lesson
+    static const int ENDLESS_LOOKAHEAD = 400;      // Characters an endless test keeps ready past the cursor
+    static const int INPUT_KEPT_BEHIND = 120;      // Typed characters the input keeps behind the cursor
+    static const int INPUT_RETIRE_CHUNK = 200;     // Typed text leaves the input in steps of at least this
+    static const int SPEED_HISTORY_LIMIT = 600;    // Entries before the history halves its resolution
 };
 
 #endif // TYPINGTEST_H
\ No newline at end of file
@@ -10,14 +10,43 @@
  */
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include "ui/mainwindow.h"
+#include "core/startupprofile.h"
 
 int main(int argc, char *argv[])
 {
+    // Checked before QApplication exists so its construction is part of the profile
+    bool profileStartup = false;
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--startup-profile") == 0) {
+            profileStartup = true;
+        }
+    }
+    StartupProfile::start(profileStartup);
+    
     QApplication app(argc, argv);
+    StartupProfile::mark("create application");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Typing speed test and training application.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("startup-profile", "Print per-phase startup timings to stderr."));
+    QCommandLineOption seedOption("seed", "Generate every passage of the session from <seed>, so it can be reproduced.", "seed");
+    parser.addOption(seedOption);
+    parser.process(app);
     
     MainWindow window;
+    if (parser.isSet(seedOption)) {
+        bool ok = false;
+        const quint64 seed = parser.value(seedOption).toULongLong(&ok);
+        if (!ok) {
+            parser.showHelp(1);
+        }
+        window.setSessionSeed(seed);
+    }
     window.show();
+    StartupProfile::mark("show window");
     
     return app.exec();
 }
\ No newline at end of file
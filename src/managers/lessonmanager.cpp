@@ -1,162 +1,406 @@
 #include "lessonmanager.h"
+#include "../core/corpus.h"
+#include "../core/ngramindex.h"
+#include "lessondata.h"
+#include <QSet>
+#include <QThread>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+
+// Lesson tables are generated from data/lessons.def in LessonType order
+#define CHECK_LESSON(type) \
+    static_assert(LessonData::LESSONS[LessonManager::type].id == #type, "data/lessons.def: " #type " is out of order")
+CHECK_LESSON(HOME_ROW);
+CHECK_LESSON(TOP_ROW);
+CHECK_LESSON(BOTTOM_ROW);
+CHECK_LESSON(NUMBERS);
+CHECK_LESSON(PUNCTUATION);
+CHECK_LESSON(COMMON_WORDS);
+CHECK_LESSON(FINGER_SPECIFIC);
+CHECK_LESSON(BIGRAMS);
+CHECK_LESSON(TRIGRAMS);
+CHECK_LESSON(PROGRAMMING);
+CHECK_LESSON(WEAK_NGRAMS);
+#undef CHECK_LESSON
+static_assert(LessonData::LESSON_COUNT == LessonManager::WEAK_NGRAMS + 1, "data/lessons.def needs one section per lesson type");
+
+namespace {
+
+QString toQString(std::string_view text)
+{
+    return QString::fromUtf8(text.data(), static_cast<int>(text.size()));
+}
+
+const LessonData::Lesson *findLesson(LessonManager::LessonType type)
+{
+    return type >= 0 && type < LessonData::LESSON_COUNT ? &LessonData::LESSONS[type] : nullptr;
+}
+
+QStringList lessonItems(LessonManager::LessonType type)
+{
+    QStringList items;
+    if (const LessonData::Lesson *lesson = findLesson(type)) {
+        items.reserve(lesson->itemCount);
+        for (int i = 0; i < lesson->itemCount; ++i) {
+            items << toQString(lesson->items[i]);
+        }
+    }
+    return items;
+}
+
+// Keys a row or finger lesson drills at each level on a layout, or empty when the lesson does not drill keys
+QString progressiveCharacters(LessonManager::LessonType type, int level, KeyboardLayout::Layout layout)
+{
+    static const int ROW_LESSON_KEYS = 10; // The home fingers' columns plus the index stretches
+    static const int ROW_KEYS[3][4] = {
+        {4, 6, 8, 9}, // asdf, asdfgh, asdfghjk, asdfghjkl (on QWERTY)
+        {4, 6, 8, 9}, // qwer, qwerty, qwertyui, qwertyuio
+        {4, 6, 7, 8}  // zxcv, zxcvbn, zxcvbnm, zxcvbnm,
+    };
+    static const KeyboardLayout::Row ROWS[3] = {KeyboardLayout::HOME_ROW, KeyboardLayout::TOP_ROW, KeyboardLayout::BOTTOM_ROW};
+    // Finger lessons take one pair per level, strongest first, then all four
+    static const KeyboardLayout::Finger FINGER_PAIRS[4][2] = {
+        {KeyboardLayout::LEFT_INDEX, KeyboardLayout::RIGHT_INDEX},
+        {KeyboardLayout::LEFT_MIDDLE, KeyboardLayout::RIGHT_MIDDLE},
+        {KeyboardLayout::LEFT_RING, KeyboardLayout::RIGHT_RING},
+        {KeyboardLayout::LEFT_PINKY, KeyboardLayout::RIGHT_PINKY}
+    };
+    if (level < 1 || level > 5) {
+        return QString();
+    }
+    if (type == LessonManager::FINGER_SPECIFIC) {
+        QString characters;
+        for (int pair = level == 5 ? 0 : level - 1; pair < (level == 5 ? 4 : level); ++pair) {
+            characters += KeyboardLayout::getFingerKeys(layout, FINGER_PAIRS[pair][0]);
+            characters += KeyboardLayout::getFingerKeys(layout, FINGER_PAIRS[pair][1]);
+        }
+        return characters;
+    }
+    if (type > LessonManager::BOTTOM_ROW) {
+        return QString();
+    }
+    const QString characters = KeyboardLayout::getRowKeys(layout, ROWS[type]).left(ROW_LESSON_KEYS);
+    return level == 5 ? characters : characters.left(ROW_KEYS[type][level - 1]);
+}
+
+// Membership test for a drill's keys; text outside Latin-1 is never on a layout
+class KeySet
+{
+public:
+    explicit KeySet(const QString &characters)
+    {
+        for (QChar character : characters) {
+            if (character.unicode() < 256) {
+                keys.set(character.unicode());
+            }
+        }
+    }
+    
+    bool accepts(const QString &text) const
+    {
+        for (QChar character : text) {
+            if (character.unicode() >= 256 || !keys.test(character.unicode())) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+private:
+    std::bitset<256> keys;
+};
+
+// Random characters with a space after every fourth one past the first five. A 16-bit lane
+// per character maps to the table by (lane * size) >> 16, which has no branch (so the lookup
+// loop vectorizes) and a bias below size / 65536.
+void appendCharacterDrill(QString &out, const QString &characters, int length, SessionRandom &random)
+{
+    const int size = characters.length();
+    if (size == 0 || length <= 0) {
+        return;
+    }
+    
+    QVarLengthArray<quint16, 256> lanes((length + 3) & ~3);
+    for (int i = 0; i < lanes.size(); i += 4) {
+        const quint64 bits = random.generate64();
+        lanes[i] = static_cast<quint16>(bits);
+        lanes[i + 1] = static_cast<quint16>(bits >> 16);
+        lanes[i + 2] = static_cast<quint16>(bits >> 32);
+        lanes[i + 3] = static_cast<quint16>(bits >> 48);
+    }
+    
+    QVarLengthArray<QChar, 256> letters(length);
+    const QChar *table = characters.constData();
+    for (int i = 0; i < length; ++i) {
+        letters[i] = table[(static_cast<quint32>(lanes[i]) * static_cast<quint32>(size)) >> 16];
+    }
+    
+    const int spaces = length > 2 ? (length - 2) / 4 : 0;
+    const int start = out.size();
+    out.resize(start + length + spaces);
+    QChar *write = out.data() + start;
+    int copied = qMin(length, 5);
+    std::copy(letters.constData(), letters.constData() + copied, write);
+    write += copied;
+    while (copied < length) {
+        const int group = qMin(4, length - copied);
+        *write++ = QLatin1Char(' ');
+        std::copy(letters.constData() + copied, letters.constData() + copied + group, write);
+        write += group;
+        copied += group;
+    }
+}
+
+void appendWordDrill(QString &out, const QStringList &words, int count, SessionRandom &random)
+{
+    for (int i = 0; i < count && !words.isEmpty(); ++i) {
+        if (i > 0) {
+            out += QLatin1Char(' ');
+        }
+        out += words[random.bounded(words.size())];
+    }
+}
+
+// Pairs separated by spaces until the drill reaches length
+void appendPairDrill(QString &out, const QStringList &pairs, int length, SessionRandom &random)
+{
+    const int start = out.size();
+    while (out.size() - start < length && !pairs.isEmpty()) {
+        if (out.size() > start) {
+            out += QLatin1Char(' ');
+        }
+        out += pairs[random.bounded(pairs.size())];
+    }
+}
+
+// Random elements separated by spaces, stopping at the first one that would pass totalLength
+void appendLesson(QString &out, const QStringList &elements, int totalLength, SessionRandom &random)
+{
+    int currentLength = 0;
+    while (currentLength < totalLength && !elements.isEmpty()) {
+        const QString &element = elements[random.bounded(elements.size())];
+        if (currentLength + element.length() + 1 > totalLength) {
+            break;
+        }
+        if (currentLength > 0) {
+            out += QLatin1Char(' ');
+            ++currentLength;
+        }
+        out += element;
+        currentLength += element.length();
+    }
+}
+
+// Everything getProgressiveLesson looks up for a type and level, resolved once per batch
+struct DrillPlan {
+    enum Kind {
+        CHARACTERS,
+        WORDS,
+        PAIRS,
+        ELEMENTS
+    };
+    
+    Kind kind;
+    QString characters;
+    QStringList items;
+    int length; // Characters, or words for WORDS
+    
+    DrillPlan(LessonManager::LessonType type, int level, KeyboardLayout::Layout layout)
+        : kind(ELEMENTS)
+        , characters(progressiveCharacters(type, level, layout))
+        , length(20 + (level - 1) * 10) // 20, 30, 40, 50, 60 characters
+    {
+        if (!characters.isEmpty()) {
+            kind = CHARACTERS;
+        } else if (type == LessonManager::COMMON_WORDS) {
+            kind = WORDS;
+            items = lessonItems(type).mid(0, level * 10);
+            length /= 4;
+        } else if (type == LessonManager::BIGRAMS || type == LessonManager::WEAK_NGRAMS) {
+            kind = PAIRS; // WEAK_NGRAMS until mistakes have been recorded
+            items = lessonItems(LessonManager::BIGRAMS).mid(0, level * 5);
+        } else {
+            items = lessonItems(type);
+        }
+    }
+    
+    void append(QString &out, SessionRandom &random) const
+    {
+        switch (kind) {
+            case CHARACTERS:
+                appendCharacterDrill(out, characters, length, random);
+                break;
+            case WORDS:
+                appendWordDrill(out, items, length, random);
+                break;
+            case PAIRS:
+                appendPairDrill(out, items, length, random);
+                break;
+            case ELEMENTS:
+                appendLesson(out, items, length, random);
+                break;
+        }
+    }
+    
+    // Upper bound on a drill's length, so a batch buffer is allocated once
+    int maximumLength() const
+    {
+        int longest = 0;
+        for (const QString &item : items) {
+            longest = qMax(longest, item.length());
+        }
+        switch (kind) {
+            case CHARACTERS:
+                return length + length / 4;
+            case WORDS:
+                return length * (longest + 1);
+            case PAIRS:
+                return length + longest + 1;
+            case ELEMENTS:
+                break;
+        }
+        return length;
+    }
+};
+
+}
 
 LessonManager::LessonManager(QObject *parent)
     : QObject(parent)
+    , random(SessionRandom::systemSeed())
+    , layout(KeyboardLayout::QWERTY)
+{
+}
+
+void LessonManager::setSeed(quint64 seed)
+{
+    random.setSeed(seed);
+}
+
+quint64 LessonManager::getSeed() const
+{
+    return random.getSeed();
+}
+
+void LessonManager::setKeyboardLayout(KeyboardLayout::Layout keyboardLayout)
+{
+    layout = keyboardLayout;
+}
+
+KeyboardLayout::Layout LessonManager::getKeyboardLayout() const
 {
-    // Initialize character sets
-    homeRowChars = "asdfghjkl;";
-    topRowChars = "qwertyuiop";
-    bottomRowChars = "zxcvbnm,./";
-    numberChars = "1234567890";
-    punctuationChars = ".,;:!?'\"";
-    programmingChars = "(){}[]<>=+-*/\\|&%$#@";
-    
-    initializeLessons();
-}
-
-void LessonManager::initializeLessons()
-{
-    // Common words for practice
-    commonWords << "the" << "and" << "for" << "are" << "but" << "not" << "you" << "all"
-               << "can" << "had" << "her" << "was" << "one" << "our" << "out" << "day"
-               << "get" << "has" << "him" << "his" << "how" << "man" << "new" << "now"
-               << "old" << "see" << "two" << "way" << "who" << "boy" << "did" << "its"
-               << "let" << "put" << "say" << "she" << "too" << "use" << "what" << "when"
-               << "where" << "which" << "with" << "have" << "this" << "will" << "your"
-               << "from" << "they" << "know" << "want" << "been" << "good" << "much"
-               << "some" << "time" << "very" << "when" << "come" << "here" << "just"
-               << "like" << "long" << "make" << "many" << "over" << "such" << "take"
-               << "than" << "them" << "well" << "were";
-    
-    // Common bigrams (two-letter combinations)
-    commonBigrams << "th" << "he" << "in" << "er" << "an" << "re" << "ed" << "nd"
-                 << "on" << "en" << "at" << "ou" << "it" << "is" << "or" << "ti"
-                 << "hi" << "st" << "ar" << "ne" << "ng" << "al" << "se" << "to"
-                 << "as" << "de" << "rt" << "ve" << "te" << "es" << "le" << "nt";
-    
-    // Common trigrams (three-letter combinations)
-    commonTrigrams << "the" << "and" << "ing" << "her" << "hat" << "his" << "tha"
-                  << "ere" << "for" << "ent" << "ion" << "ter" << "was" << "you"
-                  << "ith" << "ver" << "all" << "wit" << "thi" << "tio" << "end";
-    
-    // Set up lesson titles
-    lessonTitles[HOME_ROW] = "Home Row Keys";
-    lessonTitles[TOP_ROW] = "Top Row Keys";
-    lessonTitles[BOTTOM_ROW] = "Bottom Row Keys";
-    lessonTitles[NUMBERS] = "Number Practice";
-    lessonTitles[PUNCTUATION] = "Punctuation Practice";
-    lessonTitles[COMMON_WORDS] = "Common Words";
-    lessonTitles[FINGER_SPECIFIC] = "Finger-Specific Training";
-    lessonTitles[BIGRAMS] = "Letter Pairs (Bigrams)";
-    lessonTitles[TRIGRAMS] = "Letter Combinations (Trigrams)";
-    lessonTitles[PROGRAMMING] = "Programming Characters";
-    
-    // Set up lesson descriptions
-    lessonDescriptions[HOME_ROW] = "Practice the foundation keys: a s d f g h j k l ;";
-    lessonDescriptions[TOP_ROW] = "Master the top row: q w e r t y u i o p";
-    lessonDescriptions[BOTTOM_ROW] = "Learn the bottom row: z x c v b n m , . /";
-    lessonDescriptions[NUMBERS] = "Number typing practice: 1 2 3 4 5 6 7 8 9 0";
-    lessonDescriptions[PUNCTUATION] = "Common punctuation marks and symbols";
-    lessonDescriptions[COMMON_WORDS] = "Most frequently used English words";
-    lessonDescriptions[FINGER_SPECIFIC] = "Targeted exercises for each finger";
-    lessonDescriptions[BIGRAMS] = "Common two-letter combinations";
-    lessonDescriptions[TRIGRAMS] = "Common three-letter patterns";
-    lessonDescriptions[PROGRAMMING] = "Special characters used in programming";
-    
-    // Initialize lesson content
-    lessonContent[HOME_ROW] << "asdf" << "jkl;" << "fjfj" << "dkdk" << "slsl" << "a;a;"
-                           << "asdf jkl;" << "fjdk slgh" << "asdfjkl;" << "glad" << "hall"
-                           << "fall" << "ask" << "flask" << "glass" << "fast" << "last";
-    
-    lessonContent[TOP_ROW] << "qwer" << "tyui" << "op" << "quip" << "tire" << "wire"
-                          << "quit" << "were" << "power" << "tower" << "quote" << "write"
-                          << "quite" << "poetry" << "typewriter" << "query" << "worry";
-    
-    lessonContent[BOTTOM_ROW] << "zxcv" << "bnm" << ",./" << "zoom" << "next" << "come"
-                             << "move" << "bronze" << "complex" << "maximum" << "examine"
-                             << "example" << "mixture" << "boxing" << "frozen" << "dozen";
-    
-    lessonContent[NUMBERS] << "123" << "456" << "789" << "0" << "12345" << "67890"
-                          << "1234567890" << "123 456 789" << "1 2 3 4 5" << "6 7 8 9 0";
-    
-    lessonContent[PUNCTUATION] << ".,;" << ":!?" << "'\"" << "Hello, world!" << "Yes; no."
-                              << "What? Why!" << "I said, \"Hello.\"" << "Can't you see?"
-                              << "It's great!" << "Time: 3:30" << "Cost: $10.50";
-    
-    lessonContent[PROGRAMMING] << "()" << "{}" << "[]" << "<>" << "=+" << "-*" << "/\\"
-                              << "|&" << "%$" << "#@" << "if (x == y)" << "array[i]"
-                              << "function() {}" << "x += y;" << "return true;"
-                              << "#include <stdio.h>" << "var x = 10;" << "print(\"hello\");";
+    return layout;
+}
+
+QString LessonManager::getLessonKeys(LessonType type, int level) const
+{
+    return progressiveCharacters(type, level, layout);
 }
 
 QString LessonManager::getLessonText(LessonType type, int length)
 {
-    if (!lessonContent.contains(type)) {
+    const LessonData::Lesson *lesson = findLesson(type);
+    const QString keys = progressiveCharacters(type, 5, layout);
+    if (!lesson || (lesson->itemCount == 0 && keys.isEmpty())) {
         return "Lesson type not found.";
     }
     
-    QStringList content = lessonContent[type];
-    return formatLesson(content, length);
+    QStringList items = lessonItems(type);
+    if (!keys.isEmpty() && layout != KeyboardLayout::QWERTY) {
+        // Practice items are written for QWERTY; other layouts keep those their lesson keys can type
+        const KeySet typeable(keys + QLatin1Char(' '));
+        items.erase(std::remove_if(items.begin(), items.end(), [&](const QString &item) {
+            return !typeable.accepts(item);
+        }), items.end());
+        if (items.isEmpty()) {
+            return generateRandomString(keys, length);
+        }
+    }
+    return formatLesson(items, length);
 }
 
 QString LessonManager::getLessonTitle(LessonType type)
 {
-    return lessonTitles.value(type, "Unknown Lesson");
+    const LessonData::Lesson *lesson = findLesson(type);
+    return lesson ? toQString(lesson->title) : "Unknown Lesson";
 }
 
 QString LessonManager::getLessonDescription(LessonType type)
 {
-    return lessonDescriptions.value(type, "No description available.");
+    const LessonData::Lesson *lesson = findLesson(type);
+    return lesson ? toQString(lesson->description) : "No description available.";
 }
 
 QList<LessonManager::LessonType> LessonManager::getAllLessonTypes()
 {
     return {HOME_ROW, TOP_ROW, BOTTOM_ROW, NUMBERS, PUNCTUATION, 
-            COMMON_WORDS, FINGER_SPECIFIC, BIGRAMS, TRIGRAMS, PROGRAMMING};
+            COMMON_WORDS, FINGER_SPECIFIC, BIGRAMS, TRIGRAMS, PROGRAMMING, WEAK_NGRAMS};
 }
 
 QString LessonManager::getProgressiveLesson(LessonType type, int level)
 {
     // Progressive difficulty: start simple, add complexity
-    int baseLength = 20 + (level - 1) * 10; // 20, 30, 40, 50, 60 characters
-    
-    switch (type) {
-        case HOME_ROW:
-            switch (level) {
-                case 1: return generateCharacterDrill("asdf", baseLength);
-                case 2: return generateCharacterDrill("asdfgh", baseLength);
-                case 3: return generateCharacterDrill("asdfghjk", baseLength);
-                case 4: return generateCharacterDrill("asdfghjkl", baseLength);
-                case 5: return generateCharacterDrill(homeRowChars, baseLength);
-            }
-            break;
-        case TOP_ROW:
-            switch (level) {
-                case 1: return generateCharacterDrill("qwer", baseLength);
-                case 2: return generateCharacterDrill("qwerty", baseLength);
-                case 3: return generateCharacterDrill("qwertyui", baseLength);
-                case 4: return generateCharacterDrill("qwertyuio", baseLength);
-                case 5: return generateCharacterDrill(topRowChars, baseLength);
-            }
-            break;
-        case BOTTOM_ROW:
-            switch (level) {
-                case 1: return generateCharacterDrill("zxcv", baseLength);
-                case 2: return generateCharacterDrill("zxcvbn", baseLength);
-                case 3: return generateCharacterDrill("zxcvbnm", baseLength);
-                case 4: return generateCharacterDrill("zxcvbnm,", baseLength);
-                case 5: return generateCharacterDrill(bottomRowChars, baseLength);
-            }
-            break;
-        case COMMON_WORDS:
-            return generateWordDrill(commonWords.mid(0, level * 10), baseLength / 4);
-        case BIGRAMS:
-            return generateBigramDrill(commonBigrams.mid(0, level * 5), baseLength);
-        default:
-            return getLessonText(type, baseLength);
+    const DrillPlan plan(type, level, layout);
+    QString result;
+    plan.append(result, random);
+    return result.isEmpty() ? getLessonText(type, plan.length) : result;
+}
+
+DrillBatch LessonManager::generateDrillBatch(LessonType type, int level, int count, quint64 seed,
+                                             KeyboardLayout::Layout layout)
+{
+    DrillBatch batch;
+    if (count <= 0) {
+        return batch;
     }
     
-    return getLessonText(type, baseLength);
+    const DrillPlan plan(type, level, layout);
+    SessionRandom random(seed);
+    batch.text.reserve(count * plan.maximumLength());
+    batch.offsets.reserve(count + 1);
+    batch.offsets.append(0);
+    for (int i = 0; i < count; ++i) {
+        plan.append(batch.text, random);
+        batch.offsets.append(batch.text.size());
+    }
+    return batch;
+}
+
+QVector<DrillBatch> LessonManager::generateWorkbook(const QList<LessonType> &types, int level, int drillsPerType, quint64 seed,
+                                                    KeyboardLayout::Layout layout)
+{
+    QVector<DrillBatch> batches(types.size());
+    QVector<quint64> seeds(types.size());
+    SessionRandom seedSource(seed);
+    for (quint64 &typeSeed : seeds) {
+        typeSeed = seedSource.generate64();
+    }
+    
+    // Lesson types are independent, so workers take the next one until none are left
+    DrillBatch *results = batches.data();
+    std::atomic<int> next(0);
+    auto work = [&]() {
+        for (int i = next++; i < types.size(); i = next++) {
+            results[i] = generateDrillBatch(types[i], level, drillsPerType, seeds[i], layout);
+        }
+    };
+    
+    const int workerCount = qMin(QThread::idealThreadCount(), static_cast<int>(types.size())) - 1; // Plus this thread
+    QVector<QThread *> workers;
+    for (int i = 0; i < workerCount; ++i) {
+        QThread *worker = QThread::create(work);
+        worker->setObjectName("DrillWorker");
+        worker->start();
+        workers.append(worker);
+    }
+    work();
+    for (QThread *worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+    return batches;
 }
 
 QString LessonManager::generateCharacterDrill(const QString &characters, int length)
@@ -166,59 +410,100 @@ QString LessonManager::generateCharacterDrill(const QString &characters, int len
 
 QString LessonManager::generateWordDrill(const QStringList &words, int count)
 {
-    QStringList result;
-    for (int i = 0; i < count; ++i) {
-        int index = QRandomGenerator::global()->bounded(words.size());
-        result << words[index];
-    }
-    return result.join(" ");
+    QString result;
+    appendWordDrill(result, words, count, random);
+    return result;
 }
 
 QString LessonManager::generateBigramDrill(const QStringList &bigrams, int length)
 {
     QString result;
-    while (result.length() < length) {
-        int index = QRandomGenerator::global()->bounded(bigrams.size());
-        result += bigrams[index] + " ";
-    }
-    return result.trimmed();
+    result.reserve(length + 8);
+    appendPairDrill(result, bigrams, length, random);
+    return result;
 }
 
-QString LessonManager::generateRandomString(const QString &chars, int length)
+QString LessonManager::generateNgramDrill(const NgramIndex &index, const QHash<QString, float> &weights, int length)
 {
+    const QVector<quint32> candidates = index.findSentences(weights, NGRAM_CANDIDATES);
+    if (candidates.isEmpty()) {
+        QStringList ngrams = weights.keys();
+        return generateBigramDrill(ngrams.isEmpty() ? lessonItems(BIGRAMS) : ngrams, length / 2);
+    }
+    
     QString result;
-    for (int i = 0; i < length; ++i) {
-        int index = QRandomGenerator::global()->bounded(chars.length());
-        result += chars[index];
-        
-        // Add spaces occasionally for readability
-        if (i > 0 && i % 4 == 0 && i < length - 1) {
+    while (result.length() < length) {
+        // Lean towards the densest matches while still varying the text
+        const int pick = qMin(random.bounded(candidates.size()),
+                              random.bounded(candidates.size()));
+        const QString sentence = index.getSentence(candidates[pick]);
+        if (sentence.isEmpty()) {
+            break;
+        }
+        if (!result.isEmpty()) {
             result += " ";
         }
+        result += sentence;
     }
     return result;
 }
 
-QString LessonManager::formatLesson(const QStringList &elements, int totalLength)
+QString LessonManager::generateKeyWordDrill(const Corpus *corpus, LessonType type, int level, int length)
 {
-    QString result;
-    int currentLength = 0;
+    const QString keys = progressiveCharacters(type, level, layout);
+    if (keys.isEmpty()) {
+        return QString();
+    }
     
-    while (currentLength < totalLength && !elements.isEmpty()) {
-        int index = QRandomGenerator::global()->bounded(elements.size());
-        QString element = elements[index];
-        
-        if (currentLength + element.length() + 1 <= totalLength) {
-            if (!result.isEmpty()) {
-                result += " ";
-                currentLength++;
+    // Words of two letters or more, in the order first found so a seed reproduces the drill
+    const KeySet typeable(keys);
+    QStringList words;
+    QSet<QString> seen;
+    auto collect = [&](const QString &sentence) {
+        for (const QString &word : sentence.split(QLatin1Char(' '))) {
+            if (word.length() > 1 && typeable.accepts(word) && !seen.contains(word)) {
+                seen.insert(word);
+                words.append(word);
+            }
+        }
+    };
+    
+    if (corpus && corpus->isOpen()) {
+        for (int draw = 0; draw < KEY_WORD_DRAWS && words.size() < KEY_WORD_TARGET; ++draw) {
+            const int difficulty = random.bounded(Corpus::DIFFICULTY_COUNT);
+            if (corpus->getSentenceCount(difficulty) > 0) {
+                collect(corpus->getRandomSentence(difficulty, random));
+            }
+        }
+    } else {
+        for (int set = 0; set < LessonData::SENTENCE_SET_COUNT; ++set) {
+            const LessonData::SentenceSet &sentences = LessonData::SENTENCE_SETS[set];
+            for (int i = 0; i < sentences.count; ++i) {
+                collect(toQString(sentences.sentences[i]));
             }
-            result += element;
-            currentLength += element.length();
-        } else {
-            break;
         }
     }
     
+    if (words.size() < KEY_WORD_MINIMUM) {
+        return QString();
+    }
+    QString result;
+    result.reserve(length + 16);
+    appendPairDrill(result, words, length, random);
     return result;
-}
\ No newline at end of file
+}
+
+QString LessonManager::generateRandomString(const QString &chars, int length)
+{
+    QString result;
+    appendCharacterDrill(result, chars, length, random);
+    return result;
+}
+
+QString LessonManager::formatLesson(const QStringList &elements, int totalLength)
+{
+    QString result;
+    result.reserve(totalLength);
+    appendLesson(result, elements, totalLength, random);
+    return result;
+}
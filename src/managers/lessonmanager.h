@@ -3,8 +3,22 @@
 
 #include <QObject>
 #include <QStringList>
-#include <QMap>
-#include <QRandomGenerator>
+#include <QHash>
+#include <QVector>
+#include "../core/keyboardlayout.h"
+#include "../core/sessionrandom.h"
+
+class Corpus;
+class NgramIndex;
+
+// Many drills in one buffer; drill i is text[offsets[i], offsets[i + 1])
+struct DrillBatch {
+    QString text;
+    QVector<int> offsets;
+
+    int size() const { return offsets.isEmpty() ? 0 : offsets.size() - 1; }
+    QString getDrill(int index) const { return text.mid(offsets[index], offsets[index + 1] - offsets[index]); }
+};
 
 class LessonManager : public QObject
 {
@@ -12,20 +26,31 @@ class LessonManager : public QObject
 
 public:
     enum LessonType {
-        HOME_ROW,           // asdf jkl;
+        HOME_ROW,           // asdf jkl; (keys follow the keyboard layout)
         TOP_ROW,            // qwerty uiop
         BOTTOM_ROW,         // zxcv bnm
         NUMBERS,            // 1234567890
         PUNCTUATION,        // .,;'[]
         COMMON_WORDS,       // the, and, for, etc.
-        FINGER_SPECIFIC,    // exercises for specific fingers
+        FINGER_SPECIFIC,    // one finger pair's keys per level
         BIGRAMS,            // common letter pairs (th, er, in)
         TRIGRAMS,           // common 3-letter combinations (the, and, ing)
-        PROGRAMMING         // programming-specific characters
+        PROGRAMMING,        // programming-specific characters
+        WEAK_NGRAMS         // real sentences dense in the user's most mistyped letter pairs
     };
 
     explicit LessonManager(QObject *parent = nullptr);
     
+    // Every drill draws from this seed, so the same seed reproduces the same text
+    void setSeed(quint64 seed);
+    quint64 getSeed() const;
+    
+    // Row and finger lessons drill this layout's keys
+    void setKeyboardLayout(KeyboardLayout::Layout layout);
+    KeyboardLayout::Layout getKeyboardLayout() const;
+    // Keys a row or finger lesson drills at a level on the current layout; empty for other lessons
+    QString getLessonKeys(LessonType type, int level) const;
+    
     // Lesson management
     QString getLessonText(LessonType type, int length = 50);
     QString getLessonTitle(LessonType type);
@@ -35,32 +60,35 @@ public:
     // Progressive difficulty
     QString getProgressiveLesson(LessonType type, int level); // level 1-5
     
+    // Bulk progressive drills for workbooks and exam sets, in one preallocated buffer.
+    // Shares no state, so any thread may call it; the same seed gives the same batch.
+    static DrillBatch generateDrillBatch(LessonType type, int level, int count, quint64 seed,
+                                         KeyboardLayout::Layout layout = KeyboardLayout::QWERTY);
+    // One batch per lesson type (batch i is for types[i]), generated in parallel
+    static QVector<DrillBatch> generateWorkbook(const QList<LessonType> &types, int level, int drillsPerType, quint64 seed,
+                                                KeyboardLayout::Layout layout = KeyboardLayout::QWERTY);
+    
     // Custom exercises
     QString generateCharacterDrill(const QString &characters, int length = 30);
     QString generateWordDrill(const QStringList &words, int count = 10);
     QString generateBigramDrill(const QStringList &bigrams, int length = 40);
+    // Corpus sentences richest in the weighted bigrams/trigrams; plain pair drills without an index
+    QString generateNgramDrill(const NgramIndex &index, const QHash<QString, float> &weights, int length = 150);
+    // Real words that use only a row or finger lesson's keys, from corpus sentences (the built-in
+    // sentences without an open corpus); empty when too few words qualify
+    QString generateKeyWordDrill(const Corpus *corpus, LessonType type, int level, int length = 120);
 
 private:
-    void initializeLessons();
+    static const int NGRAM_CANDIDATES = 24; // Best matches an n-gram drill samples from
+    static const int KEY_WORD_DRAWS = 400;  // Corpus sentences a key word drill searches at most
+    static const int KEY_WORD_TARGET = 40;  // Distinct words it stops searching at
+    static const int KEY_WORD_MINIMUM = 4;  // Fewer distinct words than this make no drill
+    
     QString generateRandomString(const QString &chars, int length);
     QString formatLesson(const QStringList &elements, int totalLength);
     
-    QMap<LessonType, QStringList> lessonContent;
-    QMap<LessonType, QString> lessonTitles;
-    QMap<LessonType, QString> lessonDescriptions;
-    
-    // Character sets for different rows
-    QString homeRowChars;
-    QString topRowChars;
-    QString bottomRowChars;
-    QString numberChars;
-    QString punctuationChars;
-    QString programmingChars;
-    
-    // Common patterns
-    QStringList commonWords;
-    QStringList commonBigrams;
-    QStringList commonTrigrams;
+    SessionRandom random;
+    KeyboardLayout::Layout layout;
 };
 
 #endif // LESSONMANAGER_H
\ No newline at end of file
@@ -1,8 +1,53 @@
 #include "soundmanager.h"
+#include "../audio/soundpattern.h"
 #include <QDebug>
 #include <QApplication>
 
-SoundManager::SoundManager(QObject *parent)
+namespace {
+
+// File names (without extension) looked up in a sound pack, indexed by SoundType
+const char *SOUND_NAMES[] = {
+    "keystroke_correct",
+    "keystroke_incorrect",
+    "test_start",
+    "test_complete",
+    "level_up",
+    "achievement",
+    "tick",
+    "warning"
+};
+
+// Melodies in the sequencer's pattern format (see soundpattern.h)
+const char *LEVEL_UP_PATTERN = "440:100 550:100 660:150";         // Quick ascending sequence
+const char *ACHIEVEMENT_PATTERN = "880:100 1100:100 880:100 1320:200"; // Celebration sequence
+
+// Parsed once and never freed, so the audio thread can hold pointers to them
+const SoundPattern *builtInPattern(SoundManager::SoundType type)
+{
+    static const SoundPattern levelUp = [] {
+        SoundPattern pattern;
+        SoundPattern::parse(LEVEL_UP_PATTERN, pattern);
+        return pattern;
+    }();
+    static const SoundPattern achievement = [] {
+        SoundPattern pattern;
+        SoundPattern::parse(ACHIEVEMENT_PATTERN, pattern);
+        return pattern;
+    }();
+
+    switch (type) {
+        case SoundManager::LEVEL_UP:
+            return &levelUp;
+        case SoundManager::ACHIEVEMENT:
+            return &achievement;
+        default:
+            return nullptr;
+    }
+}
+
+}
+
+SoundManager::SoundManager(QObject *parent, AudioEngine::OutputMode outputMode)
     : QObject(parent)
     , correctKeystroke(nullptr)
     , incorrectKeystroke(nullptr)
@@ -15,15 +60,23 @@ SoundManager::SoundManager(QObject *parent)
     , soundEnabled(true)
     , keystrokeSoundsEnabled(false) // Default to off to avoid annoyance
     , currentVolume(0.5)
+    , audioEngine(new AudioEngine(outputMode, this))
+    , soundBank(new SoundBank(this))
+    , activePackName(SoundBank::DEFAULT_PACK)
     , beepTimer(new QTimer(this))
     , beepFrequency(440)
     , beepDuration(100)
 {
+    connect(audioEngine, &AudioEngine::outputStarted, this, &SoundManager::audioReady);
     initializeSounds();
 }
 
 SoundManager::~SoundManager()
 {
+    // Stop the audio thread before the sound bank releases the samples it may be playing
+    delete audioEngine;
+    audioEngine = nullptr;
+    
     // QSoundEffect objects will be cleaned up by Qt's parent-child system
 }
 
@@ -51,6 +104,13 @@ void SoundManager::initializeSounds()
     
     // Try to load sound files from resources or create programmatic sounds
     createProgrammaticSounds();
+    
+    // Decode any sound packs in the background; until they arrive, tones are synthesized
+    connect(soundBank, &SoundBank::loaded, this, [this]() {
+        setSoundPack(activePackName);
+        emit soundPacksLoaded();
+    });
+    soundBank->loadDirectory(getResourcePath(), AudioStream::SAMPLE_RATE);
 }
 
 void SoundManager::createProgrammaticSounds()
@@ -76,17 +136,14 @@ void SoundManager::createProgrammaticSounds()
 
 QString SoundManager::getResourcePath()
 {
-    // Get the application's resource directory
-    QString appDir = QApplication::applicationDirPath();
-    QDir resourceDir(appDir);
-    resourceDir.cd("sounds"); // Look for a sounds subdirectory
-    
-    if (resourceDir.exists()) {
+    // Look for a sounds subdirectory next to the application
+    QDir resourceDir(QApplication::applicationDirPath());
+    if (resourceDir.cd("sounds")) {
         return resourceDir.absolutePath();
     }
     
-    // Fallback to application directory
-    return appDir;
+    // No sound assets installed
+    return QString();
 }
 
 void SoundManager::playSound(SoundType type)
@@ -99,49 +156,42 @@ void SoundManager::playSound(SoundType type)
         case KEYSTROKE_CORRECT:
             if (!keystrokeSoundsEnabled) return;
             soundToPlay = correctKeystroke;
-            generateBeep(800, 50); // High pitch, short duration
+            postTone(type, 800, 50); // High pitch, short duration
             break;
         case KEYSTROKE_INCORRECT:
             if (!keystrokeSoundsEnabled) return;
             soundToPlay = incorrectKeystroke;
-            generateBeep(300, 100); // Low pitch, longer duration
+            postTone(type, 300, 100); // Low pitch, longer duration
             break;
         case TEST_START:
             soundToPlay = testStart;
-            generateBeep(660, 200); // Medium pitch, medium duration
+            postTone(type, 660, 200); // Medium pitch, medium duration
             break;
         case TEST_COMPLETE:
             soundToPlay = testComplete;
-            generateBeep(880, 300); // High pitch, long duration
+            postTone(type, 880, 300); // High pitch, long duration
             break;
         case LEVEL_UP:
             soundToPlay = levelUp;
-            // Play a quick ascending sequence
-            QTimer::singleShot(0, [this]() { generateBeep(440, 100); });
-            QTimer::singleShot(100, [this]() { generateBeep(550, 100); });
-            QTimer::singleShot(200, [this]() { generateBeep(660, 150); });
+            postPattern(type, builtInPattern(LEVEL_UP));
             return;
         case ACHIEVEMENT:
             soundToPlay = achievement;
-            // Play a celebration sequence
-            QTimer::singleShot(0, [this]() { generateBeep(880, 100); });
-            QTimer::singleShot(100, [this]() { generateBeep(1100, 100); });
-            QTimer::singleShot(200, [this]() { generateBeep(880, 100); });
-            QTimer::singleShot(300, [this]() { generateBeep(1320, 200); });
+            postPattern(type, builtInPattern(ACHIEVEMENT));
             return;
         case TICK:
             soundToPlay = tick;
-            generateBeep(1000, 30); // Very short tick
+            postTone(type, 1000, 30); // Very short tick
             break;
         case WARNING:
             soundToPlay = warning;
-            generateBeep(220, 150); // Low warning sound
+            postTone(type, 220, 150); // Low warning sound
             break;
     }
     
-    // Note: Since we're using programmatic beeps instead of loaded sound files,
-    // the QSoundEffect objects won't actually play. The generateBeep calls above
-    // provide the audio feedback.
+    // Note: Since we're using programmatic tones instead of loaded sound files,
+    // the QSoundEffect objects won't actually play. The tones posted above are
+    // synthesized by the audio engine.
 }
 
 void SoundManager::playKeystrokeSound(bool correct)
@@ -155,16 +205,96 @@ void SoundManager::playKeystrokeSound(bool correct)
 
 void SoundManager::generateBeep(int frequency, int duration)
 {
-    // This is a placeholder for actual beep generation
-    // In a real implementation, you would:
-    // 1. Generate a sine wave at the specified frequency
-    // 2. Play it for the specified duration
-    // 3. Use QAudioOutput or similar for actual sound generation
+    if (!soundEnabled) return;
+    
+    postTone(-1, frequency, duration);
+}
+
+void SoundManager::postTone(int key, int frequency, int duration)
+{
+    if (postSample(key)) return;
+    
+    // Wait-free hand-off to the audio thread; if the queue is full during a
+    // burst the trigger is dropped rather than stalling the UI
+    SoundTrigger soundTrigger;
+    soundTrigger.key = key;
+    soundTrigger.frequency = static_cast<float>(frequency);
+    soundTrigger.gain = static_cast<float>(currentVolume);
+    soundTrigger.durationMs = duration;
+    audioEngine->post(soundTrigger);
+}
+
+void SoundManager::postPattern(int key, const SoundPattern *pattern)
+{
+    if (postSample(key)) return;
+    
+    // The sequencer schedules every note by sample offset on the audio thread
+    SoundTrigger soundTrigger;
+    soundTrigger.key = key;
+    soundTrigger.gain = static_cast<float>(currentVolume);
+    soundTrigger.pattern = pattern;
+    audioEngine->post(soundTrigger);
+}
+
+int SoundManager::renderOffline(float *output, int frames)
+{
+    return audioEngine->renderOffline(output, frames);
+}
+
+int SoundManager::getSampleRate() const
+{
+    return audioEngine->getSampleRate();
+}
+
+bool SoundManager::isOfflineIdle() const
+{
+    return audioEngine->isOfflineIdle();
+}
+
+bool SoundManager::postSample(int key)
+{
+    if (key < 0 || key >= activeSamples.size()) return false;
     
-    qDebug() << "Beep:" << frequency << "Hz for" << duration << "ms";
+    const SampleBufferPtr &buffer = activeSamples[key];
+    if (!buffer) return false;
     
-    // For now, we'll just log the beep parameters
-    // In a production app, you'd implement actual audio generation here
+    // The bank keeps every decoded buffer alive for the lifetime of the engine,
+    // so the audio thread can safely hold on to the raw sample pointer
+    SoundTrigger soundTrigger;
+    soundTrigger.key = key;
+    soundTrigger.gain = static_cast<float>(currentVolume);
+    soundTrigger.samples = buffer->samples.constData();
+    soundTrigger.sampleCount = buffer->samples.size();
+    return audioEngine->post(soundTrigger);
+}
+
+QStringList SoundManager::getAvailableSoundPacks() const
+{
+    return soundBank->getPackNames();
+}
+
+void SoundManager::setSoundPack(const QString &name)
+{
+    activePackName = name;
+    
+    // Resolve names once here so the keystroke path is a plain array index
+    const SoundPack pack = soundBank->getPack(name);
+    activeSamples.clear();
+    if (!pack.isEmpty()) {
+        for (const char *soundName : SOUND_NAMES) {
+            activeSamples.append(pack.value(soundName));
+        }
+    }
+}
+
+QString SoundManager::getSoundPack() const
+{
+    return activePackName;
+}
+
+bool SoundManager::areSoundPacksLoaded() const
+{
+    return soundBank->isLoaded();
 }
 
 void SoundManager::setEnabled(bool enabled)
@@ -8,6 +8,10 @@
 #include <QStandardPaths>
 #include <QTimer>
 #include <QRandomGenerator>
+#include "../audio/audioengine.h"
+#include "../audio/soundbank.h"
+
+struct SoundPattern;
 
 class SoundManager : public QObject
 {
@@ -25,7 +29,8 @@ public:
         WARNING
     };
 
-    explicit SoundManager(QObject *parent = nullptr);
+    explicit SoundManager(QObject *parent = nullptr,
+                          AudioEngine::OutputMode outputMode = AudioEngine::DEVICE_OUTPUT);
     ~SoundManager();
     
     // Sound control
@@ -40,8 +45,24 @@ public:
     bool areKeystrokeSoundsEnabled() const;
     void playKeystrokeSound(bool correct = true);
     
+    // Sound packs loaded from the sounds directory; switching never touches disk
+    QStringList getAvailableSoundPacks() const;
+    void setSoundPack(const QString &name);
+    QString getSoundPack() const;
+    bool areSoundPacksLoaded() const; // Also true when there is no sounds directory to load
+    
     // Generate sounds programmatically (if audio files not available)
     void generateBeep(int frequency, int duration);
+    
+    // Offline rendering (AudioEngine::OFFLINE_OUTPUT only), for headless testing and profiling
+    int renderOffline(float *output, int frames);
+    int getSampleRate() const;
+    bool isOfflineIdle() const;
+
+signals:
+    // The audio device was opened (or failed to open) on the audio thread
+    void audioReady(bool available);
+    void soundPacksLoaded();
 
 private slots:
     void onSoundFinished();
@@ -50,6 +71,9 @@ private:
     void initializeSounds();
     void createProgrammaticSounds();
     QString getResourcePath();
+    void postTone(int key, int frequency, int duration);
+    void postPattern(int key, const SoundPattern *pattern);
+    bool postSample(int key);
     
     QSoundEffect *correctKeystroke;
     QSoundEffect *incorrectKeystroke;
@@ -64,6 +88,12 @@ private:
     bool keystrokeSoundsEnabled;
     qreal currentVolume;
     
+    // Tones are rendered on the audio thread; the UI thread only posts triggers
+    AudioEngine *audioEngine;
+    SoundBank *soundBank;
+    QVector<SampleBufferPtr> activeSamples; // Indexed by SoundType, resolved when the pack changes
+    QString activePackName;
+    
     // For programmatic sound generation
     QTimer *beepTimer;
     int beepFrequency;
@@ -1,13 +1,20 @@
 #include "statisticsmanager.h"
+#include <QThread>
 
 StatisticsManager::StatisticsManager(QObject *parent)
     : QObject(parent)
+    , initThread(nullptr)
+    , schemaReady(false)
 {
     databasePath = getDatabasePath();
 }
 
 StatisticsManager::~StatisticsManager()
 {
+    if (initThread) {
+        initThread->wait();
+    }
+    
     if (database.isOpen()) {
         database.close();
     }
@@ -24,6 +31,53 @@ QString StatisticsManager::getDatabasePath()
 }
 
 bool StatisticsManager::initializeDatabase()
+{
+    return openDatabase() && createTables(database);
+}
+
+void StatisticsManager::initializeDatabaseAsync()
+{
+    if (initThread || database.isOpen()) {
+        return;
+    }
+    
+    initThread = QThread::create([this]() {
+        // A connection may only be used by the thread that made it, so the schema work gets its own
+        const QString connectionName = "StatisticsManagerInit";
+        {
+            QSqlDatabase initDatabase = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+            initDatabase.setDatabaseName(databasePath);
+            if (initDatabase.open()) {
+                schemaReady = createTables(initDatabase);
+                initDatabase.close();
+            } else {
+                qDebug() << "Error opening database:" << initDatabase.lastError().text();
+            }
+        }
+        QSqlDatabase::removeDatabase(connectionName);
+    });
+    
+    initThread->setObjectName("StatisticsInit");
+    connect(initThread, &QThread::finished, this, &StatisticsManager::onInitializationFinished);
+    initThread->start();
+}
+
+void StatisticsManager::onInitializationFinished()
+{
+    initThread->deleteLater();
+    initThread = nullptr;
+    
+    // The file and schema exist now, so opening this thread's connection is cheap
+    const bool success = schemaReady && openDatabase();
+    emit databaseReady(success);
+}
+
+bool StatisticsManager::isDatabaseReady() const
+{
+    return database.isOpen();
+}
+
+bool StatisticsManager::openDatabase()
 {
     database = QSqlDatabase::addDatabase("QSQLITE");
     database.setDatabaseName(databasePath);
@@ -33,12 +87,12 @@ bool StatisticsManager::initializeDatabase()
         return false;
     }
     
-    return createTables();
+    return true;
 }
 
-bool StatisticsManager::createTables()
+bool StatisticsManager::createTables(QSqlDatabase &db)
 {
-    QSqlQuery query(database);
+    QSqlQuery query(db);
     
     // Create users table
     QString createUsersTable = R"(
@@ -66,6 +120,8 @@ bool StatisticsManager::createTables()
             time_spent INTEGER NOT NULL,
             correct_characters INTEGER NOT NULL,
             total_characters INTEGER NOT NULL,
+            passage_seed INTEGER,
+            passage_request TEXT,
             FOREIGN KEY (username) REFERENCES users(username)
         )
     )";
@@ -75,6 +131,22 @@ bool StatisticsManager::createTables()
         return false;
     }
     
+    // Databases created before passages were recorded lack the columns
+    QStringList columns;
+    if (query.exec("PRAGMA table_info(test_results)")) {
+        while (query.next()) {
+            columns << query.value(1).toString();
+        }
+    }
+    const QStringList addedColumns = {"passage_seed INTEGER", "passage_request TEXT"};
+    for (const QString &column : addedColumns) {
+        if (!columns.contains(column.section(' ', 0, 0))
+            && !query.exec("ALTER TABLE test_results ADD COLUMN " + column)) {
+            qDebug() << "Error adding" << column.section(' ', 0, 0) << "column:" << query.lastError().text();
+            return false;
+        }
+    }
+    
     // Create indexes for better performance
     query.exec("CREATE INDEX IF NOT EXISTS idx_username ON test_results(username)");
     query.exec("CREATE INDEX IF NOT EXISTS idx_timestamp ON test_results(timestamp)");
@@ -142,8 +214,9 @@ bool StatisticsManager::saveTestResult(const TestResult &result)
     QSqlQuery query(database);
     query.prepare(R"(
         INSERT INTO test_results 
-        (username, difficulty, wpm, accuracy, time_spent, correct_characters, total_characters)
-        VALUES (?, ?, ?, ?, ?, ?, ?)
+        (username, difficulty, wpm, accuracy, time_spent, correct_characters, total_characters, passage_seed,
+         passage_request)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
     )");
     
     query.addBindValue(result.username);
@@ -153,6 +226,8 @@ bool StatisticsManager::saveTestResult(const TestResult &result)
     query.addBindValue(result.timeSpent);
     query.addBindValue(result.correctCharacters);
     query.addBindValue(result.totalCharacters);
+    query.addBindValue(static_cast<qint64>(result.passageSeed)); // SQLite integers are signed
+    query.addBindValue(result.passageRequest);
     
     if (!query.exec()) {
         qDebug() << "Error saving test result:" << query.lastError().text();
@@ -169,7 +244,7 @@ QList<TestResult> StatisticsManager::getTestHistory(const QString &username, int
     
     query.prepare(R"(
         SELECT id, username, timestamp, difficulty, wpm, accuracy, 
-               time_spent, correct_characters, total_characters
+               time_spent, correct_characters, total_characters, passage_seed, passage_request
         FROM test_results 
         WHERE username = ? 
         ORDER BY timestamp DESC 
@@ -191,6 +266,8 @@ QList<TestResult> StatisticsManager::getTestHistory(const QString &username, int
             result.timeSpent = query.value(6).toInt();
             result.correctCharacters = query.value(7).toInt();
             result.totalCharacters = query.value(8).toInt();
+            result.passageSeed = static_cast<quint64>(query.value(9).toLongLong());
+            result.passageRequest = query.value(10).toString();
             
             results << result;
         }
@@ -206,7 +283,7 @@ QList<TestResult> StatisticsManager::getTestHistoryByDifficulty(const QString &u
     
     query.prepare(R"(
         SELECT id, username, timestamp, difficulty, wpm, accuracy, 
-               time_spent, correct_characters, total_characters
+               time_spent, correct_characters, total_characters, passage_seed, passage_request
         FROM test_results 
         WHERE username = ? AND difficulty = ?
         ORDER BY timestamp DESC 
@@ -229,6 +306,8 @@ QList<TestResult> StatisticsManager::getTestHistoryByDifficulty(const QString &u
             result.timeSpent = query.value(6).toInt();
             result.correctCharacters = query.value(7).toInt();
             result.totalCharacters = query.value(8).toInt();
+            result.passageSeed = static_cast<quint64>(query.value(9).toLongLong());
+            result.passageRequest = query.value(10).toString();
             
             results << result;
         }
@@ -279,7 +358,7 @@ QList<TestResult> StatisticsManager::getPersonalBests(const QString &username)
     // Get best WPM for each difficulty
     query.prepare(R"(
         SELECT id, username, timestamp, difficulty, wpm, accuracy, 
-               time_spent, correct_characters, total_characters
+               time_spent, correct_characters, total_characters, passage_seed, passage_request
         FROM test_results r1
         WHERE username = ? AND wpm = (
             SELECT MAX(wpm) 
@@ -304,6 +383,8 @@ QList<TestResult> StatisticsManager::getPersonalBests(const QString &username)
             result.timeSpent = query.value(6).toInt();
             result.correctCharacters = query.value(7).toInt();
             result.totalCharacters = query.value(8).toInt();
+            result.passageSeed = static_cast<quint64>(query.value(9).toLongLong());
+            result.passageRequest = query.value(10).toString();
             
             results << result;
         }
@@ -319,7 +400,7 @@ QList<TestResult> StatisticsManager::getRecentTests(const QString &username, int
     
     query.prepare(R"(
         SELECT id, username, timestamp, difficulty, wpm, accuracy, 
-               time_spent, correct_characters, total_characters
+               time_spent, correct_characters, total_characters, passage_seed, passage_request
         FROM test_results 
         WHERE username = ? AND timestamp >= datetime('now', '-' || ? || ' days')
         ORDER BY timestamp DESC
@@ -340,6 +421,8 @@ QList<TestResult> StatisticsManager::getRecentTests(const QString &username, int
             result.timeSpent = query.value(6).toInt();
             result.correctCharacters = query.value(7).toInt();
             result.totalCharacters = query.value(8).toInt();
+            result.passageSeed = static_cast<quint64>(query.value(9).toLongLong());
+            result.passageRequest = query.value(10).toString();
             
             results << result;
         }
@@ -10,6 +10,8 @@
 #include <QDir>
 #include <QDebug>
 
+class QThread;
+
 struct TestResult {
     int id;
     QString username;
@@ -20,9 +22,11 @@ struct TestResult {
     int timeSpent;
     int correctCharacters;
     int totalCharacters;
+    quint64 passageSeed;    // Regenerates the passage with TypingTest::setPassageSeed; 0 if not recorded
+    QString passageRequest; // PassageRequest::toString() the passage was generated for; empty if not recorded
     
     TestResult() : id(-1), difficulty(1), wpm(0.0), accuracy(0.0), 
-                   timeSpent(0), correctCharacters(0), totalCharacters(0) {}
+                   timeSpent(0), correctCharacters(0), totalCharacters(0), passageSeed(0) {}
 };
 
 struct UserStats {
@@ -48,6 +52,9 @@ public:
     ~StatisticsManager();
     
     bool initializeDatabase();
+    // Creates the schema on a worker thread, then opens the connection and emits databaseReady()
+    void initializeDatabaseAsync();
+    bool isDatabaseReady() const;
     
     // User management
     bool createUser(const QString &username);
@@ -68,11 +75,20 @@ public:
     bool clearUserData(const QString &username);
     bool clearAllData();
 
+signals:
+    void databaseReady(bool success);
+
+private slots:
+    void onInitializationFinished();
+
 private:
     QSqlDatabase database;
     QString databasePath;
+    QThread *initThread;
+    bool schemaReady; // Written only by the init thread while it runs
     
-    bool createTables();
+    bool openDatabase();
+    bool createTables(QSqlDatabase &db);
     QString getDatabasePath();
 };
 
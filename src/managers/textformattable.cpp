@@ -0,0 +1,31 @@
+/**
+ * Typing Speed Test - Text Format Table Implementation
+ *
+ * Immutable per-character-state formats for passage colorization: brushes
+ * and QTextCharFormats. ThemeManager rebuilds one
+ * whenever the theme or font changes, so renderers do a single indexed
+ * lookup per run instead of formatting colors per character.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "textformattable.h"
+
+TextFormatTable::TextFormatTable(const QBrush (&foregroundBrushes)[CHAR_STATE_COUNT],
+                                 const QBrush (&backgroundBrushes)[CHAR_STATE_COUNT],
+                                 const QFont &textFont, quint64 tableVersion)
+    : font(textFont)
+    , version(tableVersion)
+{
+    for (int state = 0; state < CHAR_STATE_COUNT; ++state) {
+        foregrounds[state] = foregroundBrushes[state];
+        backgrounds[state] = backgroundBrushes[state];
+
+        formats[state].setFont(font);
+        formats[state].setForeground(foregrounds[state]);
+        if (backgrounds[state].style() != Qt::NoBrush) {
+            formats[state].setBackground(backgrounds[state]);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * Typing Speed Test - Text Format Table
+ *
+ * Immutable per-character-state formats for passage colorization: brushes
+ * and QTextCharFormats. ThemeManager rebuilds one
+ * whenever the theme or font changes, so renderers do a single indexed
+ * lookup per run instead of formatting colors per character.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef TEXTFORMATTABLE_H
+#define TEXTFORMATTABLE_H
+
+#include <QBrush>
+#include <QFont>
+#include <QSharedPointer>
+#include <QTextCharFormat>
+
+class TextFormatTable
+{
+public:
+    enum CharState {
+        CORRECT_CHAR,
+        INCORRECT_CHAR,
+        CURRENT_CHAR,
+        REMAINING_CHAR,
+        CHAR_STATE_COUNT
+    };
+
+    // A background with Qt::NoBrush leaves that state's background unpainted
+    TextFormatTable(const QBrush (&foregrounds)[CHAR_STATE_COUNT],
+                    const QBrush (&backgrounds)[CHAR_STATE_COUNT],
+                    const QFont &font, quint64 version);
+
+    // Increases every time ThemeManager rebuilds the table
+    quint64 getVersion() const { return version; }
+    const QFont &getFont() const { return font; }
+
+    const QBrush &getForeground(CharState state) const { return foregrounds[state]; }
+    const QBrush &getBackground(CharState state) const { return backgrounds[state]; }
+    const QTextCharFormat &getFormat(CharState state) const { return formats[state]; }
+
+private:
+    QBrush foregrounds[CHAR_STATE_COUNT];
+    QBrush backgrounds[CHAR_STATE_COUNT];
+    QTextCharFormat formats[CHAR_STATE_COUNT];
+    QFont font;
+    quint64 version;
+};
+
+typedef QSharedPointer<const TextFormatTable> TextFormatTablePtr;
+
+#endif // TEXTFORMATTABLE_H
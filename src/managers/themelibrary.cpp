@@ -0,0 +1,274 @@
+/**
+ * Typing Speed Test - Theme Library Implementation
+ *
+ * Loads JSON theme files from watched directories, re-parses them on a
+ * background thread whenever they change on disk, and reports which themes
+ * actually changed so they can be re-applied live.
+ *
+ * Theme file format:
+ *   { "name": "Solarized Light",
+ *     "colors": { "background": "#fdf6e3", "foreground": "#657b83", ... } }
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "themelibrary.h"
+#include <QFileSystemWatcher>
+#include <QThread>
+#include <QTimer>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace {
+
+struct ColorKey {
+    const char *key;
+    QColor ThemeManager::ThemeColors::*member;
+};
+
+const ColorKey COLOR_KEYS[] = {
+    {"background", &ThemeManager::ThemeColors::background},
+    {"foreground", &ThemeManager::ThemeColors::foreground},
+    {"primaryAccent", &ThemeManager::ThemeColors::primaryAccent},
+    {"secondaryAccent", &ThemeManager::ThemeColors::secondaryAccent},
+    {"correctText", &ThemeManager::ThemeColors::correctText},
+    {"incorrectText", &ThemeManager::ThemeColors::incorrectText},
+    {"currentText", &ThemeManager::ThemeColors::currentText},
+    {"remainingText", &ThemeManager::ThemeColors::remainingText},
+    {"buttonBackground", &ThemeManager::ThemeColors::buttonBackground},
+    {"buttonText", &ThemeManager::ThemeColors::buttonText},
+    {"inputBackground", &ThemeManager::ThemeColors::inputBackground},
+    {"inputText", &ThemeManager::ThemeColors::inputText},
+    {"border", &ThemeManager::ThemeColors::border},
+    {"success", &ThemeManager::ThemeColors::success},
+    {"warning", &ThemeManager::ThemeColors::warning},
+    {"error", &ThemeManager::ThemeColors::error}
+};
+
+}
+
+ThemeLibrary::ThemeLibrary(const ThemeManager::ThemeColors &fallbackColors, QObject *parent)
+    : QObject(parent)
+    , fallback(fallbackColors)
+    , watcher(new QFileSystemWatcher(this))
+    , reloadTimer(new QTimer(this))
+    , scanThread(nullptr)
+    , scanPending(false)
+{
+    reloadTimer->setSingleShot(true);
+    reloadTimer->setInterval(RELOAD_DELAY_MS);
+
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &ThemeLibrary::scheduleScan);
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &ThemeLibrary::scheduleScan);
+    connect(reloadTimer, &QTimer::timeout, this, &ThemeLibrary::startScan);
+}
+
+ThemeLibrary::~ThemeLibrary()
+{
+    // The scan writes into scanResult, so it must finish before we go away
+    if (scanThread) {
+        scanThread->wait();
+    }
+}
+
+void ThemeLibrary::watchDirectory(const QString &directory)
+{
+    const QString path = QDir(directory).absolutePath();
+    if (directory.isEmpty() || directories.contains(path) || !QDir(path).exists()) {
+        return;
+    }
+
+    directories.append(path);
+    watcher->addPath(path);
+    startScan();
+}
+
+QStringList ThemeLibrary::getThemeIds() const
+{
+    QStringList ids = themes.keys();
+    ids.sort();
+    return ids;
+}
+
+bool ThemeLibrary::contains(const QString &id) const
+{
+    return themes.contains(id);
+}
+
+QString ThemeLibrary::getThemeName(const QString &id) const
+{
+    return themes.value(id).name;
+}
+
+ThemeManager::ThemeColors ThemeLibrary::getThemeColors(const QString &id) const
+{
+    return themes.value(id).colors;
+}
+
+void ThemeLibrary::scheduleScan()
+{
+    reloadTimer->start();
+}
+
+void ThemeLibrary::startScan()
+{
+    if (scanThread) {
+        scanPending = true; // Rescan once the running one lands
+        return;
+    }
+
+    // The thread gets copies; unchanged files reuse the previous parse
+    const QHash<QString, ThemeFile> previous = themes;
+    const QStringList scanDirectories = directories;
+    const ThemeManager::ThemeColors fallbackColors = fallback;
+
+    scanThread = QThread::create([this, previous, scanDirectories, fallbackColors]() {
+        for (const QString &directory : scanDirectories) {
+            const QFileInfoList files = QDir(directory).entryInfoList({"*.json"}, QDir::Files, QDir::Name);
+            for (const QFileInfo &info : files) {
+                const QString id = info.completeBaseName();
+                if (scanResult.contains(id)) {
+                    continue; // Earlier directories take precedence
+                }
+
+                const ThemeFile old = previous.value(id);
+                if (old.path == info.absoluteFilePath() && old.modified == info.lastModified()
+                    && old.size == info.size()) {
+                    scanResult.insert(id, old);
+                    continue;
+                }
+
+                QFile file(info.absoluteFilePath());
+                ThemeFile theme;
+                QString error;
+                if (!file.open(QIODevice::ReadOnly)
+                    || !parseThemeFile(file.readAll(), fallbackColors, theme.name, theme.colors, error)) {
+                    // Keep the last good version while a file is mid-edit
+                    qDebug() << "Failed to load theme" << info.fileName() << error;
+                    if (!old.path.isEmpty()) {
+                        scanResult.insert(id, old);
+                    }
+                    continue;
+                }
+
+                if (theme.name.isEmpty()) {
+                    theme.name = id;
+                }
+                theme.path = info.absoluteFilePath();
+                theme.modified = info.lastModified();
+                theme.size = info.size();
+                scanResult.insert(id, theme);
+            }
+        }
+    });
+
+    scanThread->setObjectName("ThemeLibraryScan");
+    connect(scanThread, &QThread::finished, this, &ThemeLibrary::onScanFinished);
+    scanThread->start(QThread::LowPriority);
+}
+
+void ThemeLibrary::onScanFinished()
+{
+    const QHash<QString, ThemeFile> previous = themes;
+    themes = scanResult;
+    scanResult.clear();
+    scanThread->deleteLater();
+    scanThread = nullptr;
+
+    // Editors that save by replacing the file drop it from the watcher, so re-add every file
+    if (!watcher->files().isEmpty()) {
+        watcher->removePaths(watcher->files());
+    }
+    QStringList paths;
+    for (const ThemeFile &theme : themes) {
+        paths.append(theme.path);
+    }
+    if (!paths.isEmpty()) {
+        watcher->addPaths(paths);
+    }
+
+    bool listChanged = previous.size() != themes.size();
+    QStringList updated;
+    for (auto it = themes.constBegin(); it != themes.constEnd(); ++it) {
+        auto old = previous.constFind(it.key());
+        if (old == previous.constEnd() || old->name != it->name) {
+            listChanged = true;
+        }
+        if (old != previous.constEnd() && old->colors != it->colors) {
+            updated.append(it.key());
+        }
+    }
+
+    if (listChanged) {
+        emit themesChanged();
+    }
+    for (const QString &id : updated) {
+        emit themeUpdated(id);
+    }
+
+    if (scanPending) {
+        scanPending = false;
+        startScan();
+    }
+}
+
+bool ThemeLibrary::parseThemeFile(const QByteArray &data, const ThemeManager::ThemeColors &fallbackColors,
+                                  QString &name, ThemeManager::ThemeColors &colors, QString &error)
+{
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+        error = parseError.error != QJsonParseError::NoError ? parseError.errorString()
+                                                            : QString("top level is not an object");
+        return false;
+    }
+
+    const QJsonObject root = document.object();
+    const QJsonObject colorObject = root.value("colors").toObject();
+    colors = fallbackColors;
+    for (const ColorKey &colorKey : COLOR_KEYS) {
+        const QJsonValue value = colorObject.value(QLatin1String(colorKey.key));
+        if (value.isUndefined()) {
+            continue;
+        }
+
+        const QColor color(value.toString());
+        if (!color.isValid()) {
+            error = QString("invalid color for '%1'").arg(colorKey.key);
+            return false;
+        }
+        colors.*colorKey.member = color;
+    }
+
+    name = root.value("name").toString();
+    return true;
+}
+
+bool ThemeLibrary::writeThemeFile(const QString &path, const QString &name, const ThemeManager::ThemeColors &colors)
+{
+    QJsonObject colorObject;
+    for (const ColorKey &colorKey : COLOR_KEYS) {
+        const QColor &color = colors.*colorKey.member;
+        colorObject.insert(QLatin1String(colorKey.key),
+                           color.name(color.alpha() < 255 ? QColor::HexArgb : QColor::HexRgb));
+    }
+
+    QJsonObject root;
+    root.insert("name", name);
+    root.insert("colors", colorObject);
+
+    // Written atomically so a watching library never sees a half-written file
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to write theme file" << path;
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson());
+    return file.commit();
+}
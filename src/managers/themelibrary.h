@@ -0,0 +1,80 @@
+/**
+ * Typing Speed Test - Theme Library
+ *
+ * Loads JSON theme files from watched directories, re-parses them on a
+ * background thread whenever they change on disk, and reports which themes
+ * actually changed so they can be re-applied live.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef THEMELIBRARY_H
+#define THEMELIBRARY_H
+
+#include <QObject>
+#include <QHash>
+#include <QDateTime>
+#include <QStringList>
+#include "thememanager.h"
+
+class QFileSystemWatcher;
+class QThread;
+class QTimer;
+
+class ThemeLibrary : public QObject
+{
+    Q_OBJECT
+
+public:
+    // One parsed theme file; the id is the file's base name
+    struct ThemeFile {
+        QString name;
+        QString path;
+        QDateTime modified;
+        qint64 size;
+        ThemeManager::ThemeColors colors;
+
+        ThemeFile() : size(-1) {}
+    };
+
+    // Colors missing from a file are taken from fallbackColors
+    explicit ThemeLibrary(const ThemeManager::ThemeColors &fallbackColors, QObject *parent = nullptr);
+    ~ThemeLibrary();
+
+    // Watches <directory>/*.json; may be called for several directories
+    void watchDirectory(const QString &directory);
+
+    QStringList getThemeIds() const;
+    bool contains(const QString &id) const;
+    QString getThemeName(const QString &id) const;
+    ThemeManager::ThemeColors getThemeColors(const QString &id) const;
+
+    // Parsing and writing helpers, usable from any thread
+    static bool parseThemeFile(const QByteArray &data, const ThemeManager::ThemeColors &fallbackColors,
+                               QString &name, ThemeManager::ThemeColors &colors, QString &error);
+    static bool writeThemeFile(const QString &path, const QString &name, const ThemeManager::ThemeColors &colors);
+
+signals:
+    void themesChanged();                   // A theme file was added, removed or renamed
+    void themeUpdated(const QString &id);   // A theme's colors changed
+
+private slots:
+    void scheduleScan();
+    void startScan();
+    void onScanFinished();
+
+private:
+    static const int RELOAD_DELAY_MS = 100; // Coalesces the several events an editor's save produces
+
+    ThemeManager::ThemeColors fallback;
+    QStringList directories;
+    QHash<QString, ThemeFile> themes;
+    QHash<QString, ThemeFile> scanResult;   // Written only by the scan thread
+    QFileSystemWatcher *watcher;
+    QTimer *reloadTimer;
+    QThread *scanThread;
+    bool scanPending;
+};
+
+#endif // THEMELIBRARY_H
@@ -8,7 +8,71 @@
  */
 
 #include "thememanager.h"
+#include "themestyle.h"
+#include "themelibrary.h"
 #include <QDebug>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QStandardPaths>
+#include <QStyleFactory>
+#include <QThread>
+
+namespace {
+
+const quint32 STYLE_SHEET_CACHE_MAGIC = 0x54535343; // "TSSC"
+const quint32 STYLE_SHEET_CACHE_VERSION = 1;
+
+// Most specific class first; a widget takes the rules of the first class it inherits
+const char *const STYLED_WIDGET_CLASSES[] = {
+    "QPushButton", "QLineEdit", "QComboBox", "QCheckBox", "QSlider", "QProgressBar", "QLabel"
+};
+
+// setCustomTheme() colors, saved as a theme file in the user's themes directory
+const char *const CUSTOM_THEME_FILE = "custom";
+
+const char *const BASE_STYLE_SHEET_PROPERTY = "themeBaseStyleSheet";
+const char *const APPLIED_RULES_PROPERTY = "themeAppliedRules";
+
+// FNV-1a, stable across runs unlike qHash(), so keys stay valid in the persisted cache
+quint64 stableHash(const QByteArray &data)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (char byte : data) {
+        hash ^= static_cast<quint8>(byte);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void applyRules(QWidget *widget, const QString &rules)
+{
+    const QVariant applied = widget->property(APPLIED_RULES_PROPERTY);
+    if (applied.isValid() && applied.toString() == rules) {
+        return; // Unchanged, skip the re-polish
+    }
+    
+    if (!applied.isValid()) {
+        // Keep the widget's own rules (e.g. the sample text label's); they still win over the theme's
+        widget->setProperty(BASE_STYLE_SHEET_PROPERTY, widget->styleSheet());
+    }
+    widget->setProperty(APPLIED_RULES_PROPERTY, rules);
+    widget->setStyleSheet(rules + widget->property(BASE_STYLE_SHEET_PROPERTY).toString());
+}
+
+void clearRules(QWidget *widget)
+{
+    if (!widget->property(APPLIED_RULES_PROPERTY).isValid()) {
+        return;
+    }
+    
+    widget->setStyleSheet(widget->property(BASE_STYLE_SHEET_PROPERTY).toString());
+    widget->setProperty(APPLIED_RULES_PROPERTY, QVariant());
+    widget->setProperty(BASE_STYLE_SHEET_PROPERTY, QVariant());
+}
+
+} // namespace
 
 ThemeManager::ThemeManager(QObject *parent)
     : QObject(parent)
@@ -17,15 +81,40 @@ ThemeManager::ThemeManager(QObject *parent)
     , fontSize(MEDIUM_FONT)
     , highContrastMode(false)
     , largeTextMode(false)
+    , styleBackend(STYLESHEET_BACKEND)
+    , themeStyle(nullptr)
     , settings(new QSettings("TypingSpeedTest", "Themes", this))
+    , themeLibrary(nullptr)
+    , textFormatVersion(0)
+    , styleSheetCacheLoader(nullptr)
+    , styleSheetCacheDirty(false)
 {
+    // Connected first so the table is current before anyone else hears about the change
+    connect(this, &ThemeManager::themeChanged, this, &ThemeManager::rebuildTextFormatTable);
+    connect(this, &ThemeManager::fontChanged, this, &ThemeManager::rebuildTextFormatTable);
+    
     initializeThemes();
+    loadStyleSheetCache();
     loadSettings();
+    
+    // Theme files load in the background; a saved file theme starts from its last saved colors
+    themeLibrary = new ThemeLibrary(predefinedThemes[LIGHT_THEME], this);
+    connect(themeLibrary, &ThemeLibrary::themesChanged, this, &ThemeManager::onThemeFilesChanged);
+    connect(themeLibrary, &ThemeLibrary::themeUpdated, this, &ThemeManager::onThemeFileUpdated);
+    for (const QString &directory : getThemeDirectories()) {
+        themeLibrary->watchDirectory(directory);
+    }
+    
+    qApp->installEventFilter(this);
 }
 
 ThemeManager::~ThemeManager()
 {
     saveSettings();
+    waitForStyleSheetCache();
+    if (styleSheetCacheDirty) {
+        saveStyleSheetCache();
+    }
 }
 
 void ThemeManager::initializeThemes()
@@ -104,9 +193,24 @@ void ThemeManager::setupHighContrastTheme()
     predefinedThemes[HIGH_CONTRAST_THEME] = highContrast;
 }
 
+bool ThemeManager::ThemeColors::operator==(const ThemeColors &other) const
+{
+    return background == other.background && foreground == other.foreground
+        && primaryAccent == other.primaryAccent && secondaryAccent == other.secondaryAccent
+        && correctText == other.correctText && incorrectText == other.incorrectText
+        && currentText == other.currentText && remainingText == other.remainingText
+        && buttonBackground == other.buttonBackground && buttonText == other.buttonText
+        && inputBackground == other.inputBackground && inputText == other.inputText
+        && border == other.border && success == other.success
+        && warning == other.warning && error == other.error;
+}
+
 void ThemeManager::applyTheme(ThemeType theme)
 {
     currentTheme = theme;
+    if (theme != CUSTOM_THEME) {
+        currentThemeFile.clear();
+    }
     
     if (predefinedThemes.contains(theme)) {
         currentColors = predefinedThemes[theme];
@@ -125,13 +229,151 @@ void ThemeManager::applyTheme(ThemeType theme)
 
 void ThemeManager::setCustomTheme(const ThemeColors &colors)
 {
+    // As a theme file it is listed with the others, can be edited on disk, and survives restarts
+    const QString path = QDir(getUserThemeDirectory()).filePath(QString(CUSTOM_THEME_FILE) + ".json");
     currentTheme = CUSTOM_THEME;
+    currentThemeFile = ThemeLibrary::writeThemeFile(path, "Custom", colors) ? CUSTOM_THEME_FILE : QString();
     currentColors = colors;
     predefinedThemes[CUSTOM_THEME] = colors;
     
     emit themeChanged();
 }
 
+QStringList ThemeManager::getThemeFiles() const
+{
+    return themeLibrary->getThemeIds();
+}
+
+QString ThemeManager::getThemeFileName(const QString &id) const
+{
+    return themeLibrary->getThemeName(id);
+}
+
+bool ThemeManager::applyThemeFile(const QString &id)
+{
+    if (!themeLibrary->contains(id)) {
+        qDebug() << "Unknown theme file:" << id;
+        return false;
+    }
+    
+    currentThemeFile = id;
+    predefinedThemes[CUSTOM_THEME] = themeLibrary->getThemeColors(id);
+    applyTheme(CUSTOM_THEME);
+    return true;
+}
+
+QString ThemeManager::getCurrentThemeFile() const
+{
+    return currentThemeFile;
+}
+
+QStringList ThemeManager::getThemeDirectories()
+{
+    // Bundled themes next to the application, then the user's own
+    QStringList directories;
+    QDir bundled(QApplication::applicationDirPath());
+    if (bundled.cd("themes")) {
+        directories.append(bundled.absolutePath());
+    }
+    
+    const QString user = getUserThemeDirectory();
+    if (QDir().mkpath(user)) {
+        directories.append(user);
+    }
+    return directories;
+}
+
+QString ThemeManager::getUserThemeDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/themes";
+}
+
+bool ThemeManager::readThemeFile(const QString &id, ThemeColors &colors) const
+{
+    // Same precedence as the library: the first directory holding the file wins
+    for (const QString &directory : getThemeDirectories()) {
+        QFile file(QDir(directory).filePath(id + ".json"));
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        
+        QString name;
+        QString error;
+        if (!ThemeLibrary::parseThemeFile(file.readAll(), predefinedThemes.value(LIGHT_THEME), name, colors, error)) {
+            qDebug() << "Failed to load theme" << file.fileName() << error;
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThemeManager::migrateCustomThemeSettings()
+{
+    // Older versions kept custom colors as settings keys; they move to the custom theme file once
+    if (!settings->childGroups().contains("CustomTheme")) {
+        return;
+    }
+    
+    settings->beginGroup("CustomTheme");
+    ThemeColors custom;
+    custom.background = settings->value("background").value<QColor>();
+    custom.foreground = settings->value("foreground").value<QColor>();
+    custom.primaryAccent = settings->value("primaryAccent").value<QColor>();
+    custom.secondaryAccent = settings->value("secondaryAccent").value<QColor>();
+    custom.correctText = settings->value("correctText").value<QColor>();
+    custom.incorrectText = settings->value("incorrectText").value<QColor>();
+    custom.currentText = settings->value("currentText").value<QColor>();
+    custom.remainingText = settings->value("remainingText").value<QColor>();
+    custom.buttonBackground = settings->value("buttonBackground").value<QColor>();
+    custom.buttonText = settings->value("buttonText").value<QColor>();
+    custom.inputBackground = settings->value("inputBackground").value<QColor>();
+    custom.inputText = settings->value("inputText").value<QColor>();
+    custom.border = settings->value("border").value<QColor>();
+    custom.success = settings->value("success").value<QColor>();
+    custom.warning = settings->value("warning").value<QColor>();
+    custom.error = settings->value("error").value<QColor>();
+    settings->endGroup();
+    
+    // With a theme file selected the keys were only a copy of that file's colors
+    if (currentThemeFile.isEmpty()) {
+        QDir().mkpath(getUserThemeDirectory());
+        const QString path = QDir(getUserThemeDirectory()).filePath(QString(CUSTOM_THEME_FILE) + ".json");
+        if (!QFileInfo::exists(path) && !ThemeLibrary::writeThemeFile(path, "Custom", custom)) {
+            return; // Keep the keys and try again next start
+        }
+        if (currentTheme == CUSTOM_THEME) {
+            currentThemeFile = CUSTOM_THEME_FILE;
+        }
+    }
+    settings->remove("CustomTheme");
+}
+
+void ThemeManager::onThemeFilesChanged()
+{
+    // The file behind a saved theme may have been edited while the application was closed
+    if (themeLibrary->contains(currentThemeFile)) {
+        onThemeFileUpdated(currentThemeFile);
+    }
+    emit themeFilesChanged();
+}
+
+void ThemeManager::onThemeFileUpdated(const QString &id)
+{
+    if (id != currentThemeFile) {
+        return;
+    }
+    
+    const ThemeColors colors = themeLibrary->getThemeColors(id);
+    if (colors == predefinedThemes.value(CUSTOM_THEME)) {
+        return;
+    }
+    
+    // Widgets whose rules come out identical are skipped by applyToWidget()
+    predefinedThemes[CUSTOM_THEME] = colors;
+    applyTheme(CUSTOM_THEME);
+}
+
 ThemeManager::ThemeType ThemeManager::getCurrentTheme() const
 {
     return currentTheme;
@@ -228,6 +470,19 @@ bool ThemeManager::isLargeTextMode() const
     return largeTextMode;
 }
 
+void ThemeManager::setStyleBackend(StyleBackend backend)
+{
+    if (backend == styleBackend) return;
+    
+    styleBackend = backend;
+    emit themeChanged();
+}
+
+ThemeManager::StyleBackend ThemeManager::getStyleBackend() const
+{
+    return styleBackend;
+}
+
 void ThemeManager::saveSettings()
 {
     settings->setValue("theme", static_cast<int>(currentTheme));
@@ -235,28 +490,8 @@ void ThemeManager::saveSettings()
     settings->setValue("fontSize", fontSize);
     settings->setValue("highContrast", highContrastMode);
     settings->setValue("largeText", largeTextMode);
-    
-    // Save custom theme colors if current theme is custom
-    if (currentTheme == CUSTOM_THEME) {
-        settings->beginGroup("CustomTheme");
-        settings->setValue("background", currentColors.background);
-        settings->setValue("foreground", currentColors.foreground);
-        settings->setValue("primaryAccent", currentColors.primaryAccent);
-        settings->setValue("secondaryAccent", currentColors.secondaryAccent);
-        settings->setValue("correctText", currentColors.correctText);
-        settings->setValue("incorrectText", currentColors.incorrectText);
-        settings->setValue("currentText", currentColors.currentText);
-        settings->setValue("remainingText", currentColors.remainingText);
-        settings->setValue("buttonBackground", currentColors.buttonBackground);
-        settings->setValue("buttonText", currentColors.buttonText);
-        settings->setValue("inputBackground", currentColors.inputBackground);
-        settings->setValue("inputText", currentColors.inputText);
-        settings->setValue("border", currentColors.border);
-        settings->setValue("success", currentColors.success);
-        settings->setValue("warning", currentColors.warning);
-        settings->setValue("error", currentColors.error);
-        settings->endGroup();
-    }
+    settings->setValue("styleBackend", static_cast<int>(styleBackend));
+    settings->setValue("themeFile", currentThemeFile);
 }
 
 void ThemeManager::loadSettings()
@@ -266,30 +501,20 @@ void ThemeManager::loadSettings()
     fontSize = settings->value("fontSize", MEDIUM_FONT).toInt();
     highContrastMode = settings->value("highContrast", false).toBool();
     largeTextMode = settings->value("largeText", false).toBool();
+    styleBackend = static_cast<StyleBackend>(settings->value("styleBackend", STYLESHEET_BACKEND).toInt());
+    currentThemeFile = settings->value("themeFile").toString(); // Cleared by applyTheme() unless custom
     
-    // Load custom theme colors if they exist
-    if (currentTheme == CUSTOM_THEME && settings->childGroups().contains("CustomTheme")) {
-        settings->beginGroup("CustomTheme");
-        ThemeColors custom;
-        custom.background = settings->value("background").value<QColor>();
-        custom.foreground = settings->value("foreground").value<QColor>();
-        custom.primaryAccent = settings->value("primaryAccent").value<QColor>();
-        custom.secondaryAccent = settings->value("secondaryAccent").value<QColor>();
-        custom.correctText = settings->value("correctText").value<QColor>();
-        custom.incorrectText = settings->value("incorrectText").value<QColor>();
-        custom.currentText = settings->value("currentText").value<QColor>();
-        custom.remainingText = settings->value("remainingText").value<QColor>();
-        custom.buttonBackground = settings->value("buttonBackground").value<QColor>();
-        custom.buttonText = settings->value("buttonText").value<QColor>();
-        custom.inputBackground = settings->value("inputBackground").value<QColor>();
-        custom.inputText = settings->value("inputText").value<QColor>();
-        custom.border = settings->value("border").value<QColor>();
-        custom.success = settings->value("success").value<QColor>();
-        custom.warning = settings->value("warning").value<QColor>();
-        custom.error = settings->value("error").value<QColor>();
-        settings->endGroup();
-        
-        predefinedThemes[CUSTOM_THEME] = custom;
+    migrateCustomThemeSettings();
+    
+    // A theme file starts from its colors on disk; the library keeps them current from then on
+    if (currentTheme == CUSTOM_THEME) {
+        ThemeColors colors;
+        if (!currentThemeFile.isEmpty() && readThemeFile(currentThemeFile, colors)) {
+            predefinedThemes[CUSTOM_THEME] = colors;
+        } else {
+            qDebug() << "Saved theme file not found:" << currentThemeFile;
+            currentTheme = LIGHT_THEME;
+        }
     }
     
     applyTheme(currentTheme);
@@ -297,25 +522,241 @@ void ThemeManager::loadSettings()
 
 QString ThemeManager::generateStyleSheet() const
 {
-    QString styleSheet;
+    const StyleSheetSet &sheets = currentStyleSheets();
     
-    // Main window style
-    styleSheet += QString("QMainWindow { background-color: %1; color: %2; }")
-                 .arg(currentColors.background.name())
-                 .arg(currentColors.foreground.name());
-    
-    // Add component styles
-    styleSheet += generateButtonStyleSheet();
-    styleSheet += generateInputStyleSheet();
-    styleSheet += generateLabelStyleSheet();
-    styleSheet += generateProgressBarStyleSheet();
-    styleSheet += generateComboBoxStyleSheet();
-    styleSheet += generateCheckBoxStyleSheet();
-    styleSheet += generateSliderStyleSheet();
+    QString styleSheet = sheets.window;
+    styleSheet += sheets.fragments.value("QPushButton");
+    styleSheet += sheets.fragments.value("QLineEdit");
+    styleSheet += sheets.fragments.value("QLabel");
+    styleSheet += sheets.fragments.value("QProgressBar");
+    styleSheet += sheets.fragments.value("QComboBox");
+    styleSheet += sheets.fragments.value("QCheckBox");
+    styleSheet += sheets.fragments.value("QSlider");
     
     return styleSheet;
 }
 
+quint64 ThemeManager::styleStateKey() const
+{
+    QByteArray state;
+    QDataStream stream(&state, QIODevice::WriteOnly);
+    
+    stream << STYLE_SHEET_CACHE_VERSION << static_cast<qint32>(currentTheme);
+    const QColor colors[] = {
+        currentColors.background, currentColors.foreground,
+        currentColors.primaryAccent, currentColors.secondaryAccent,
+        currentColors.correctText, currentColors.incorrectText,
+        currentColors.currentText, currentColors.remainingText,
+        currentColors.buttonBackground, currentColors.buttonText,
+        currentColors.inputBackground, currentColors.inputText,
+        currentColors.border, currentColors.success,
+        currentColors.warning, currentColors.error
+    };
+    for (const QColor &color : colors) {
+        stream << static_cast<quint32>(color.rgba());
+    }
+    stream << fontFamily << static_cast<qint32>(fontSize) << highContrastMode << largeTextMode;
+    
+    return stableHash(state);
+}
+
+const ThemeManager::StyleSheetSet &ThemeManager::currentStyleSheets() const
+{
+    waitForStyleSheetCache();
+    
+    const quint64 key = styleStateKey();
+    QHash<quint64, StyleSheetSet>::const_iterator cached = styleSheetCache.constFind(key);
+    if (cached != styleSheetCache.constEnd()) {
+        return cached.value();
+    }
+    
+    if (styleSheetCache.size() >= MAX_CACHED_STYLE_SHEETS) {
+        styleSheetCache.clear(); // Custom color edits can produce unbounded states
+    }
+    
+    StyleSheetSet sheets;
+    sheets.window = QString("QMainWindow { background-color: %1; color: %2; }")
+                   .arg(currentColors.background.name())
+                   .arg(currentColors.foreground.name());
+    sheets.fragments["QPushButton"] = generateButtonStyleSheet();
+    sheets.fragments["QLineEdit"] = generateInputStyleSheet();
+    sheets.fragments["QLabel"] = generateLabelStyleSheet();
+    sheets.fragments["QProgressBar"] = generateProgressBarStyleSheet();
+    sheets.fragments["QComboBox"] = generateComboBoxStyleSheet();
+    sheets.fragments["QCheckBox"] = generateCheckBoxStyleSheet();
+    sheets.fragments["QSlider"] = generateSliderStyleSheet();
+    
+    styleSheetCacheDirty = true;
+    return styleSheetCache.insert(key, sheets).value();
+}
+
+QString ThemeManager::styleSheetCachePath() const
+{
+    // Next to the QSettings file; the native Windows format has no file, so fall back there
+    QDir directory = QFileInfo(settings->fileName()).absoluteDir();
+    if (settings->format() != QSettings::IniFormat && !directory.exists()) {
+        directory.setPath(QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation));
+    }
+    return directory.filePath("Themes-stylesheets.cache");
+}
+
+void ThemeManager::loadStyleSheetCache()
+{
+    // Read on a worker thread while the window is built; joined on first use
+    const QString path = styleSheetCachePath();
+    styleSheetCacheLoader = QThread::create([this, path]() {
+        loadedStyleSheetCache = readStyleSheetCache(path);
+    });
+    styleSheetCacheLoader->setObjectName("StyleSheetCacheLoader");
+    styleSheetCacheLoader->start();
+}
+
+void ThemeManager::waitForStyleSheetCache() const
+{
+    if (!styleSheetCacheLoader) {
+        return;
+    }
+    
+    styleSheetCacheLoader->wait();
+    delete styleSheetCacheLoader;
+    styleSheetCacheLoader = nullptr;
+    
+    // Entries generated while the loader ran are newer, so they win
+    for (QHash<quint64, StyleSheetSet>::const_iterator it = loadedStyleSheetCache.constBegin();
+         it != loadedStyleSheetCache.constEnd() && styleSheetCache.size() < MAX_CACHED_STYLE_SHEETS; ++it) {
+        if (!styleSheetCache.contains(it.key())) {
+            styleSheetCache.insert(it.key(), it.value());
+        }
+    }
+    loadedStyleSheetCache.clear();
+}
+
+QHash<quint64, ThemeManager::StyleSheetSet> ThemeManager::readStyleSheetCache(const QString &path)
+{
+    QHash<quint64, StyleSheetSet> loaded;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return loaded; // First run
+    }
+    
+    QDataStream stream(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 count = 0;
+    stream >> magic >> version >> count;
+    if (magic != STYLE_SHEET_CACHE_MAGIC || version != STYLE_SHEET_CACHE_VERSION
+        || count < 0 || count > MAX_CACHED_STYLE_SHEETS) {
+        qDebug() << "Ignoring incompatible style sheet cache" << path;
+        return loaded;
+    }
+    
+    for (qint32 i = 0; i < count; ++i) {
+        quint64 key = 0;
+        StyleSheetSet sheets;
+        stream >> key >> sheets.window >> sheets.fragments;
+        loaded.insert(key, sheets);
+    }
+    
+    if (stream.status() != QDataStream::Ok) {
+        qDebug() << "Ignoring truncated style sheet cache" << path;
+        loaded.clear();
+    }
+    return loaded;
+}
+
+void ThemeManager::saveStyleSheetCache() const
+{
+    const QString path = styleSheetCachePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Failed to write style sheet cache" << path;
+        return;
+    }
+    
+    QDataStream stream(&file);
+    stream << STYLE_SHEET_CACHE_MAGIC << STYLE_SHEET_CACHE_VERSION
+           << static_cast<qint32>(styleSheetCache.size());
+    for (QHash<quint64, StyleSheetSet>::const_iterator it = styleSheetCache.constBegin();
+         it != styleSheetCache.constEnd(); ++it) {
+        stream << it.key() << it.value().window << it.value().fragments;
+    }
+    styleSheetCacheDirty = false;
+}
+
+void ThemeManager::applyStyleSheets(QWidget *widget)
+{
+    const StyleSheetSet &sheets = currentStyleSheets();
+    styledRoot = widget;
+    
+    // A style sheet on the top-level widget would re-polish the whole tree on every
+    // background change, so the window rule goes in as palette roles instead
+    applyWindowPalette(widget);
+    
+    const QList<QWidget *> children = widget->findChildren<QWidget *>();
+    for (QWidget *child : children) {
+        if (child->isWindow()) {
+            applyWindowPalette(child); // Dialogs do not inherit the window's palette
+        }
+        applyClassRules(child, sheets);
+    }
+}
+
+void ThemeManager::applyWindowPalette(QWidget *window) const
+{
+    QPalette windowPalette = QApplication::palette();
+    windowPalette.setColor(QPalette::Window, currentColors.background);
+    windowPalette.setColor(QPalette::WindowText, currentColors.foreground);
+    window->setPalette(windowPalette);
+}
+
+void ThemeManager::applyClassRules(QWidget *widget, const StyleSheetSet &sheets) const
+{
+    for (const char *className : STYLED_WIDGET_CLASSES) {
+        if (widget->inherits(className)) {
+            applyRules(widget, sheets.fragments.value(QLatin1String(className)));
+            return;
+        }
+    }
+}
+
+bool ThemeManager::isStyledDescendant(QWidget *widget) const
+{
+    for (QWidget *parent = widget->parentWidget(); parent; parent = parent->parentWidget()) {
+        if (parent == styledRoot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThemeManager::eventFilter(QObject *watched, QEvent *event)
+{
+    // What a style sheet on the window would cascade into: widgets under it created later, dialogs
+    // included, take the same rules once, before they are first shown
+    if (event->type() == QEvent::Polish && styleBackend == STYLESHEET_BACKEND && styledRoot
+        && watched->isWidgetType()) {
+        QWidget *widget = static_cast<QWidget *>(watched);
+        if (isStyledDescendant(widget)) {
+            if (widget->isWindow()) {
+                applyWindowPalette(widget);
+            }
+            applyClassRules(widget, currentStyleSheets());
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void ThemeManager::clearStyleSheets(QWidget *widget)
+{
+    clearRules(widget);
+    const QList<QWidget *> children = widget->findChildren<QWidget *>();
+    for (QWidget *child : children) {
+        clearRules(child);
+    }
+}
+
 QString ThemeManager::generateButtonStyleSheet() const
 {
     return QString(
@@ -487,11 +928,66 @@ QString ThemeManager::generateSliderStyleSheet() const
      .arg(currentColors.primaryAccent.name());
 }
 
+QPalette ThemeManager::generatePalette() const
+{
+    // Same ThemeColors roles the style sheets use, expressed as palette roles
+    QPalette palette;
+    palette.setColor(QPalette::Window, currentColors.background);
+    palette.setColor(QPalette::WindowText, currentColors.foreground);
+    palette.setColor(QPalette::Base, currentColors.inputBackground);
+    palette.setColor(QPalette::AlternateBase, currentColors.background);
+    palette.setColor(QPalette::Text, currentColors.inputText);
+    palette.setColor(QPalette::Button, currentColors.buttonBackground);
+    palette.setColor(QPalette::ButtonText, currentColors.buttonText);
+    palette.setColor(QPalette::Highlight, currentColors.primaryAccent);
+    palette.setColor(QPalette::HighlightedText, currentColors.buttonText);
+    palette.setColor(QPalette::Link, currentColors.primaryAccent);
+    palette.setColor(QPalette::ToolTipBase, currentColors.inputBackground);
+    palette.setColor(QPalette::ToolTipText, currentColors.inputText);
+    palette.setColor(QPalette::PlaceholderText, currentColors.remainingText);
+    palette.setColor(QPalette::Light, currentColors.border.lighter(120));
+    palette.setColor(QPalette::Midlight, currentColors.border);
+    palette.setColor(QPalette::Mid, currentColors.border);
+    palette.setColor(QPalette::Dark, currentColors.border.darker(120));
+    palette.setColor(QPalette::Shadow, currentColors.border.darker(150));
+    
+    palette.setColor(QPalette::Disabled, QPalette::Button, currentColors.secondaryAccent);
+    palette.setColor(QPalette::Disabled, QPalette::ButtonText, currentColors.remainingText);
+    palette.setColor(QPalette::Disabled, QPalette::Text, currentColors.remainingText);
+    palette.setColor(QPalette::Disabled, QPalette::WindowText, currentColors.remainingText);
+    
+    return palette;
+}
+
 void ThemeManager::applyToWidget(QWidget *widget)
 {
     if (!widget) return;
     
-    widget->setStyleSheet(generateStyleSheet());
+    if (styleBackend == PALETTE_BACKEND) {
+        // A palette change only repaints; it never re-polishes children like a style sheet does
+        if (!themeStyle) {
+            baseStyleName = QApplication::style()->objectName();
+            themeStyle = new ThemeStyle();
+            QApplication::setStyle(themeStyle);
+        }
+        themeStyle->setColors(currentColors);
+        
+        clearStyleSheets(widget);
+        widget->setPalette(generatePalette());
+        widget->setFont(getUIFont());
+        return;
+    }
+    
+    if (themeStyle) {
+        // The proxy's theme-colored drawing would mix with the style sheet rules; replacing it
+        // deletes it, as QApplication owns the style
+        if (!QApplication::setStyle(baseStyleName)) {
+            QApplication::setStyle(QStyleFactory::keys().value(0, "Fusion"));
+        }
+        themeStyle = nullptr;
+    }
+    
+    applyStyleSheets(widget);
     widget->setFont(getUIFont());
 }
 
@@ -513,4 +1009,26 @@ QColor ThemeManager::getCurrentTextColor() const
 QColor ThemeManager::getRemainingTextColor() const
 {
     return currentColors.remainingText;
+}
+
+TextFormatTablePtr ThemeManager::getTextFormatTable() const
+{
+    return textFormatTable;
+}
+
+void ThemeManager::rebuildTextFormatTable()
+{
+    QBrush foregrounds[TextFormatTable::CHAR_STATE_COUNT];
+    QBrush backgrounds[TextFormatTable::CHAR_STATE_COUNT];
+    
+    foregrounds[TextFormatTable::CORRECT_CHAR] = currentColors.foreground;
+    backgrounds[TextFormatTable::CORRECT_CHAR] = currentColors.correctText;
+    foregrounds[TextFormatTable::INCORRECT_CHAR] = currentColors.foreground;
+    backgrounds[TextFormatTable::INCORRECT_CHAR] = currentColors.incorrectText;
+    foregrounds[TextFormatTable::CURRENT_CHAR] = currentColors.foreground;
+    backgrounds[TextFormatTable::CURRENT_CHAR] = currentColors.currentText;
+    foregrounds[TextFormatTable::REMAINING_CHAR] = currentColors.remainingText;
+    
+    textFormatTable = TextFormatTablePtr(new TextFormatTable(foregrounds, backgrounds, getTextFont(),
+                                                             ++textFormatVersion));
 }
\ No newline at end of file
@@ -18,7 +18,15 @@
 #include <QColor>
 #include <QSettings>
 #include <QMap>
+#include <QHash>
+#include <QPointer>
 #include <QString>
+#include <QStringList>
+#include "textformattable.h"
+
+class ThemeStyle;
+class ThemeLibrary;
+class QThread;
 
 class ThemeManager : public QObject
 {
@@ -32,6 +40,12 @@ public:
         CUSTOM_THEME
     };
 
+    // How themes are applied to widgets
+    enum StyleBackend {
+        STYLESHEET_BACKEND, // Generated Qt style sheet on the top-level widget
+        PALETTE_BACKEND     // Native QPalette/QFont with a QProxyStyle, no style sheet
+    };
+
     enum FontSize {
         SMALL_FONT = 10,
         MEDIUM_FONT = 12,
@@ -57,6 +71,9 @@ public:
         QColor success;
         QColor warning;
         QColor error;
+        
+        bool operator==(const ThemeColors &other) const;
+        bool operator!=(const ThemeColors &other) const { return !(*this == other); }
     };
 
     explicit ThemeManager(QObject *parent = nullptr);
@@ -68,6 +85,13 @@ public:
     ThemeType getCurrentTheme() const;
     ThemeColors getCurrentColors() const;
     
+    // Theme files (JSON in the themes directories), reloaded live when they change on disk
+    QStringList getThemeFiles() const;
+    QString getThemeFileName(const QString &id) const;
+    bool applyThemeFile(const QString &id);
+    QString getCurrentThemeFile() const;
+    static QStringList getThemeDirectories();
+    
     // Font management
     void setFontFamily(const QString &family);
     void setFontSize(FontSize size);
@@ -83,27 +107,54 @@ public:
     void setLargeTextMode(bool enabled);
     bool isLargeTextMode() const;
     
+    // Backend selection
+    void setStyleBackend(StyleBackend backend);
+    StyleBackend getStyleBackend() const;
+    
     // Persistence
     void saveSettings();
     void loadSettings();
     
     // Utility methods
     QString generateStyleSheet() const;
+    QPalette generatePalette() const;
     void applyToWidget(QWidget *widget);
     QColor getCorrectTextColor() const;
     QColor getIncorrectTextColor() const;
     QColor getCurrentTextColor() const;
     QColor getRemainingTextColor() const;
+    
+    // Prebuilt passage formats for the current theme and font; swapped, never modified
+    TextFormatTablePtr getTextFormatTable() const;
+
+protected:
+    // Themes widgets created after applyToWidget(), such as message boxes, as they are first polished
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 signals:
     void themeChanged();
     void fontChanged();
+    void themeFilesChanged();
+
+private slots:
+    void rebuildTextFormatTable();
+    void onThemeFilesChanged();
+    void onThemeFileUpdated(const QString &id);
 
 private:
+    // Generated rules split per widget class so only widgets whose rules changed get re-polished
+    struct StyleSheetSet {
+        QString window;                     // QMainWindow rule, only used by generateStyleSheet()
+        QMap<QString, QString> fragments;   // Widget class name -> its rules
+    };
+    
     void initializeThemes();
     void setupLightTheme();
     void setupDarkTheme();
     void setupHighContrastTheme();
+    static QString getUserThemeDirectory();
+    bool readThemeFile(const QString &id, ThemeColors &colors) const;
+    void migrateCustomThemeSettings();
     QString generateButtonStyleSheet() const;
     QString generateInputStyleSheet() const;
     QString generateLabelStyleSheet() const;
@@ -112,15 +163,44 @@ private:
     QString generateCheckBoxStyleSheet() const;
     QString generateSliderStyleSheet() const;
     
+    // Style sheet cache, keyed by a stable hash of everything the style sheets depend on
+    quint64 styleStateKey() const;
+    const StyleSheetSet &currentStyleSheets() const;
+    QString styleSheetCachePath() const;
+    void loadStyleSheetCache();
+    void waitForStyleSheetCache() const;
+    static QHash<quint64, StyleSheetSet> readStyleSheetCache(const QString &path);
+    void saveStyleSheetCache() const;
+    void applyStyleSheets(QWidget *widget);
+    void applyWindowPalette(QWidget *window) const;
+    void applyClassRules(QWidget *widget, const StyleSheetSet &sheets) const;
+    void clearStyleSheets(QWidget *widget);
+    bool isStyledDescendant(QWidget *widget) const;
+    
     ThemeType currentTheme;
     ThemeColors currentColors;
     QString fontFamily;
     int fontSize;
     bool highContrastMode;
     bool largeTextMode;
+    StyleBackend styleBackend;
+    ThemeStyle *themeStyle; // Owned by QApplication once installed
+    QString baseStyleName;  // Application style themeStyle replaced, restored for style sheets
+    QPointer<QWidget> styledRoot; // Last widget given style sheet rules; its later children get them too
     
     QMap<ThemeType, ThemeColors> predefinedThemes;
     QSettings *settings;
+    ThemeLibrary *themeLibrary;
+    QString currentThemeFile;
+    TextFormatTablePtr textFormatTable;
+    quint64 textFormatVersion;
+    
+    mutable QHash<quint64, StyleSheetSet> styleSheetCache;
+    mutable QHash<quint64, StyleSheetSet> loadedStyleSheetCache; // Written only by the loader thread
+    mutable QThread *styleSheetCacheLoader;
+    mutable bool styleSheetCacheDirty;
+    
+    static const int MAX_CACHED_STYLE_SHEETS = 32;
 };
 
 #endif // THEMEMANAGER_H
\ No newline at end of file
@@ -0,0 +1,83 @@
+/**
+ * Typing Speed Test - Theme Style Implementation
+ *
+ * Native QProxyStyle used by the palette theming backend. Draws the rounded
+ * buttons, inputs and indicators the stylesheet backend describes in CSS,
+ * using only palette and ThemeColors values.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "themestyle.h"
+#include <QStyleFactory>
+#include <QStyleOption>
+#include <QPainter>
+
+ThemeStyle::ThemeStyle()
+    : QProxyStyle(QStyleFactory::create("Fusion")) // Fusion follows the palette on every platform
+{
+}
+
+void ThemeStyle::setColors(const ThemeManager::ThemeColors &themeColors)
+{
+    colors = themeColors;
+}
+
+void ThemeStyle::drawPrimitive(PrimitiveElement element, const QStyleOption *option,
+                               QPainter *painter, const QWidget *widget) const
+{
+    switch (element) {
+        case PE_PanelButtonCommand: {
+            // Matches generateButtonStyleSheet(): 4px radius, lighter on hover, darker when pressed
+            QColor fill = option->palette.color(QPalette::Button);
+            if (!(option->state & State_Enabled)) {
+                fill = colors.secondaryAccent;
+            } else if (option->state & (State_Sunken | State_On)) {
+                fill = fill.darker(110);
+            } else if (option->state & State_MouseOver) {
+                fill = fill.lighter(110);
+            }
+
+            painter->save();
+            painter->setRenderHint(QPainter::Antialiasing);
+            painter->setPen(colors.border);
+            painter->setBrush(fill);
+            painter->drawRoundedRect(QRectF(option->rect).adjusted(0.5, 0.5, -0.5, -0.5), 4, 4);
+            painter->restore();
+            return;
+        }
+        case PE_FrameLineEdit: {
+            // Matches generateInputStyleSheet(): 1px border, 2px accent border with focus
+            const bool focused = option->state & State_HasFocus;
+            const qreal width = focused ? 2.0 : 1.0;
+
+            painter->save();
+            painter->setRenderHint(QPainter::Antialiasing);
+            painter->setPen(QPen(focused ? colors.primaryAccent : colors.border, width));
+            painter->setBrush(Qt::NoBrush);
+            const qreal inset = width / 2.0;
+            painter->drawRoundedRect(QRectF(option->rect).adjusted(inset, inset, -inset, -inset), 4, 4);
+            painter->restore();
+            return;
+        }
+        default:
+            break;
+    }
+
+    QProxyStyle::drawPrimitive(element, option, painter, widget);
+}
+
+int ThemeStyle::pixelMetric(PixelMetric metric, const QStyleOption *option, const QWidget *widget) const
+{
+    switch (metric) {
+        case PM_IndicatorWidth:
+        case PM_IndicatorHeight:
+            return 16;
+        case PM_SliderControlThickness:
+        case PM_SliderLength:
+            return 16;
+        default:
+            return QProxyStyle::pixelMetric(metric, option, widget);
+    }
+}
@@ -0,0 +1,36 @@
+/**
+ * Typing Speed Test - Theme Style
+ *
+ * Native QProxyStyle used by the palette theming backend. Draws the rounded
+ * buttons, inputs and indicators the stylesheet backend describes in CSS,
+ * using only palette and ThemeColors values.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef THEMESTYLE_H
+#define THEMESTYLE_H
+
+#include <QProxyStyle>
+#include "thememanager.h"
+
+class ThemeStyle : public QProxyStyle
+{
+    Q_OBJECT
+
+public:
+    ThemeStyle();
+
+    void setColors(const ThemeManager::ThemeColors &themeColors);
+
+    void drawPrimitive(PrimitiveElement element, const QStyleOption *option,
+                       QPainter *painter, const QWidget *widget = nullptr) const override;
+    int pixelMetric(PixelMetric metric, const QStyleOption *option = nullptr,
+                    const QWidget *widget = nullptr) const override;
+
+private:
+    ThemeManager::ThemeColors colors;
+};
+
+#endif // THEMESTYLE_H
@@ -1,6 +1,12 @@
 #include "mainwindow.h"
 #include "../core/typingtest.h"
+#include "../core/startupprofile.h"
+#include "../core/keyboardlayout.h"
+#include "../core/sentencescorer.h"
+#include "../core/snippetindex.h"
+#include "passageview.h"
 #include <QScreen>
+#include <QFileDialog>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -11,30 +17,63 @@ MainWindow::MainWindow(QWidget *parent)
     , soundManager(nullptr)
     , themeManager(nullptr)
     , currentUser("Guest")
+    , lastInputLength(0)
+    , databaseStartNs(0)
+    , audioStartNs(0)
+    , pendingStartupPhases(STARTUP_PHASES)
+    , firstPaintDone(false)
 {
-    setupUI();
+    // Staged startup: slow initialization runs on worker threads while the window is built
+    // and painted, and the controls that depend on it are enabled as each part lands
+    themeManager = new ThemeManager(this); // Reads the style sheet cache on a worker thread
+    StartupProfile::mark("theme settings");
     
-    // Initialize managers
+    databaseStartNs = StartupProfile::now();
     statsManager = new StatisticsManager(this);
-    if (!statsManager->initializeDatabase()) {
-        qDebug() << "Failed to initialize database";
-    }
+    connect(statsManager, &StatisticsManager::databaseReady, this, &MainWindow::onDatabaseReady);
+    statsManager->initializeDatabaseAsync();
+    
+    audioStartNs = StartupProfile::now();
+    soundManager = new SoundManager(this); // Opens the audio device on the audio thread
+    connect(soundManager, &SoundManager::audioReady, this, &MainWindow::onAudioReady);
+    StartupProfile::mark("start workers");
+    
+    setupUI();
+    StartupProfile::mark("setup UI");
     
     lessonManager = new LessonManager(this);
-    soundManager = new SoundManager(this);
-    themeManager = new ThemeManager(this);
     typingTest = new TypingTest(this);
+    if (typingTest->hasGeneratedText()) {
+        modeCombo->addItem("Generated Text", static_cast<int>(TypingTest::GENERATED_TEST));
+    }
+    const QList<int> codeLanguages = typingTest->getCodeLanguages();
+    if (!codeLanguages.isEmpty()) {
+        modeCombo->addItem("Source Code", static_cast<int>(TypingTest::CODE_TEST));
+        for (int language : codeLanguages) {
+            codeLanguageCombo->addItem(SnippetIndex::getLanguageName(language), language);
+        }
+        typingTest->setCodeLanguage(codeLanguages.first());
+    }
+    StartupProfile::mark("first passage");
     
     connect(typingTest, &TypingTest::statsUpdated, this, &MainWindow::updateStats);
     connect(inputField, &QLineEdit::textChanged, typingTest, &TypingTest::onTextChanged);
+    connect(inputField, &QLineEdit::textChanged, this, &MainWindow::playKeystrokeFeedback);
     connect(inputField, &QLineEdit::textChanged, this, &MainWindow::updateTextDisplay);
+    connect(inputField, &QLineEdit::textChanged, this, &MainWindow::commitTypedText); // After everything reading the input
     connect(startButton, &QPushButton::clicked, this, &MainWindow::startTest);
     connect(resetButton, &QPushButton::clicked, this, &MainWindow::resetTest);
+    connect(loadTextButton, &QPushButton::clicked, this, &MainWindow::loadText);
     connect(difficultyCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onDifficultyChanged);
+    connect(difficultySlider, &QSlider::valueChanged, this, &MainWindow::onDifficultyScoreChanged);
+    connect(typingTest, &TypingTest::difficultyAdapted, this, &MainWindow::onDifficultyAdapted);
     connect(durationCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onDurationChanged);
     connect(modeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onModeChanged);
     connect(lessonTypeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onLessonTypeChanged);
     connect(lessonLevelCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onLessonLevelChanged);
+    connect(codeLanguageCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onCodeLanguageChanged);
+    connect(keyboardLayoutCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onKeyboardLayoutChanged);
+    connect(inputField, &QLineEdit::returnPressed, this, &MainWindow::onReturnPressed);
     connect(soundEnabledCheckBox, &QCheckBox::toggled, this, &MainWindow::onSoundToggled);
     connect(keystrokeSoundCheckBox, &QCheckBox::toggled, this, &MainWindow::onKeystrokeSoundToggled);
     connect(volumeSlider, &QSlider::valueChanged, this, &MainWindow::onVolumeChanged);
@@ -45,19 +84,16 @@ MainWindow::MainWindow(QWidget *parent)
     connect(largeTextCheckBox, &QCheckBox::toggled, this, &MainWindow::onLargeTextToggled);
     connect(themeManager, &ThemeManager::themeChanged, this, &MainWindow::applyCurrentTheme);
     connect(themeManager, &ThemeManager::fontChanged, this, &MainWindow::applyCurrentTheme);
+    connect(themeManager, &ThemeManager::themeFilesChanged, this, &MainWindow::refreshThemeFiles);
     connect(userCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::onUserChanged);
     connect(statsButton, &QPushButton::clicked, this, &MainWindow::showUserStats);
     
-    // Initialize user list
-    QStringList users = statsManager->getAllUsers();
-    if (!users.contains("Guest")) {
-        statsManager->createUser("Guest");
-        users.prepend("Guest");
-    }
-    
-    userCombo->clear();
-    userCombo->addItems(users);
-    userCombo->setCurrentText("Guest");
+    // Enabled by onDatabaseReady() and onAudioReady()
+    userCombo->setEnabled(false);
+    statsButton->setEnabled(false);
+    soundEnabledCheckBox->setEnabled(false);
+    keystrokeSoundCheckBox->setEnabled(false);
+    volumeSlider->setEnabled(false);
     
     // Initialize theme controls with current settings
     themeCombo->setCurrentIndex(static_cast<int>(themeManager->getCurrentTheme()));
@@ -77,6 +113,7 @@ MainWindow::MainWindow(QWidget *parent)
     
     // Apply the initial theme
     applyCurrentTheme();
+    StartupProfile::mark("apply theme");
     
     setWindowTitle("Typing Speed Test");
     resize(800, 600);
@@ -93,6 +130,77 @@ MainWindow::~MainWindow()
 {
 }
 
+void MainWindow::setSessionSeed(quint64 seed)
+{
+    typingTest->setSessionSeed(seed);
+    
+    if (!inputField->isEnabled()) {
+        updateTextDisplay();
+    }
+}
+
+void MainWindow::paintEvent(QPaintEvent *event)
+{
+    QMainWindow::paintEvent(event);
+    
+    if (!firstPaintDone) {
+        firstPaintDone = true;
+        StartupProfile::mark("first paint");
+        finishStartupPhase();
+    }
+}
+
+void MainWindow::onDatabaseReady(bool success)
+{
+    StartupProfile::markAsync("database", databaseStartNs);
+    
+    if (!success) {
+        qDebug() << "Failed to initialize database";
+        userCombo->setToolTip("Statistics are unavailable: the database could not be opened");
+        finishStartupPhase();
+        return;
+    }
+    
+    // Initialize user list
+    QStringList users = statsManager->getAllUsers();
+    if (!users.contains("Guest")) {
+        statsManager->createUser("Guest");
+        users.prepend("Guest");
+    }
+    
+    {
+        QSignalBlocker blocker(userCombo);
+        userCombo->clear();
+        userCombo->addItems(users);
+        userCombo->setCurrentText(currentUser);
+    }
+    userCombo->setEnabled(true);
+    statsButton->setEnabled(true);
+    finishStartupPhase();
+}
+
+void MainWindow::onAudioReady(bool available)
+{
+    StartupProfile::markAsync("audio device", audioStartNs);
+    
+    soundEnabledCheckBox->setEnabled(available);
+    if (available) {
+        keystrokeSoundCheckBox->setEnabled(soundEnabledCheckBox->isChecked());
+        volumeSlider->setEnabled(soundEnabledCheckBox->isChecked());
+    } else {
+        soundEnabledCheckBox->setToolTip("No audio output device is available");
+    }
+    finishStartupPhase();
+}
+
+void MainWindow::finishStartupPhase()
+{
+    // First paint, database and audio device
+    if (--pendingStartupPhases == 0) {
+        StartupProfile::report();
+    }
+}
+
 void MainWindow::setupUI()
 {
     centralWidget = new QWidget(this);
@@ -112,15 +220,12 @@ void MainWindow::setupUI()
     mainLayout->addWidget(titleLabel);
     
     // Sample text display
-    sampleTextLabel = new QLabel(this);
-    sampleTextLabel->setWordWrap(true);
-    sampleTextLabel->setAlignment(Qt::AlignLeft);
-    sampleTextLabel->setStyleSheet("QLabel { background-color: #f0f0f0; padding: 15px; border-radius: 5px; }");
-    QFont textFont = sampleTextLabel->font();
+    passageView = new PassageView(this);
+    QFont textFont = passageView->font();
     textFont.setPointSize(14);
-    sampleTextLabel->setFont(textFont);
-    sampleTextLabel->setMinimumHeight(120);
-    mainLayout->addWidget(sampleTextLabel);
+    passageView->setFont(textFont);
+    passageView->setMinimumHeight(120);
+    mainLayout->addWidget(passageView);
     
     // Input field
     inputField = new QLineEdit(this);
@@ -164,16 +269,34 @@ void MainWindow::setupUI()
     difficultyCombo->addItem("Easy");
     difficultyCombo->addItem("Medium");
     difficultyCombo->addItem("Hard");
+    difficultyCombo->addItem("Custom");
+    difficultyCombo->addItem("Adaptive");
     difficultyCombo->setCurrentIndex(1); // Default to Medium
     
+    difficultySlider = new QSlider(Qt::Horizontal, this);
+    difficultySlider->setRange(0, 100);
+    difficultySlider->setMaximumWidth(120);
+    difficultySlider->setToolTip("Sentence difficulty score");
+    difficultySlider->setVisible(false);
+    
     durationLabel = new QLabel("Duration:", this);
     durationCombo = new QComboBox(this);
     durationCombo->addItem("15 seconds", 15);
     durationCombo->addItem("30 seconds", 30);
     durationCombo->addItem("60 seconds", 60);
     durationCombo->addItem("120 seconds", 120);
+    durationCombo->addItem("Endless", 0);
     durationCombo->setCurrentIndex(2); // Default to 60 seconds
     
+    keyboardLayoutLabel = new QLabel("Keyboard:", this);
+    keyboardLayoutCombo = new QComboBox(this);
+    for (int layout = 0; layout < KeyboardLayout::LAYOUT_COUNT; ++layout) {
+        const KeyboardLayout::Layout keyboardLayout = static_cast<KeyboardLayout::Layout>(layout);
+        keyboardLayoutCombo->addItem(KeyboardLayout::getLayoutName(keyboardLayout) + " ("
+                                     + KeyboardLayout::getLanguageName(KeyboardLayout::getLanguage(keyboardLayout)) + ")", layout);
+    }
+    keyboardLayoutCombo->setToolTip("Keys of the row and finger lessons, and the language of the passages");
+    
     modeLabel = new QLabel("Mode:", this);
     modeCombo = new QComboBox(this);
     modeCombo->addItem("Standard Test", static_cast<int>(TypingTest::STANDARD_TEST));
@@ -183,8 +306,11 @@ void MainWindow::setupUI()
     settingsLayout->addWidget(modeCombo);
     settingsLayout->addWidget(difficultyLabel);
     settingsLayout->addWidget(difficultyCombo);
+    settingsLayout->addWidget(difficultySlider);
     settingsLayout->addWidget(durationLabel);
     settingsLayout->addWidget(durationCombo);
+    settingsLayout->addWidget(keyboardLayoutLabel);
+    settingsLayout->addWidget(keyboardLayoutCombo);
     settingsLayout->addStretch();
     
     mainLayout->addLayout(settingsLayout);
@@ -198,10 +324,12 @@ void MainWindow::setupUI()
     lessonTypeCombo->addItem("Home Row Keys", static_cast<int>(LessonManager::HOME_ROW));
     lessonTypeCombo->addItem("Top Row Keys", static_cast<int>(LessonManager::TOP_ROW));
     lessonTypeCombo->addItem("Bottom Row Keys", static_cast<int>(LessonManager::BOTTOM_ROW));
+    lessonTypeCombo->addItem("Finger Training", static_cast<int>(LessonManager::FINGER_SPECIFIC));
     lessonTypeCombo->addItem("Numbers", static_cast<int>(LessonManager::NUMBERS));
     lessonTypeCombo->addItem("Punctuation", static_cast<int>(LessonManager::PUNCTUATION));
     lessonTypeCombo->addItem("Common Words", static_cast<int>(LessonManager::COMMON_WORDS));
     lessonTypeCombo->addItem("Letter Pairs", static_cast<int>(LessonManager::BIGRAMS));
+    lessonTypeCombo->addItem("Weak Letter Pairs", static_cast<int>(LessonManager::WEAK_NGRAMS));
     lessonTypeCombo->addItem("Programming", static_cast<int>(LessonManager::PROGRAMMING));
     
     lessonLevelLabel = new QLabel("Level:", this);
@@ -216,6 +344,12 @@ void MainWindow::setupUI()
     lessonLayout->addWidget(lessonTypeCombo);
     lessonLayout->addWidget(lessonLevelLabel);
     lessonLayout->addWidget(lessonLevelCombo);
+    
+    // Filled with the indexed languages once the passage provider is up
+    codeLanguageLabel = new QLabel("Language:", this);
+    codeLanguageCombo = new QComboBox(this);
+    lessonLayout->addWidget(codeLanguageLabel);
+    lessonLayout->addWidget(codeLanguageCombo);
     lessonLayout->addStretch();
     
     // Initially hide lesson controls
@@ -223,6 +357,8 @@ void MainWindow::setupUI()
     lessonTypeCombo->setVisible(false);
     lessonLevelLabel->setVisible(false);
     lessonLevelCombo->setVisible(false);
+    codeLanguageLabel->setVisible(false);
+    codeLanguageCombo->setVisible(false);
     
     mainLayout->addLayout(lessonLayout);
     
@@ -304,6 +440,9 @@ void MainWindow::setupUI()
     wpmLabel = new QLabel("WPM: 0", this);
     accuracyLabel = new QLabel("Accuracy: 100%", this);
     timeLabel = new QLabel("Time: 0s", this);
+    speedLabel = new QLabel(this);
+    speedLabel->setToolTip("Raw WPM counts every keystroke; the last 5 seconds and the best of those (burst) "
+                           "count correct ones; consistency is how even the time between keystrokes is");
     
     QFont statsFont;
     statsFont.setPointSize(12);
@@ -315,6 +454,7 @@ void MainWindow::setupUI()
     statsLayout->addWidget(wpmLabel);
     statsLayout->addWidget(accuracyLabel);
     statsLayout->addWidget(timeLabel);
+    statsLayout->addWidget(speedLabel);
     statsLayout->addStretch();
     
     mainLayout->addLayout(statsLayout);
@@ -325,12 +465,15 @@ void MainWindow::setupUI()
     
     startButton = new QPushButton("Start Test", this);
     resetButton = new QPushButton("Reset", this);
+    loadTextButton = new QPushButton("Load Text...", this);
     
     startButton->setMinimumHeight(40);
     resetButton->setMinimumHeight(40);
+    loadTextButton->setMinimumHeight(40);
     
     buttonLayout->addWidget(startButton);
     buttonLayout->addWidget(resetButton);
+    buttonLayout->addWidget(loadTextButton);
     buttonLayout->addStretch();
     
     mainLayout->addLayout(buttonLayout);
@@ -341,9 +484,10 @@ void MainWindow::startTest()
 {
     inputField->setEnabled(true);
     inputField->clear();
+    lastInputLength = 0;
     inputField->setFocus();
     startButton->setEnabled(false);
-    progressBar->setVisible(true);
+    progressBar->setVisible(!typingTest->isEndless());
     
     // Play start sound
     if (soundManager) {
@@ -356,6 +500,12 @@ void MainWindow::startTest()
 
 void MainWindow::resetTest()
 {
+    // A running endless test has no other way to finish, so the first press ends and saves it
+    if (typingTest->isEndless() && inputField->isEnabled()) {
+        typingTest->stopTest();
+        return;
+    }
+    
     inputField->clear();
     inputField->setEnabled(false);
     startButton->setEnabled(true);
@@ -364,17 +514,28 @@ void MainWindow::resetTest()
     wpmLabel->setText("WPM: 0");
     accuracyLabel->setText("Accuracy: 100%");
     timeLabel->setText("Time: 0s");
+    speedLabel->clear();
     
     typingTest->resetTest();
     
     // Show appropriate message based on mode
     if (typingTest->getTestMode() == TypingTest::LESSON_MODE) {
-        QString lessonTitle = lessonManager->getLessonTitle(static_cast<LessonManager::LessonType>(lessonTypeCombo->currentData().toInt()));
-        QString lessonDesc = lessonManager->getLessonDescription(static_cast<LessonManager::LessonType>(lessonTypeCombo->currentData().toInt()));
+        const LessonManager::LessonType lessonType = static_cast<LessonManager::LessonType>(lessonTypeCombo->currentData().toInt());
+        QString lessonTitle = lessonManager->getLessonTitle(lessonType);
+        QString lessonDesc = lessonManager->getLessonDescription(lessonType);
         int level = lessonLevelCombo->currentData().toInt();
         
-        sampleTextLabel->setText(QString("Ready for %1 (Level %2)\n%3\nClick 'Start Test' to begin...")
-                               .arg(lessonTitle).arg(level).arg(lessonDesc));
+        // Descriptions name the QWERTY keys; row and finger lessons drill the chosen layout's
+        const QString keys = lessonManager->getLessonKeys(lessonType, level);
+        if (!keys.isEmpty()) {
+            lessonDesc = "Keys:";
+            for (QChar key : keys) {
+                lessonDesc += QLatin1Char(' ') + key;
+            }
+        }
+        
+        passageView->setMessage(QString("Ready for %1 (Level %2)\n%3\nClick 'Start Test' to begin...")
+                                .arg(lessonTitle).arg(level).arg(lessonDesc));
     } else {
         // Standard test mode
         QString difficultyText;
@@ -389,11 +550,52 @@ void MainWindow::resetTest()
                 difficultyText = "Hard";
                 break;
         }
+        if (typingTest->getDifficultyScore() >= 0) {
+            difficultyText += QString(" (level %1)").arg(qRound(typingTest->getDifficultyScore() * 100));
+        }
         
         int duration = typingTest->getTestDuration();
-        sampleTextLabel->setText(QString("Click 'Start Test' to begin %1 difficulty test (%2 seconds)...")
-                               .arg(difficultyText).arg(duration));
+        const QString length = typingTest->isEndless() ? QString("endless") : QString("%1 seconds").arg(duration);
+        QString test = "test";
+        if (typingTest->getTestMode() == TypingTest::CODE_TEST) {
+            test = SnippetIndex::getLanguageName(typingTest->getCodeLanguage()) + " code test";
+        } else if (typingTest->getTestMode() == TypingTest::LOADED_TEXT_TEST) {
+            test = "loaded text test";
+        }
+        passageView->setMessage(QString("Click 'Start Test' to begin %1 difficulty %2 (%3)...")
+                                .arg(difficultyText).arg(test).arg(length));
+    }
+}
+
+void MainWindow::loadText()
+{
+    if (inputField->isEnabled()) return;
+    
+    const QString path = QFileDialog::getOpenFileName(this, "Load Text", QString(), "Text files (*.txt);;All files (*)");
+    if (path.isEmpty()) {
+        return;
     }
+    
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, "Load Text", "Cannot open " + path);
+        return;
+    }
+    const QString text = QString::fromUtf8(file.readAll());
+    if (text.simplified().isEmpty()) {
+        QMessageBox::information(this, "Load Text", "The file has no text to type.");
+        return;
+    }
+    
+    // However long the text, the input field only ever holds the last few hundred characters typed
+    typingTest->setLoadedText(text);
+    int modeIndex = modeCombo->findData(static_cast<int>(TypingTest::LOADED_TEXT_TEST));
+    if (modeIndex < 0) {
+        modeCombo->addItem("Loaded Text", static_cast<int>(TypingTest::LOADED_TEXT_TEST));
+        modeIndex = modeCombo->count() - 1;
+    }
+    modeCombo->setCurrentIndex(modeIndex);
+    resetTest();
 }
 
 void MainWindow::updateStats()
@@ -402,6 +604,16 @@ void MainWindow::updateStats()
     accuracyLabel->setText(QString("Accuracy: %1%").arg(typingTest->getAccuracy(), 0, 'f', 1));
     timeLabel->setText(QString("Time: %1s").arg(typingTest->getElapsedTime()));
     
+    // Live figures are kept current by the test; reading them costs nothing
+    const SpeedSnapshot &speed = typingTest->getSpeedSnapshot();
+    if (speed.keystrokes > 0) {
+        speedLabel->setText(QString("Raw: %1  Last 5s: %2  Burst: %3  Consistency: %4%")
+                            .arg(speed.rawWPM, 0, 'f', 0)
+                            .arg(speed.rollingWPM, 0, 'f', 0)
+                            .arg(speed.burstWPM, 0, 'f', 0)
+                            .arg(speed.consistency, 0, 'f', 0));
+    }
+    
     progressBar->setValue(typingTest->getProgress());
     
     if (typingTest->isTestComplete()) {
@@ -418,6 +630,8 @@ void MainWindow::updateStats()
         result.timeSpent = typingTest->getElapsedTime();
         result.correctCharacters = typingTest->getCorrectCharacters();
         result.totalCharacters = typingTest->getTotalCharacters();
+        result.passageSeed = typingTest->getPassageSeed();
+        result.passageRequest = typingTest->getPassageRequest().toString();
         
         if (statsManager->saveTestResult(result)) {
             qDebug() << "Test result saved successfully";
@@ -434,79 +648,85 @@ void MainWindow::updateStats()
             }
         }
         
-        QString resultText = QString("Test Complete!\nFinal WPM: %1\nAccuracy: %2%\nTime: %3s")
+        QString resultText = QString("Test Complete!\nFinal WPM: %1 (raw %2, burst %3)\nAccuracy: %4%\n"
+                                     "Corrected errors: %5\nConsistency: %6%\nTime: %7s")
                            .arg(typingTest->getWPM())
+                           .arg(speed.rawWPM, 0, 'f', 0)
+                           .arg(speed.burstWPM, 0, 'f', 0)
                            .arg(typingTest->getAccuracy(), 0, 'f', 1)
+                           .arg(typingTest->getCorrectedErrors())
+                           .arg(speed.consistency, 0, 'f', 0)
                            .arg(typingTest->getElapsedTime());
         
-        sampleTextLabel->setText(resultText);
+        passageView->setMessage(resultText);
     }
 }
 
 void MainWindow::updateTextDisplay()
 {
-    if (!typingTest) return;
+    if (!typingTest || !themeManager) return;
     
     QString sampleText = typingTest->getSampleText();
-    QString inputText = inputField->text();
     
     if (sampleText.isEmpty() || !inputField->isEnabled()) {
         return;
     }
     
-    // Check if we just typed a character and play sound feedback
-    static int lastInputLength = 0;
-    if (inputText.length() > lastInputLength && inputText.length() <= sampleText.length()) {
-        int lastCharIndex = inputText.length() - 1;
-        if (lastCharIndex >= 0 && soundManager) {
-            QChar inputChar = inputText[lastCharIndex];
-            QChar sampleChar = sampleText[lastCharIndex];
-            bool isCorrect = (inputChar == sampleChar);
-            soundManager->playKeystrokeSound(isCorrect);
-        }
+    // Only the chunks on screen are laid out and colored, however long the passage is
+    passageView->setFormats(themeManager->getTextFormatTable());
+    passageView->setPassage(sampleText);
+    passageView->setInput(typingTest->getCorrectness());
+}
+
+void MainWindow::playKeystrokeFeedback(const QString &inputText)
+{
+    if (!typingTest || !soundManager || !inputField->isEnabled()) return;
+    
+    // Only posts a trigger to the audio thread; kept out of the render path
+    const int typedLength = typingTest->getInputOffset() + inputText.length();
+    if (inputText.length() > lastInputLength && typedLength <= typingTest->getSampleText().length()) {
+        soundManager->playKeystrokeSound(typingTest->isLastCharacterCorrect());
     }
     lastInputLength = inputText.length();
-    
-    QString htmlText = "<span style='font-family: monospace; font-size: 14px;'>";
-    
-    for (int i = 0; i < sampleText.length(); ++i) {
-        QChar sampleChar = sampleText[i];
+}
+
+void MainWindow::commitTypedText()
+{
+    // The field keeps only recent input, so each keystroke costs the same at any passage length
+    const int retired = typingTest->retireTypedText();
+    if (retired > 0) {
+        QSignalBlocker blocker(inputField);
+        inputField->setText(inputField->text().mid(retired));
+        lastInputLength -= retired;
         
-        if (i < inputText.length()) {
-            QChar inputChar = inputText[i];
-            if (inputChar == sampleChar) {
-                QString bgColor = themeManager ? themeManager->getCorrectTextColor().name() : "#90EE90";
-                QString textColor = themeManager ? themeManager->getCurrentColors().foreground.name() : "#000000";
-                htmlText += QString("<span style='background-color: %1; color: %2;'>%3</span>")
-                           .arg(bgColor).arg(textColor).arg(sampleChar.unicode() == ' ' ? "&nbsp;" : QString(sampleChar));
-            } else {
-                QString bgColor = themeManager ? themeManager->getIncorrectTextColor().name() : "#FFB6C1";
-                QString textColor = themeManager ? themeManager->getCurrentColors().foreground.name() : "#8B0000";
-                htmlText += QString("<span style='background-color: %1; color: %2;'>%3</span>")
-                           .arg(bgColor).arg(textColor).arg(sampleChar.unicode() == ' ' ? "&nbsp;" : QString(sampleChar));
-            }
-        } else if (i == inputText.length()) {
-            QString bgColor = themeManager ? themeManager->getCurrentTextColor().name() : "#87CEEB";
-            QString textColor = themeManager ? themeManager->getCurrentColors().foreground.name() : "#000000";
-            htmlText += QString("<span style='background-color: %1; color: %2;'>%3</span>")
-                       .arg(bgColor).arg(textColor).arg(sampleChar.unicode() == ' ' ? "&nbsp;" : QString(sampleChar));
-        } else {
-            QString textColor = themeManager ? themeManager->getRemainingTextColor().name() : "#696969";
-            htmlText += QString("<span style='color: %1;'>%2</span>")
-                       .arg(textColor).arg(sampleChar.unicode() == ' ' ? "&nbsp;" : QString(sampleChar));
-        }
+        // An endless test has just dropped the front of its passage and bits; the view still has
+        // the old passage, so it is brought up to date before it next paints
+        updateTextDisplay();
     }
-    
-    htmlText += "</span>";
-    sampleTextLabel->setText(htmlText);
 }
 
 void MainWindow::onDifficultyChanged(int index)
 {
     if (!typingTest) return;
     
-    TypingTest::DifficultyLevel difficulty = static_cast<TypingTest::DifficultyLevel>(index);
-    typingTest->setDifficulty(difficulty);
+    difficultySlider->setVisible(index >= CUSTOM_DIFFICULTY_INDEX);
+    difficultySlider->setEnabled(index == CUSTOM_DIFFICULTY_INDEX); // Adaptive only shows its level
+    
+    if (index == ADAPTIVE_DIFFICULTY_INDEX) {
+        typingTest->setAdaptiveDifficulty(true);
+        onDifficultyAdapted(typingTest->getDifficultyScore());
+    } else if (index == CUSTOM_DIFFICULTY_INDEX) {
+        typingTest->setAdaptiveDifficulty(false);
+        float score = typingTest->getDifficultyScore();
+        if (score < 0) {
+            score = SentenceScorer::centerOf(typingTest->getDifficulty());
+        }
+        onDifficultyAdapted(score);
+        typingTest->setDifficultyScore(score);
+    } else {
+        TypingTest::DifficultyLevel difficulty = static_cast<TypingTest::DifficultyLevel>(index);
+        typingTest->setDifficulty(difficulty);
+    }
     
     // Update the display if not currently testing
     if (!inputField->isEnabled()) {
@@ -514,6 +734,23 @@ void MainWindow::onDifficultyChanged(int index)
     }
 }
 
+void MainWindow::onDifficultyScoreChanged(int value)
+{
+    if (!typingTest || difficultyCombo->currentIndex() != CUSTOM_DIFFICULTY_INDEX) return;
+    
+    typingTest->setDifficultyScore(value / 100.0f);
+    
+    if (!inputField->isEnabled()) {
+        updateTextDisplay();
+    }
+}
+
+void MainWindow::onDifficultyAdapted(float score)
+{
+    QSignalBlocker blocker(difficultySlider);
+    difficultySlider->setValue(qRound(score * 100));
+}
+
 void MainWindow::onDurationChanged(int index)
 {
     if (!typingTest) return;
@@ -535,10 +772,13 @@ void MainWindow::onModeChanged(int index)
     lessonTypeCombo->setVisible(showLessonControls);
     lessonLevelLabel->setVisible(showLessonControls);
     lessonLevelCombo->setVisible(showLessonControls);
+    codeLanguageLabel->setVisible(mode == TypingTest::CODE_TEST);
+    codeLanguageCombo->setVisible(mode == TypingTest::CODE_TEST);
     
     // Hide difficulty controls in lesson mode (lessons have their own progression)
     difficultyLabel->setVisible(!showLessonControls);
     difficultyCombo->setVisible(!showLessonControls);
+    difficultySlider->setVisible(!showLessonControls && difficultyCombo->currentIndex() >= CUSTOM_DIFFICULTY_INDEX);
     
     // Update display
     if (!inputField->isEnabled()) {
@@ -572,6 +812,49 @@ void MainWindow::onLessonLevelChanged(int index)
     }
 }
 
+void MainWindow::onCodeLanguageChanged(int index)
+{
+    if (!typingTest || index < 0) return;
+    
+    typingTest->setCodeLanguage(codeLanguageCombo->currentData().toInt());
+    
+    // Update display if not currently testing
+    if (!inputField->isEnabled()) {
+        updateTextDisplay();
+    }
+}
+
+void MainWindow::onKeyboardLayoutChanged(int index)
+{
+    if (!typingTest || index < 0) return;
+    
+    const KeyboardLayout::Layout layout = static_cast<KeyboardLayout::Layout>(keyboardLayoutCombo->currentData().toInt());
+    typingTest->setKeyboardLayout(layout);
+    lessonManager->setKeyboardLayout(layout);
+    
+    // Update display if not currently testing
+    if (!inputField->isEnabled()) {
+        updateTextDisplay();
+    }
+}
+
+void MainWindow::onReturnPressed()
+{
+    if (!typingTest || typingTest->getTestMode() != TypingTest::CODE_TEST || !inputField->isEnabled()) return;
+    
+    // Enter types the line break; as in an editor, the next line's indentation comes with it
+    const QString sampleText = typingTest->getSampleText();
+    const int position = typingTest->getInputOffset() + inputField->text().length();
+    QString typed = "\n";
+    if (position < sampleText.length() && sampleText[position] == QLatin1Char('\n')) {
+        for (int i = position + 1; i < sampleText.length() && sampleText[i] == QLatin1Char(' '); ++i) {
+            typed += QLatin1Char(' ');
+        }
+    }
+    inputField->end(false);
+    inputField->insert(typed);
+}
+
 void MainWindow::onSoundToggled(bool enabled)
 {
     if (soundManager) {
@@ -609,10 +892,35 @@ void MainWindow::onThemeChanged(int index)
 {
     if (!themeManager) return;
     
+    const QString themeFile = themeCombo->itemData(index, THEME_FILE_ROLE).toString();
+    if (!themeFile.isEmpty()) {
+        themeManager->applyThemeFile(themeFile);
+        return;
+    }
+    
     ThemeManager::ThemeType theme = static_cast<ThemeManager::ThemeType>(themeCombo->currentData().toInt());
     themeManager->applyTheme(theme);
 }
 
+void MainWindow::refreshThemeFiles()
+{
+    if (!themeManager) return;
+    
+    // Rebuild the theme file entries after the built-in themes without re-applying anything
+    QSignalBlocker blocker(themeCombo);
+    while (themeCombo->count() > BUILT_IN_THEME_COUNT) {
+        themeCombo->removeItem(themeCombo->count() - 1);
+    }
+    
+    for (const QString &id : themeManager->getThemeFiles()) {
+        themeCombo->addItem(themeManager->getThemeFileName(id), static_cast<int>(ThemeManager::CUSTOM_THEME));
+        themeCombo->setItemData(themeCombo->count() - 1, id, THEME_FILE_ROLE);
+        if (id == themeManager->getCurrentThemeFile()) {
+            themeCombo->setCurrentIndex(themeCombo->count() - 1);
+        }
+    }
+}
+
 void MainWindow::onFontFamilyChanged(const QString &family)
 {
     if (!themeManager) return;
@@ -715,7 +1023,60 @@ void MainWindow::showUserStats()
     msgBox.setWindowTitle("User Statistics");
     msgBox.setText(statsText);
     msgBox.setStandardButtons(QMessageBox::Ok);
+    
+    // Results recorded with their passage can be typed again, between tests
+    const QList<TestResult> lastTests = statsManager->getTestHistory(currentUser, 1);
+    QPushButton *retakeButton = nullptr;
+    if (!inputField->isEnabled() && !lastTests.isEmpty() && lastTests.first().passageSeed != 0
+        && !lastTests.first().passageRequest.isEmpty()) {
+        retakeButton = msgBox.addButton("Retake Last Test", QMessageBox::ActionRole);
+    }
     msgBox.exec();
+    
+    if (retakeButton && msgBox.clickedButton() == retakeButton) {
+        retakeTest(lastTests.first());
+    }
+}
+
+void MainWindow::retakeTest(const TestResult &result)
+{
+    const PassageRequest request = PassageRequest::fromString(result.passageRequest);
+    TypingTest::TestMode mode = TypingTest::STANDARD_TEST;
+    if (request.lessonMode) {
+        mode = TypingTest::LESSON_MODE;
+    } else if (request.code) {
+        mode = TypingTest::CODE_TEST;
+    } else if (request.generated) {
+        mode = TypingTest::GENERATED_TEST;
+    }
+    
+    const int modeIndex = modeCombo->findData(static_cast<int>(mode));
+    const int languageIndex = codeLanguageCombo->findData(request.language);
+    if (modeIndex < 0 || (request.code && languageIndex < 0)) {
+        QMessageBox::information(this, "Retake Test", "The text this test was typed on is not installed.");
+        return;
+    }
+    
+    // Each control's handler hands its setting to the test, then the seed regenerates the passage
+    keyboardLayoutCombo->setCurrentIndex(keyboardLayoutCombo->findData(static_cast<int>(request.keyboardLayout)));
+    modeCombo->setCurrentIndex(modeIndex);
+    if (request.lessonMode) {
+        lessonTypeCombo->setCurrentIndex(lessonTypeCombo->findData(static_cast<int>(request.lessonType)));
+        lessonLevelCombo->setCurrentIndex(lessonLevelCombo->findData(request.lessonLevel));
+    } else if (request.scoreStep >= 0) {
+        const float score = static_cast<float>(request.scoreStep) / PassageRequest::SCORE_STEPS;
+        difficultyCombo->setCurrentIndex(CUSTOM_DIFFICULTY_INDEX);
+        onDifficultyAdapted(score);
+        typingTest->setDifficultyScore(score);
+    } else {
+        difficultyCombo->setCurrentIndex(request.difficulty);
+    }
+    if (request.code) {
+        codeLanguageCombo->setCurrentIndex(languageIndex);
+    }
+    
+    typingTest->setPassageSeed(result.passageSeed);
+    resetTest();
 }
 
 void MainWindow::resizeEvent(QResizeEvent *event)
@@ -36,6 +36,7 @@
 #include "../managers/thememanager.h"
 
 class TypingTest;
+class PassageView;
 
 class MainWindow : public QMainWindow
 {
@@ -44,18 +45,29 @@ class MainWindow : public QMainWindow
 public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    
+    // Makes the session's passages reproducible (--seed)
+    void setSessionSeed(quint64 seed);
 
 private slots:
     void startTest();
     void resetTest();
+    void loadText();
     void updateStats();
     void updateTextDisplay();
+    void playKeystrokeFeedback(const QString &inputText);
+    void commitTypedText();
     void onDifficultyChanged(int index);
+    void onDifficultyScoreChanged(int value);
+    void onDifficultyAdapted(float score);
     void onUserChanged(int index);
     void onDurationChanged(int index);
     void onModeChanged(int index);
     void onLessonTypeChanged(int index);
     void onLessonLevelChanged(int index);
+    void onCodeLanguageChanged(int index);
+    void onKeyboardLayoutChanged(int index);
+    void onReturnPressed();
     void onSoundToggled(bool enabled);
     void onKeystrokeSoundToggled(bool enabled);
     void onVolumeChanged(int value);
@@ -66,10 +78,24 @@ private slots:
     void onLargeTextToggled(bool enabled);
     void showUserStats();
     void applyCurrentTheme();
+    void refreshThemeFiles();
+    void onDatabaseReady(bool success);
+    void onAudioReady(bool available);
 
 private:
+    static const int BUILT_IN_THEME_COUNT = 3;          // Light, Dark, High Contrast
+    static const int THEME_FILE_ROLE = Qt::UserRole + 1; // Theme file id on theme file entries
+    
+    static const int CUSTOM_DIFFICULTY_INDEX = 3;   // Difficulty entries after Easy, Medium, Hard
+    static const int ADAPTIVE_DIFFICULTY_INDEX = 4;
+    
+    static const int STARTUP_PHASES = 3; // First paint, database, audio device
+    
     void setupUI();
+    void finishStartupPhase();
+    void retakeTest(const TestResult &result); // Restores the result's settings and regenerates its passage
     void resizeEvent(QResizeEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
     
     QWidget *centralWidget;
     QVBoxLayout *mainLayout;
@@ -79,20 +105,26 @@ private:
     QHBoxLayout *userLayout;
     
     QLabel *titleLabel;
-    QLabel *sampleTextLabel;
+    PassageView *passageView;
     QLineEdit *inputField;
     QPushButton *startButton;
     QPushButton *resetButton;
+    QPushButton *loadTextButton; // Types a text file as the passage
     QComboBox *difficultyCombo;
     QLabel *difficultyLabel;
+    QSlider *difficultySlider; // Score in percent, for Custom and Adaptive
     QComboBox *durationCombo;
     QLabel *durationLabel;
+    QComboBox *keyboardLayoutCombo;
+    QLabel *keyboardLayoutLabel;
     QComboBox *modeCombo;
     QLabel *modeLabel;
     QComboBox *lessonTypeCombo;
     QLabel *lessonTypeLabel;
     QComboBox *lessonLevelCombo;
     QLabel *lessonLevelLabel;
+    QComboBox *codeLanguageCombo;
+    QLabel *codeLanguageLabel;
     
     QCheckBox *soundEnabledCheckBox;
     QCheckBox *keystrokeSoundCheckBox;
@@ -115,6 +147,7 @@ private:
     QLabel *wpmLabel;
     QLabel *accuracyLabel;
     QLabel *timeLabel;
+    QLabel *speedLabel; // Raw, last five seconds, burst and consistency
     QProgressBar *progressBar;
     
     TypingTest *typingTest;
@@ -123,6 +156,13 @@ private:
     SoundManager *soundManager;
     ThemeManager *themeManager;
     QString currentUser;
+    int lastInputLength;
+    
+    // Startup bookkeeping
+    qint64 databaseStartNs;
+    qint64 audioStartNs;
+    int pendingStartupPhases;
+    bool firstPaintDone;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
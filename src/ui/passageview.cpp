@@ -0,0 +1,327 @@
+/**
+ * Typing Speed Test - Passage View Implementation
+ *
+ * Virtualized, colorized display of the passage being typed. The text is
+ * split into paragraph-sized chunks once; only chunks on screen are laid
+ * out (each with its own cached QTextLayout) and colored, so opening and
+ * typing a book-length passage costs the same per keystroke as a sentence.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include "passageview.h"
+#include <QPainter>
+#include <QResizeEvent>
+#include <QScrollBar>
+#include <algorithm>
+
+PassageView::PassageView(QWidget *parent)
+    : QAbstractScrollArea(parent)
+    , input(nullptr)
+    , layouts(LAYOUT_CACHE_SIZE)
+    , layoutWidth(0)
+    , topChunk(0)
+    , topLine(0)
+    , settingScrollBar(false)
+{
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    viewport()->setBackgroundRole(QPalette::Base);
+    viewport()->setAutoFillBackground(true);
+    chunkStarts.append(0);
+}
+
+void PassageView::setPassage(const QString &text)
+{
+    // An unchanged passage is still the same shared string; any edit to it has detached
+    if (message.isEmpty() && text.isSharedWith(passage.getText())) {
+        return;
+    }
+
+    passage.setText(text);
+    message.clear();
+    input = nullptr;
+    splitChunks();
+    invalidateLayouts();
+    scrollTo(0, 0);
+    viewport()->update();
+}
+
+void PassageView::setInput(const CorrectnessMap &correctness)
+{
+    input = &correctness;
+    ensureCaretVisible();
+    viewport()->update();
+}
+
+void PassageView::setFormats(const TextFormatTablePtr &table)
+{
+    if (table == formats) {
+        return;
+    }
+
+    // Only a new font moves line breaks; color changes reuse the cached layouts
+    const bool fontChanged = !formats || !table || formats->getFont() != table->getFont();
+    formats = table;
+    if (fontChanged) {
+        invalidateLayouts();
+        topLine = 0;
+        ensureCaretVisible();
+    }
+    viewport()->update();
+}
+
+void PassageView::setMessage(const QString &text)
+{
+    message = text;
+    passage.clear();
+    input = nullptr;
+    splitChunks();
+    invalidateLayouts();
+    scrollTo(0, 0);
+    viewport()->update();
+}
+
+void PassageView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(viewport());
+    const QRect content = viewport()->rect().adjusted(MARGIN, MARGIN, -MARGIN, -MARGIN);
+
+    if (chunkCount() == 0) {
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(content, Qt::TextWordWrap, message);
+        return;
+    }
+
+    // Lines of the top chunk above topLine fall outside the clip and are skipped by draw()
+    const QRectF clip(0, MARGIN, viewport()->width(), viewport()->height() - MARGIN);
+    painter.setClipRect(clip);
+    qreal y = MARGIN;
+    for (int chunk = topChunk; chunk < chunkCount() && y < clip.bottom(); ++chunk) {
+        QTextLayout *layout = chunkLayout(chunk);
+        const int firstLine = chunk == topChunk ? qMin(topLine, layout->lineCount() - 1) : 0;
+        const qreal offset = layout->lineAt(firstLine).y();
+        layout->draw(&painter, QPointF(MARGIN, y - offset), chunkFormats(chunk), clip);
+        y += layout->boundingRect().height() - offset;
+    }
+}
+
+void PassageView::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    if (viewport()->width() != layoutWidth) {
+        invalidateLayouts();
+        topLine = 0;
+        ensureCaretVisible();
+    }
+}
+
+void PassageView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+    if (settingScrollBar) {
+        return;
+    }
+
+    // The scroll bar steps through chunks; the next keystroke scrolls back to the caret
+    topChunk = verticalScrollBar()->value();
+    topLine = 0;
+    viewport()->update();
+}
+
+void PassageView::splitChunks()
+{
+    chunkStarts.clear();
+    chunkStarts.append(0);
+
+    const QChar *text = passage.getText().constData();
+    const int length = passage.getText().length();
+    for (int start = 0; start < length; ) {
+        int end = qMin(length, start + MAX_CHUNK_CHARS);
+        int firstSpace = -1;
+        bool found = false;
+        for (int i = start; i < end && !found; ++i) {
+            if (text[i] == QLatin1Char('\n')) {
+                end = i + 1;
+                found = true;
+            } else if (i - start >= CHUNK_CHARS && text[i] == QLatin1Char(' ')) {
+                const QChar previous = text[i - 1];
+                if (previous == QLatin1Char('.') || previous == QLatin1Char('!') || previous == QLatin1Char('?')) {
+                    end = i + 1;
+                    found = true;
+                } else if (firstSpace < 0) {
+                    firstSpace = i + 1;
+                }
+            }
+        }
+        if (!found && end < length && firstSpace > 0) {
+            end = firstSpace;
+        }
+        end = passage.getClusterEnd(passage.clusterAt(end - 1)); // A hard cut may land inside a cluster
+        chunkStarts.append(end);
+        start = end;
+    }
+}
+
+int PassageView::chunkCount() const
+{
+    return chunkStarts.size() - 1;
+}
+
+int PassageView::chunkOf(int position) const
+{
+    const int chunk = static_cast<int>(std::upper_bound(chunkStarts.constBegin(), chunkStarts.constEnd(), position)
+                                       - chunkStarts.constBegin()) - 1;
+    return qBound(0, chunk, chunkCount() - 1);
+}
+
+int PassageView::chunkLength(int chunk) const
+{
+    return chunkStarts[chunk + 1] - chunkStarts[chunk];
+}
+
+QTextLayout *PassageView::chunkLayout(int chunk)
+{
+    if (QTextLayout *cached = layouts.object(chunk)) {
+        return cached;
+    }
+
+    // A chunk ends at most one newline, which the layout needs as a line separator
+    QString text = passage.getText().mid(chunkStarts[chunk], chunkLength(chunk));
+    text.replace(QLatin1Char('\n'), QChar(QChar::LineSeparator));
+
+    QTextLayout *layout = new QTextLayout(text, passageFont());
+    QTextOption option;
+    option.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+    layout->setTextOption(option);
+    layout->setCacheEnabled(true);
+
+    const qreal width = qMax(1, layoutWidth - 2 * MARGIN);
+    qreal height = 0;
+    layout->beginLayout();
+    for (QTextLine line = layout->createLine(); line.isValid(); line = layout->createLine()) {
+        line.setLineWidth(width);
+        line.setPosition(QPointF(0, height));
+        height += line.height();
+    }
+    layout->endLayout();
+
+    layouts.insert(chunk, layout);
+    return layout;
+}
+
+QVector<QTextLayout::FormatRange> PassageView::chunkFormats(int chunk) const
+{
+    QVector<QTextLayout::FormatRange> ranges;
+    if (!formats) {
+        return ranges;
+    }
+
+    // Runs of clusters; chunks start and end on cluster boundaries
+    const int start = chunkStarts[chunk];
+    const int first = passage.clusterAt(start);
+    const int end = passage.clusterAt(chunkStarts[chunk + 1] - 1) + 1;
+    const int typed = input ? input->getTypedCount() : 0;
+
+    for (int runStart = first; runStart < end; ) {
+        TextFormatTable::CharState state;
+        int runEnd;
+        if (runStart < typed) {
+            // Runs of equal correctness come from bit scans, 64 clusters per step
+            state = input->isCorrect(runStart) ? TextFormatTable::CORRECT_CHAR : TextFormatTable::INCORRECT_CHAR;
+            runEnd = input->runEnd(runStart, end);
+        } else if (runStart == typed) {
+            state = TextFormatTable::CURRENT_CHAR;
+            runEnd = runStart + 1;
+        } else {
+            state = TextFormatTable::REMAINING_CHAR;
+            runEnd = end; // Nothing past the caret has been typed
+        }
+
+        QTextLayout::FormatRange range;
+        range.start = passage.getClusterStart(runStart) - start;
+        range.length = passage.getClusterStart(runEnd) - passage.getClusterStart(runStart);
+        range.format = formats->getFormat(state);
+        ranges.append(range);
+        runStart = runEnd;
+    }
+    return ranges;
+}
+
+void PassageView::ensureCaretVisible()
+{
+    if (chunkCount() == 0) {
+        return;
+    }
+
+    const int typed = input ? input->getTypedCount() : 0;
+    const int caret = passage.getClusterStart(qMin(typed, passage.getClusterCount() - 1));
+    const int caretChunk = chunkOf(caret);
+    const QTextLine caretTextLine = chunkLayout(caretChunk)->lineForTextPosition(caret - chunkStarts[caretChunk]);
+    const int caretLine = caretTextLine.isValid() ? caretTextLine.lineNumber() : 0;
+
+    if (caretChunk < topChunk || (caretChunk == topChunk && caretLine < topLine)) {
+        scrollTo(caretChunk, caretLine);
+        return;
+    }
+
+    // Height from the top of the view down to the caret line, walking at most one screen
+    const qreal visible = viewport()->height() - 2 * MARGIN;
+    qreal y = 0;
+    for (int chunk = topChunk; chunk <= caretChunk && y <= visible; ++chunk) {
+        QTextLayout *layout = chunkLayout(chunk);
+        const int first = chunk == topChunk ? qMin(topLine, layout->lineCount() - 1) : 0;
+        const int last = chunk == caretChunk ? caretLine : layout->lineCount() - 1;
+        for (int line = first; line <= last; ++line) {
+            y += layout->lineAt(line).height();
+        }
+    }
+    if (y <= visible) {
+        return;
+    }
+
+    // Past the bottom: the caret line moves a third of the way down the view
+    int chunk = caretChunk;
+    int line = caretLine;
+    qreal above = chunkLayout(chunk)->lineAt(line).height();
+    while (above < visible / 3 && (line > 0 || chunk > 0)) {
+        if (line > 0) {
+            --line;
+        } else {
+            --chunk;
+            line = chunkLayout(chunk)->lineCount() - 1;
+        }
+        above += chunkLayout(chunk)->lineAt(line).height();
+    }
+    scrollTo(chunk, line);
+}
+
+void PassageView::scrollTo(int chunk, int line)
+{
+    topChunk = chunk;
+    topLine = line;
+    updateScrollBar();
+}
+
+void PassageView::updateScrollBar()
+{
+    settingScrollBar = true;
+    verticalScrollBar()->setRange(0, qMax(0, chunkCount() - 1));
+    verticalScrollBar()->setPageStep(1);
+    verticalScrollBar()->setValue(topChunk);
+    settingScrollBar = false;
+}
+
+void PassageView::invalidateLayouts()
+{
+    layouts.clear();
+    layoutWidth = viewport()->width();
+}
+
+const QFont &PassageView::passageFont() const
+{
+    return formats ? formats->getFont() : font();
+}
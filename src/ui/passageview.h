@@ -0,0 +1,80 @@
+/**
+ * Typing Speed Test - Passage View
+ *
+ * Virtualized, colorized display of the passage being typed. The text is
+ * split into paragraph-sized chunks once; only chunks on screen are laid
+ * out (each with its own cached QTextLayout) and colored, so opening and
+ * typing a book-length passage costs the same per keystroke as a sentence.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#ifndef PASSAGEVIEW_H
+#define PASSAGEVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QCache>
+#include <QString>
+#include <QTextLayout>
+#include <QVector>
+#include "../core/correctnessmap.h"
+#include "../core/passagemodel.h"
+#include "../managers/textformattable.h"
+
+class PassageView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit PassageView(QWidget *parent = nullptr);
+
+    // Cheap to call on every keystroke: unchanged passages and tables are detected without a scan
+    void setPassage(const QString &text);
+    // Colors the passage from the test's correctness bits and keeps the caret on screen. The bits are
+    // read in place at paint time, so whenever they change against the passage (an endless test
+    // dropping its front), setPassage() and setInput() must be called again before the next paint
+    void setInput(const CorrectnessMap &correctness);
+    void setFormats(const TextFormatTablePtr &table);
+
+    // Plain wrapped text in place of the passage, e.g. between tests
+    void setMessage(const QString &text);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private:
+    static const int CHUNK_CHARS = 600;        // Chunks end at the first sentence end past this
+    static const int MAX_CHUNK_CHARS = 2000;   // ... or at a space, for text without sentence ends
+    static const int LAYOUT_CACHE_SIZE = 64;   // Laid out chunks kept; far more than fit on screen
+    static const int MARGIN = 12;
+
+    void splitChunks();
+    int chunkCount() const;
+    int chunkOf(int position) const;
+    int chunkLength(int chunk) const;
+    QTextLayout *chunkLayout(int chunk);
+    QVector<QTextLayout::FormatRange> chunkFormats(int chunk) const;
+    void ensureCaretVisible();
+    void scrollTo(int chunk, int line);
+    void updateScrollBar();
+    void invalidateLayouts();
+    const QFont &passageFont() const;
+
+    PassageModel passage; // Colored and scrolled by grapheme cluster, never splitting one
+    const CorrectnessMap *input; // The test's own bits; copying them would cost a detach per keystroke
+    QString message;
+    TextFormatTablePtr formats;
+    QVector<int> chunkStarts; // Start of each chunk, plus the passage length
+    QCache<int, QTextLayout> layouts;
+    int layoutWidth;
+
+    // First line on screen: a line within a chunk
+    int topChunk;
+    int topLine;
+    bool settingScrollBar;
+};
+
+#endif // PASSAGEVIEW_H
@@ -0,0 +1,242 @@
+/**
+ * Typing Speed Test - Offline Audio Render Harness
+ *
+ * Drives SoundManager in offline mode with a recorded (or synthesized)
+ * keystroke stream and reports mixer CPU cost per second of audio and
+ * trigger-to-sample latency. Needs no audio device, so it runs in CI.
+ *
+ * Latency is timed from a keystroke to the first rendered frame that is
+ * audible, for keystrokes posted while nothing else is sounding; a trigger
+ * that never produces sound (dropped by the queue, or silent) is counted
+ * separately. Sound packs are loaded before rendering starts.
+ *
+ * Keystroke stream format, one event per line ('#' starts a comment):
+ *   <milliseconds> <sound>
+ * where <sound> is correct, incorrect, start, complete, levelup,
+ * achievement, tick or warning.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QTextStream>
+#include <QRandomGenerator>
+#include <QVector>
+#include <QMap>
+#include <algorithm>
+#include <cmath>
+#include "../src/managers/soundmanager.h"
+#include "../src/audio/soundbank.h"
+
+static const float AUDIBLE_LEVEL = 0.001f; // -60 dBFS
+static const int ONSET_TIMEOUT_MS = 1000;  // Backstop for voices that stay below the audible level
+
+struct KeystrokeEvent {
+    qint64 timeMs;
+    SoundManager::SoundType sound;
+};
+
+static bool loadKeystrokes(const QString &path, QVector<KeystrokeEvent> &events)
+{
+    const QMap<QString, SoundManager::SoundType> names = {
+        {"correct", SoundManager::KEYSTROKE_CORRECT},
+        {"incorrect", SoundManager::KEYSTROKE_INCORRECT},
+        {"start", SoundManager::TEST_START},
+        {"complete", SoundManager::TEST_COMPLETE},
+        {"levelup", SoundManager::LEVEL_UP},
+        {"achievement", SoundManager::ACHIEVEMENT},
+        {"tick", SoundManager::TICK},
+        {"warning", SoundManager::WARNING}
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream(stderr) << "Cannot open keystroke stream: " << path << "\n";
+        return false;
+    }
+
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().section('#', 0, 0).simplified();
+        ++lineNumber;
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        const QStringList fields = line.split(' ');
+        bool ok = false;
+        const qint64 timeMs = fields.value(0).toLongLong(&ok);
+        if (!ok || fields.size() != 2 || !names.contains(fields[1])) {
+            QTextStream(stderr) << path << ":" << lineNumber << ": invalid event '" << line << "'\n";
+            return false;
+        }
+        events.append({timeMs, names.value(fields[1])});
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const KeystrokeEvent &a, const KeystrokeEvent &b) {
+        return a.timeMs < b.timeMs;
+    });
+    return true;
+}
+
+static QVector<KeystrokeEvent> synthesizeKeystrokes(int wpm, int seconds, double errorRate)
+{
+    // 5 characters per word, with +/-40% jitter between keys
+    QVector<KeystrokeEvent> events;
+    QRandomGenerator random(1234);
+    const double meanIntervalMs = 60000.0 / (wpm * 5.0);
+    double timeMs = 0.0;
+
+    while (timeMs < seconds * 1000.0) {
+        const bool correct = random.generateDouble() >= errorRate;
+        events.append({static_cast<qint64>(timeMs),
+                       correct ? SoundManager::KEYSTROKE_CORRECT : SoundManager::KEYSTROKE_INCORRECT});
+        timeMs += meanIntervalMs * (0.6 + 0.8 * random.generateDouble());
+    }
+    return events;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("AudioRenderHarness");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders SoundManager output offline and reports mixer cost and latency.");
+    parser.addHelpOption();
+    QCommandLineOption keystrokesOption("keystrokes", "Recorded keystroke stream to replay.", "file");
+    QCommandLineOption wpmOption("wpm", "Synthesized stream speed when no file is given.", "wpm", "120");
+    QCommandLineOption durationOption("duration", "Synthesized stream length in seconds.", "seconds", "60");
+    QCommandLineOption errorOption("error-rate", "Synthesized fraction of incorrect keys.", "rate", "0.05");
+    QCommandLineOption blockOption("block", "Frames per render block.", "frames", "512");
+    QCommandLineOption wavOption("wav", "Write the rendered audio to a WAV file.", "file");
+    QCommandLineOption packOption("pack", "Sound pack to render (default: the default pack, if installed).", "name");
+    parser.addOptions({keystrokesOption, wpmOption, durationOption, errorOption, blockOption, wavOption, packOption});
+    parser.process(app);
+
+    QVector<KeystrokeEvent> events;
+    if (parser.isSet(keystrokesOption)) {
+        if (!loadKeystrokes(parser.value(keystrokesOption), events)) {
+            return 1;
+        }
+    } else {
+        events = synthesizeKeystrokes(qMax(1, parser.value(wpmOption).toInt()),
+                                      qMax(1, parser.value(durationOption).toInt()),
+                                      parser.value(errorOption).toDouble());
+    }
+
+    SoundManager soundManager(nullptr, AudioEngine::OFFLINE_OUTPUT);
+    soundManager.setKeystrokeSoundsEnabled(true);
+
+    // Packs are decoded on a background thread and installed through the event loop
+    if (!soundManager.areSoundPacksLoaded()) {
+        QEventLoop loop;
+        QObject::connect(&soundManager, &SoundManager::soundPacksLoaded, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+    if (parser.isSet(packOption)) {
+        if (!soundManager.getAvailableSoundPacks().contains(parser.value(packOption))) {
+            QTextStream(stderr) << "Unknown sound pack: " << parser.value(packOption) << " (available: "
+                                << soundManager.getAvailableSoundPacks().join(", ") << ")\n";
+            return 1;
+        }
+        soundManager.setSoundPack(parser.value(packOption));
+    }
+
+    const int sampleRate = soundManager.getSampleRate();
+    const int blockFrames = qMax(16, parser.value(blockOption).toInt());
+    const qint64 lastEventMs = events.isEmpty() ? 0 : events.last().timeMs;
+    const qint64 totalFrames = (lastEventMs + 1000) * sampleRate / 1000; // One second tail
+
+    const bool keepAudio = parser.isSet(wavOption);
+    QVector<float> audio(keepAudio ? static_cast<int>(totalFrames) : 0);
+    QVector<float> block(blockFrames);
+
+    // Only a keystroke posted into silence can be timed: its onset is the first audible frame after it
+    const qint64 onsetTimeoutFrames = static_cast<qint64>(sampleRate) * ONSET_TIMEOUT_MS / 1000;
+    qint64 timedPostFrame = -1;
+    QVector<qint64> latencies;
+    latencies.reserve(events.size());
+    int silentTriggers = 0;
+    int nextEvent = 0;
+    qint64 renderNs = 0;
+    QElapsedTimer timer;
+
+    for (qint64 frame = 0; frame < totalFrames; frame += blockFrames) {
+        const int frames = static_cast<int>(qMin<qint64>(blockFrames, totalFrames - frame));
+
+        timer.start();
+        soundManager.renderOffline(block.data(), frames);
+        renderNs += timer.nsecsElapsed();
+
+        if (keepAudio) {
+            std::copy(block.constBegin(), block.constBegin() + frames, audio.begin() + frame);
+        }
+
+        if (timedPostFrame >= 0) {
+            int onset = 0;
+            while (onset < frames && std::fabs(block[onset]) < AUDIBLE_LEVEL) {
+                ++onset;
+            }
+            if (onset < frames) {
+                latencies.append(frame + onset - timedPostFrame);
+                timedPostFrame = -1;
+            } else if (soundManager.isOfflineIdle() || frame + frames - timedPostFrame >= onsetTimeoutFrames) {
+                // Nothing left playing that could still become audible
+                ++silentTriggers;
+                timedPostFrame = -1;
+            }
+        }
+
+        // Post the keystrokes that happen while this block is "playing", as the UI thread would
+        const qint64 blockEnd = frame + frames;
+        while (nextEvent < events.size() && events[nextEvent].timeMs * sampleRate / 1000 < blockEnd) {
+            const bool idle = timedPostFrame < 0 && soundManager.isOfflineIdle();
+            soundManager.playSound(events[nextEvent].sound);
+            if (idle) {
+                timedPostFrame = events[nextEvent].timeMs * sampleRate / 1000;
+            }
+            ++nextEvent;
+        }
+    }
+
+    const double audioSeconds = static_cast<double>(totalFrames) / sampleRate;
+    const double cpuMsPerSecond = renderNs / 1e6 / audioSeconds;
+    QTextStream out(stdout);
+    out << "Events:                " << events.size() << "\n";
+    out << "Sound pack:            " << (soundManager.getAvailableSoundPacks().contains(soundManager.getSoundPack())
+                                         ? soundManager.getSoundPack() : QString("none (built-in tones)")) << "\n";
+    out << "Audio rendered:        " << QString::number(audioSeconds, 'f', 2) << " s\n";
+    out << "Mixer CPU:             " << QString::number(cpuMsPerSecond, 'f', 3) << " ms per second of audio\n";
+    out << "Real-time factor:      " << QString::number(cpuMsPerSecond > 0 ? 1000.0 / cpuMsPerSecond : 0.0, 'f', 0) << "x\n";
+
+    if (!latencies.isEmpty()) {
+        std::sort(latencies.begin(), latencies.end());
+        double sum = 0.0;
+        for (qint64 latency : latencies) {
+            sum += latency;
+        }
+        const double toMs = 1000.0 / sampleRate;
+        out << "Trigger-to-sample:     min " << QString::number(latencies.first() * toMs, 'f', 2)
+            << " ms, mean " << QString::number(sum / latencies.size() * toMs, 'f', 2)
+            << " ms, p99 " << QString::number(latencies[(latencies.size() - 1) * 99 / 100] * toMs, 'f', 2)
+            << " ms, max " << QString::number(latencies.last() * toMs, 'f', 2) << " ms\n";
+        out << "                       (" << latencies.size() << " keystrokes posted into silence; excludes device buffering, "
+            << QString::number(blockFrames * toMs, 'f', 2) << " ms blocks)\n";
+    }
+    if (silentTriggers > 0) {
+        out << "Never audible:         " << silentTriggers << " of the timed keystrokes\n";
+    }
+
+    if (keepAudio && !SoundBank::writeWav(parser.value(wavOption), audio.constData(), audio.size(), sampleRate)) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,538 @@
+/**
+ * Typing Speed Test - Corpus Builder
+ *
+ * Builds the binary sentence corpus the application memory-maps at startup
+ * (see src/core/corpus.h).
+ *
+ * Raw text dumps given as arguments are streamed in large blocks, split into
+ * sentences on all cores, deduplicated, scored with SentenceScorer and
+ * bucketed into EASY/MEDIUM/HARD. Sentences are kept only if the keyboard
+ * layouts of the corpus's language (--language) can type them. Files given with --easy/--medium/--hard
+ * hold one already-bucketed sentence per line instead ('#' lines skipped).
+ * With --model, the kept sentences also train the Markov passage model
+ * (see src/core/markovmodel.h), whose sampling speed is reported after.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QQueue>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <climits>
+#include <vector>
+#include "../src/core/corpus.h"
+#include "../src/core/corpuswriter.h"
+#include "../src/core/keyboardlayout.h"
+#include "../src/core/markovmodel.h"
+#include "../src/core/markovmodelwriter.h"
+#include "../src/core/sentencescorer.h"
+
+static const int BLOCK_SIZE = 8 << 20;       // Bytes per block handed to a worker
+static const int MIN_SENTENCE_BYTES = 20;
+static const int MAX_SENTENCE_BYTES = 200;
+static const int PROGRESS_INTERVAL_MS = 1000;
+static const int MODEL_SAMPLE_WORDS = 2000000; // Words drawn to measure model sampling speed
+
+struct ScoredSentence {
+    quint64 hash;
+    float score;
+    int difficulty;
+    QByteArray text;
+};
+
+typedef QVector<ScoredSentence> SentenceBatch;
+
+// Blocking producer/consumer queue with back-pressure
+template<typename T>
+class BoundedQueue
+{
+public:
+    enum PopResult { POPPED, TIMED_OUT, CLOSED };
+
+    explicit BoundedQueue(int queueCapacity) : capacity(queueCapacity), closed(false) {}
+
+    void push(T item)
+    {
+        QMutexLocker locker(&mutex);
+        while (items.size() >= capacity) {
+            notFull.wait(&mutex);
+        }
+        items.enqueue(std::move(item));
+        notEmpty.wakeOne();
+    }
+
+    PopResult pop(T &item, unsigned long timeoutMs = ULONG_MAX)
+    {
+        QMutexLocker locker(&mutex);
+        while (items.isEmpty()) {
+            if (closed) {
+                return CLOSED;
+            }
+            if (!notEmpty.wait(&mutex, timeoutMs)) {
+                return TIMED_OUT;
+            }
+        }
+        item = items.dequeue();
+        notFull.wakeOne();
+        return POPPED;
+    }
+
+    void close()
+    {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        notEmpty.wakeAll();
+    }
+
+private:
+    QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+    QQueue<T> items;
+    int capacity;
+    bool closed;
+};
+
+// Open-addressing set of 64-bit hashes, 8 bytes per slot; far leaner than QSet for 100M+ entries.
+// Slots live in a std::vector with size_t indices, since QVector caps out below 2^28 slots on Qt5
+class HashSet64
+{
+public:
+    HashSet64() : slots(size_t(1) << 20, 0), used(0) {}
+
+    bool insert(quint64 hash)
+    {
+        if (hash == 0) {
+            hash = 1; // 0 marks an empty slot
+        }
+        if ((used + 1) * 2 > slots.size()) {
+            grow();
+        }
+        if (!place(hash)) {
+            return false;
+        }
+        ++used;
+        return true;
+    }
+
+private:
+    // Linear probing; false if the hash is already present
+    bool place(quint64 hash)
+    {
+        const size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+            if (slots[slot] == hash) {
+                return false;
+            }
+            if (slots[slot] == 0) {
+                slots[slot] = hash;
+                return true;
+            }
+        }
+    }
+
+    // Doubles the table and rehashes it in place. Hashes are taken out and placed again in slot
+    // order, so a probe only ever crosses slots that are already rehashed: the run wrapping
+    // around the old end is set aside first, and the rest of the old half follows from the
+    // first empty slot up. Probes into the new upper half meet nothing but rehashed entries.
+    void grow()
+    {
+        const size_t oldSize = slots.size();
+        slots.resize(oldSize * 2, 0);
+
+        std::vector<quint64> wrapped;
+        size_t slot = 0;
+        for (; slots[slot] != 0; ++slot) {
+            wrapped.push_back(slots[slot]);
+            slots[slot] = 0;
+        }
+        for (; slot < oldSize; ++slot) {
+            const quint64 hash = slots[slot];
+            if (hash != 0) {
+                slots[slot] = 0;
+                place(hash);
+            }
+        }
+        for (quint64 hash : wrapped) {
+            place(hash);
+        }
+    }
+
+    std::vector<quint64> slots;
+    size_t used;
+};
+
+static quint64 fnv1a(const QByteArray &data)
+{
+    quint64 hash = 14695981039346656037ULL;
+    for (char byte : data) {
+        hash ^= static_cast<uchar>(byte);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool isTerminator(char c)
+{
+    return c == '.' || c == '!' || c == '?';
+}
+
+static bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// On a key of one of the language's layouts, or an accented letter typed on its base letter's key
+// with a dead key or Caps Lock, as "ê" and "É" are on AZERTY
+static bool isTypeableCharacter(QChar character, KeyboardLayout::Language language)
+{
+    const QChar base = character.decompositionTag() == QChar::Canonical ? character.decomposition().at(0) : character;
+    for (int index = 0; index < KeyboardLayout::LAYOUT_COUNT; ++index) {
+        const KeyboardLayout::Layout layout = static_cast<KeyboardLayout::Layout>(index);
+        if (KeyboardLayout::getLanguage(layout) == language
+            && (KeyboardLayout::keyFor(layout, character).isValid() || KeyboardLayout::keyFor(layout, base).isValid())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Rejects headings, markup, tables, fragments that are unpleasant to type and anything the
+// language's keyboards cannot type
+static bool isTypeable(const QByteArray &sentence, KeyboardLayout::Language language)
+{
+    if (sentence.size() < MIN_SENTENCE_BYTES || sentence.size() > MAX_SENTENCE_BYTES) {
+        return false;
+    }
+    const QString text = QString::fromUtf8(sentence).normalized(QString::NormalizationForm_C);
+    const QChar first = text[0];
+    if (!first.isUpper() && first != QLatin1Char('"') && first != QLatin1Char('\'')) {
+        return false;
+    }
+
+    int letters = 0;
+    int spaces = 0;
+    for (QChar c : text) {
+        if (c == QLatin1Char(' ')) {
+            ++spaces;
+            continue;
+        }
+        if (c == QLatin1Char('|') || c == QLatin1Char('{') || c == QLatin1Char('}') || c == QLatin1Char('<')
+            || c == QLatin1Char('>') || c == QLatin1Char('=') || !isTypeableCharacter(c, language)) {
+            return false;
+        }
+        if (c.isLetter()) {
+            ++letters;
+        }
+    }
+    return spaces >= 3 && letters * 10 >= (text.size() - spaces) * 8;
+}
+
+// Splits a block into whitespace-normalized sentences ending in . ! or ? (optionally quoted)
+static SentenceBatch splitAndScore(const QByteArray &block, KeyboardLayout::Language language,
+                                   std::atomic<qint64> &candidates)
+{
+    SentenceBatch batch;
+    qint64 found = 0;
+    QByteArray current;
+    bool pendingSpace = false;
+    int newlines = 0;
+
+    for (int i = 0; i < block.size(); ++i) {
+        const char c = block[i];
+        if (isSpace(c)) {
+            if (c == '\n' && ++newlines >= 2) {
+                current.clear(); // A paragraph break ends any unterminated fragment
+            }
+            pendingSpace = !current.isEmpty();
+            continue;
+        }
+        newlines = 0;
+
+        if (pendingSpace) {
+            current += ' ';
+            pendingSpace = false;
+        }
+        current += c;
+
+        const bool atEnd = (i + 1 == block.size()) || isSpace(block[i + 1]);
+        const bool terminated = isTerminator(c)
+            || ((c == '"' || c == '\'') && current.size() >= 2 && isTerminator(current[current.size() - 2]));
+        if (!terminated || !atEnd) {
+            continue;
+        }
+
+        ++found;
+        if (isTypeable(current, language)) {
+            const float score = SentenceScorer::score(current);
+            batch.append({fnv1a(current), score, SentenceScorer::difficultyFor(score), current});
+        }
+        current.clear();
+    }
+    candidates += found;
+    return batch;
+}
+
+// Where to cut a block so no sentence straddles two blocks
+static int lastSentenceBoundary(const QByteArray &data)
+{
+    for (int i = data.size() - 2; i >= 0; --i) {
+        if (isTerminator(data[i]) && isSpace(data[i + 1])) {
+            return i + 1;
+        }
+    }
+    const int newline = data.lastIndexOf('\n');
+    return newline >= 0 ? newline + 1 : data.size();
+}
+
+static bool addSentenceFile(CorpusWriter &writer, MarkovModelWriter *model, HashSet64 &seen, int difficulty,
+                            const QString &path, qint64 &duplicates)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        QTextStream(stderr) << "Cannot open " << path << "\n";
+        return false;
+    }
+
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        if (!seen.insert(fnv1a(line))) {
+            ++duplicates;
+            continue;
+        }
+        if (!writer.addSentence(difficulty, line)) {
+            return false;
+        }
+        if (model) {
+            model->addSentence(line);
+        }
+    }
+    return true;
+}
+
+// Reopens the written model the way the application does and times raw sampling
+static void reportModelSpeed(const QString &path, QTextStream &out)
+{
+    MarkovModel model;
+    if (!model.open(path)) {
+        return;
+    }
+
+    SessionRandom random(1);
+    QElapsedTimer sampleTimer;
+    sampleTimer.start();
+    qint64 words = 0;
+    qint64 bytes = 0;
+    while (words < MODEL_SAMPLE_WORDS) {
+        const QByteArray sentence = model.generateSentenceUtf8(random);
+        if (sentence.isEmpty()) {
+            break;
+        }
+        words += sentence.count(' ') + 1;
+        bytes += sentence.size();
+    }
+
+    const double seconds = qMax(1, sampleTimer.elapsed()) / 1000.0;
+    out << "  model:      " << model.getWordCount() << " words, " << model.getStateCount() << " states, "
+        << QString::number(words / seconds / 1e6, 'f', 2) << "M words/s ("
+        << QString::number(bytes / seconds / 1e6, 'f', 0) << " MB/s) sampled\n";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("CorpusBuilder");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Builds a memory-mappable sentence corpus from text dumps or sentence lists.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("dumps", "Raw text files to split, deduplicate and score.", "[dump...]");
+    QCommandLineOption easyOption("easy", "Easy sentences, one per line (repeatable).", "file");
+    QCommandLineOption mediumOption("medium", "Medium sentences, one per line (repeatable).", "file");
+    QCommandLineOption hardOption("hard", "Hard sentences, one per line (repeatable).", "file");
+    QCommandLineOption outputOption({"o", "output"}, "Corpus file to write.", "file", "passages.corpus");
+    QCommandLineOption modelOption("model", "Also train a Markov passage model on the kept sentences.", "file");
+    QCommandLineOption threadsOption("threads", "Splitting and scoring threads.", "count",
+                                     QString::number(qMax(1, QThread::idealThreadCount() - 1)));
+    QCommandLineOption languageOption("language", "Language of the dumps: en, fr or de. Sentences its keyboard "
+                                      "layouts cannot type are dropped.", "code", "en");
+    parser.addOptions({easyOption, mediumOption, hardOption, outputOption, modelOption, threadsOption,
+                       languageOption});
+    parser.process(app);
+
+    int languageIndex = 0;
+    while (languageIndex < KeyboardLayout::LANGUAGE_COUNT
+           && KeyboardLayout::getLanguageCode(static_cast<KeyboardLayout::Language>(languageIndex))
+               != parser.value(languageOption)) {
+        ++languageIndex;
+    }
+    if (languageIndex == KeyboardLayout::LANGUAGE_COUNT) {
+        QTextStream(stderr) << "Unknown language " << parser.value(languageOption) << "\n";
+        return 1;
+    }
+    const KeyboardLayout::Language language = static_cast<KeyboardLayout::Language>(languageIndex);
+
+    const QCommandLineOption *difficultyOptions[Corpus::DIFFICULTY_COUNT] = {
+        &easyOption, &mediumOption, &hardOption
+    };
+    const QStringList dumps = parser.positionalArguments();
+    const int threadCount = qMax(1, parser.value(threadsOption).toInt());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    CorpusWriter writer(parser.value(outputOption));
+    MarkovModelWriter modelWriter;
+    MarkovModelWriter *model = parser.isSet(modelOption) ? &modelWriter : nullptr;
+    HashSet64 seen;
+    qint64 duplicates = 0;
+
+    for (int difficulty = 0; difficulty < Corpus::DIFFICULTY_COUNT; ++difficulty) {
+        for (const QString &path : parser.values(*difficultyOptions[difficulty])) {
+            if (!addSentenceFile(writer, model, seen, difficulty, path, duplicates)) {
+                return 1;
+            }
+        }
+    }
+
+    // Pipeline: one reader thread -> blocks -> N split/score workers -> batches -> dedup and write here
+    qint64 totalBytes = 0;
+    for (const QString &path : dumps) {
+        totalBytes += QFileInfo(path).size();
+    }
+
+    BoundedQueue<QByteArray> blocks(threadCount * 2);
+    BoundedQueue<SentenceBatch> batches(threadCount * 2);
+    std::atomic<qint64> bytesRead(0);
+    std::atomic<qint64> candidates(0);
+    std::atomic<int> activeWorkers(threadCount);
+    std::atomic<bool> readFailed(false);
+
+    QThread *reader = QThread::create([&]() {
+        for (const QString &path : dumps) {
+            QFile file(path);
+            if (!file.open(QIODevice::ReadOnly)) {
+                QTextStream(stderr) << "Cannot open " << path << "\n";
+                readFailed = true;
+                break;
+            }
+
+            QByteArray carry;
+            while (!file.atEnd()) {
+                QByteArray block = carry + file.read(BLOCK_SIZE);
+                bytesRead += block.size() - carry.size();
+                const int cut = file.atEnd() ? block.size() : lastSentenceBoundary(block);
+                carry = block.mid(cut);
+                block.truncate(cut);
+                blocks.push(block);
+            }
+            if (!carry.isEmpty()) {
+                blocks.push(carry);
+            }
+        }
+        blocks.close();
+    });
+
+    QVector<QThread *> workers;
+    for (int i = 0; i < threadCount; ++i) {
+        workers.append(QThread::create([&]() {
+            QByteArray block;
+            while (blocks.pop(block) == BoundedQueue<QByteArray>::POPPED) {
+                batches.push(splitAndScore(block, language, candidates));
+            }
+            if (--activeWorkers == 0) {
+                batches.close();
+            }
+        }));
+    }
+
+    reader->start();
+    for (QThread *worker : workers) {
+        worker->start();
+    }
+
+    QTextStream err(stderr);
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+    auto reportProgress = [&]() {
+        const double seconds = qMax(0.001, timer.elapsed() / 1000.0);
+        const double megabytes = bytesRead / 1e6;
+        const double percent = totalBytes > 0 ? 100.0 * bytesRead / totalBytes : 100.0;
+        const double rate = megabytes / seconds;
+        const double etaSeconds = rate > 0 ? (totalBytes / 1e6 - megabytes) / rate : 0.0;
+        err << "\r" << QString::number(percent, 'f', 1) << "%  "
+            << QString::number(megabytes, 'f', 0) << " MB  "
+            << QString::number(rate, 'f', 1) << " MB/s  "
+            << candidates.load() << " sentences, " << duplicates << " duplicates  ETA "
+            << QString::number(etaSeconds, 'f', 0) << " s   ";
+        err.flush();
+    };
+
+    bool writeFailed = false;
+    SentenceBatch batch;
+    for (;;) {
+        const BoundedQueue<SentenceBatch>::PopResult result = batches.pop(batch, PROGRESS_INTERVAL_MS);
+        if (result == BoundedQueue<SentenceBatch>::CLOSED) {
+            break;
+        }
+        if (result == BoundedQueue<SentenceBatch>::POPPED && !writeFailed) {
+            for (const ScoredSentence &sentence : batch) {
+                if (!seen.insert(sentence.hash)) {
+                    ++duplicates;
+                } else if (!writer.addSentence(sentence.difficulty, sentence.text, sentence.score)) {
+                    writeFailed = true; // Keep draining so the workers can finish
+                    break;
+                } else if (model) {
+                    model->addSentence(sentence.text);
+                }
+            }
+        }
+        if (!dumps.isEmpty() && progressTimer.elapsed() >= PROGRESS_INTERVAL_MS) {
+            reportProgress();
+            progressTimer.restart();
+        }
+    }
+
+    reader->wait();
+    delete reader;
+    for (QThread *worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+
+    if (!dumps.isEmpty()) {
+        reportProgress();
+        err << "\n";
+    }
+    if (readFailed || writeFailed || !writer.finish()) {
+        return 1;
+    }
+    if (model && !model->write(parser.value(modelOption))) {
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << "Wrote " << parser.value(outputOption) << " in " << timer.elapsed() << " ms ("
+        << threadCount << " worker threads)\n";
+    out << "  easy:       " << writer.getSentenceCount(0) << " sentences\n";
+    out << "  medium:     " << writer.getSentenceCount(1) << " sentences\n";
+    out << "  hard:       " << writer.getSentenceCount(2) << " sentences\n";
+    out << "  duplicates: " << duplicates << " skipped\n";
+    if (model) {
+        reportModelSpeed(parser.value(modelOption), out);
+    }
+    return 0;
+}
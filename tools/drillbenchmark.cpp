@@ -0,0 +1,86 @@
+/**
+ * Typing Speed Test - Drill Generation Benchmark
+ *
+ * Drills per second for every lesson type, generated one at a time through
+ * getProgressiveLesson() and in bulk through generateDrillBatch(), then for a
+ * whole workbook with generateWorkbook() running the lesson types in
+ * parallel.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include "../src/managers/lessonmanager.h"
+
+static QString formatRate(qint64 drills, qint64 nsecs)
+{
+    const double rate = nsecs > 0 ? drills * 1e9 / nsecs : 0.0;
+    return QString::number(rate, 'f', 0).rightJustified(14);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks single and bulk lesson drill generation.");
+    parser.addHelpOption();
+    QCommandLineOption drillsOption("drills", "Drills to generate per lesson type.", "count", "20000");
+    QCommandLineOption levelOption("level", "Lesson level, 1 to 5.", "level", "3");
+    QCommandLineOption seedOption("seed", "Generator seed.", "seed", "1");
+    parser.addOptions({drillsOption, levelOption, seedOption});
+    parser.process(app);
+
+    const int drills = qMax(1, parser.value(drillsOption).toInt());
+    const int level = qBound(1, parser.value(levelOption).toInt(), 5);
+    const quint64 seed = parser.value(seedOption).toULongLong();
+
+    LessonManager lessons;
+    lessons.setSeed(seed);
+    const QList<LessonManager::LessonType> types = lessons.getAllLessonTypes();
+
+    QTextStream out(stdout);
+    out << "Lesson                                 single/s       batch/s\n";
+
+    QElapsedTimer timer;
+    qint64 characters = 0; // Keeps the single-drill loop from being optimized away
+    for (LessonManager::LessonType type : types) {
+        timer.start();
+        for (int i = 0; i < drills; ++i) {
+            characters += lessons.getProgressiveLesson(type, level).size();
+        }
+        const qint64 singleNsecs = timer.nsecsElapsed();
+
+        timer.restart();
+        const DrillBatch batch = LessonManager::generateDrillBatch(type, level, drills, seed);
+        const qint64 batchNsecs = timer.nsecsElapsed();
+        characters += batch.text.size();
+
+        out << lessons.getLessonTitle(type).leftJustified(32) << formatRate(drills, singleNsecs)
+            << formatRate(batch.size(), batchNsecs) << "\n";
+        out.flush();
+    }
+
+    timer.restart();
+    const QVector<DrillBatch> workbook = LessonManager::generateWorkbook(types, level, drills, seed);
+    const qint64 workbookNsecs = timer.nsecsElapsed();
+    qint64 workbookDrills = 0;
+    for (const DrillBatch &batch : workbook) {
+        workbookDrills += batch.size();
+        characters += batch.text.size();
+    }
+
+    const bool reproducible = LessonManager::generateDrillBatch(types.first(), level, 100, seed).text
+                           == LessonManager::generateDrillBatch(types.first(), level, 100, seed).text;
+
+    out << "\nWorkbook, " << types.size() << " lesson types on up to " << QThread::idealThreadCount()
+        << " threads: " << formatRate(workbookDrills, workbookNsecs).trimmed() << " drills/s\n";
+    out << "Same seed, same batch: " << (reproducible ? "yes" : "NO") << "\n";
+    out << "Characters generated: " << characters << "\n";
+    return reproducible ? 0 : 1;
+}
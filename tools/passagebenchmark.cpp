@@ -0,0 +1,209 @@
+/**
+ * Typing Speed Test - Passage Model Benchmark
+ *
+ * Cost of grapheme segmentation and per-keystroke scoring with PassageModel
+ * and CorrectnessMap for Latin, accented Latin (combining marks), CJK and
+ * emoji-heavy passages, next to the old scoring that compared every typed
+ * code unit again after each keystroke, and the latency of one keystroke
+ * as the passage grows from a sentence to a megabyte.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include "../src/core/correctnessmap.h"
+#include "../src/core/passagemodel.h"
+#include "../src/core/sessionrandom.h"
+
+struct Sample {
+    const char *name;
+    QStringList words;
+    QString separator;
+};
+
+// Mirrors TypingTest: the input field keeps this much behind the cursor and lets go in steps
+static const int INPUT_KEPT_BEHIND = 120;
+static const int INPUT_RETIRE_CHUNK = 200;
+
+struct TypingRun {
+    qint64 matches;   // Correct clusters summed over every keystroke
+    qint64 totalNs;
+    qint64 worstNs;   // Slowest single keystroke
+};
+
+// Types the passage one cluster at a time the way TypingTest scores it: the field holds only recent
+// input, the typed model replaces what follows the committed text, and the correct count is kept
+static TypingRun typePassage(const PassageModel &passage)
+{
+    TypingRun run = {0, 0, 0};
+    PassageModel typed;
+    CorrectnessMap correctness;
+    QString field;
+    int inputOffset = 0;
+    int committedClusters = 0;
+    QElapsedTimer timer;
+    for (int cluster = 0; cluster < passage.getClusterCount(); ++cluster) {
+        const QString &text = passage.getText();
+        timer.start();
+        field.append(text.constData() + passage.getClusterStart(cluster), passage.getClusterLength(cluster));
+        correctness.truncate(typed.replaceFrom(inputOffset, field));
+        for (int i = correctness.getTypedCount(); i < typed.getClusterCount(); ++i) {
+            correctness.setCorrect(i, PassageModel::clusterEquals(typed, i, passage, i));
+        }
+        run.matches += correctness.countCorrect();
+
+        const int behind = typed.getClusterCount() - INPUT_KEPT_BEHIND;
+        if (behind - committedClusters >= INPUT_RETIRE_CHUNK) {
+            const int committed = typed.getClusterStart(behind) - inputOffset;
+            field.remove(0, committed);
+            inputOffset += committed;
+            committedClusters = behind;
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+        run.totalNs += elapsed;
+        run.worstNs = qMax(run.worstNs, elapsed);
+    }
+    return run;
+}
+
+// Words drawn at random until the passage holds at least length code units
+static QString buildPassage(const Sample &sample, int length, SessionRandom &random)
+{
+    QString passage;
+    while (passage.length() < length) {
+        if (!passage.isEmpty()) {
+            passage += sample.separator;
+        }
+        passage += sample.words[random.bounded(sample.words.size())];
+    }
+    return passage;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks grapheme-aware passage segmentation and scoring.");
+    parser.addHelpOption();
+    QCommandLineOption lengthOption("length", "Passage length in UTF-16 code units.", "units", "2000");
+    QCommandLineOption roundsOption("rounds", "Times each passage is segmented and typed.", "count", "20");
+    QCommandLineOption maxLengthOption("max-length", "Longest passage in the latency table, in code units.",
+                                       "units", "1000000");
+    parser.addOptions({lengthOption, roundsOption, maxLengthOption});
+    parser.process(app);
+
+    const int length = qMax(10, parser.value(lengthOption).toInt());
+    const int rounds = qMax(1, parser.value(roundsOption).toInt());
+    const int maxLength = qMax(length, parser.value(maxLengthOption).toInt());
+
+    const QString acute = QString(QChar(0x0301));
+    const QString grave = QString(QChar(0x0300));
+    const QString zwj = QString(QChar(0x200D));
+    const Sample samples[] = {
+        {"Latin (ASCII)", {"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "typing", "speed"}, " "},
+        {"Latin, combining", {"cafe" + acute, "e" + grave + "re", "re" + acute + "sume" + acute, "nai" + QString(QChar(0x0308)) + "ve",
+                              "fac" + QString(QChar(0x0327)) + "ade", "a" + grave, "tre" + QString(QChar(0x0300)) + "s"}, " "},
+        {"CJK", {QString::fromUtf8("打字"), QString::fromUtf8("速度"), QString::fromUtf8("测试"), QString::fromUtf8("日本語"),
+                 QString::fromUtf8("한국어"), QString::fromUtf8("練習"), QString::fromUtf8("𠮷野家")}, QString::fromUtf8("，")},
+        {"Emoji", {QString::fromUtf8("👍"), QString::fromUtf8("👍🏽"), QString::fromUtf8("👩") + zwj + QString::fromUtf8("💻"),
+                   QString::fromUtf8("🇫🇷"), QString::fromUtf8("🇯🇵"), QString::fromUtf8("❤️"), "ok",
+                   QString::fromUtf8("👨") + zwj + QString::fromUtf8("👩") + zwj + QString::fromUtf8("👧")}, " "}
+    };
+
+    QTextStream out(stdout);
+    out << "Passage             units  clusters  segment us  keystroke ns  code unit ns\n";
+
+    SessionRandom random(1);
+    bool consistent = true;
+    for (const Sample &sample : samples) {
+        const QString text = buildPassage(sample, length, random);
+        QElapsedTimer timer;
+
+        timer.start();
+        int clusters = 0;
+        for (int round = 0; round < rounds; ++round) {
+            PassageModel model;
+            model.setText(text); // A fresh model every round; setting the same text again is free
+            clusters = model.getClusterCount();
+        }
+        const double segmentUs = timer.nsecsElapsed() / 1e3 / rounds;
+
+        // Typing the passage one cluster at a time, scoring after every keystroke as TypingTest does
+        const PassageModel passage(text);
+        qint64 matches = 0;
+        qint64 typingNs = 0;
+        for (int round = 0; round < rounds; ++round) {
+            const TypingRun run = typePassage(passage);
+            matches += run.matches;
+            typingNs += run.totalNs;
+        }
+        const double keystrokeNs = static_cast<double>(typingNs) / rounds / qMax(1, clusters);
+
+        // The comparison this replaced: one QChar per character
+        qint64 unitMatches = 0;
+        timer.restart();
+        for (int round = 0; round < rounds; ++round) {
+            for (int typedLength = 1; typedLength <= text.length(); ++typedLength) {
+                const QString typedText = text.left(typedLength);
+                for (int i = 0; i < typedLength; ++i) {
+                    unitMatches += typedText[i] == text[i];
+                }
+            }
+        }
+        const double unitNs = static_cast<double>(timer.nsecsElapsed()) / rounds / text.length();
+
+        // Typing the passage itself must score every cluster correct
+        const qint64 expected = static_cast<qint64>(rounds) * clusters * (clusters + 1) / 2;
+        consistent = consistent && matches == expected;
+
+        out << QString(sample.name).leftJustified(18) << QString::number(text.length()).rightJustified(7)
+            << QString::number(clusters).rightJustified(10)
+            << QString::number(segmentUs, 'f', 1).rightJustified(12)
+            << QString::number(keystrokeNs, 'f', 0).rightJustified(14)
+            << QString::number(unitNs, 'f', 0).rightJustified(14) << "\n";
+        out.flush();
+        Q_UNUSED(unitMatches);
+    }
+
+    // One keystroke should cost the same at any passage length; the whole-input column is the model
+    // rescanning all typed text from the start, sampled over the last keystrokes of the passage
+    out << "\nPassage             units  keystroke ns  worst ns  whole input ns\n";
+    for (int sampleIndex = 0; sampleIndex < 2; ++sampleIndex) {
+        const Sample &sample = samples[sampleIndex];
+        for (int passageLength = 250; ; passageLength = qMin(passageLength * 40, maxLength)) {
+            const PassageModel passage(buildPassage(sample, passageLength, random));
+            const int clusters = passage.getClusterCount();
+            const TypingRun run = typePassage(passage);
+            consistent = consistent && run.matches == static_cast<qint64>(clusters) * (clusters + 1) / 2;
+
+            const int sampled = qMin(clusters, 200);
+            PassageModel typed;
+            typed.setText(passage.getText().left(passage.getClusterStart(clusters - sampled)));
+            QElapsedTimer timer;
+            timer.start();
+            for (int cluster = clusters - sampled + 1; cluster <= clusters; ++cluster) {
+                typed.setText(passage.getText().left(passage.getClusterStart(cluster)));
+            }
+            const double wholeNs = static_cast<double>(timer.nsecsElapsed()) / qMax(1, sampled);
+
+            out << QString(sample.name).leftJustified(18)
+                << QString::number(passage.getText().length()).rightJustified(7)
+                << QString::number(static_cast<double>(run.totalNs) / qMax(1, clusters), 'f', 0).rightJustified(14)
+                << QString::number(run.worstNs).rightJustified(10)
+                << QString::number(wholeNs, 'f', 0).rightJustified(16) << "\n";
+            out.flush();
+            if (passageLength >= maxLength) {
+                break;
+            }
+        }
+    }
+
+    out << "\nTyped passages score fully correct: " << (consistent ? "yes" : "NO") << "\n";
+    return consistent ? 0 : 1;
+}
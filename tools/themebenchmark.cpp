@@ -0,0 +1,137 @@
+/**
+ * Typing Speed Test - Theme Backend Benchmark
+ *
+ * Compares the style sheet and palette theming backends on a widget tree
+ * shaped like the main window: time to switch themes (apply, re-polish and
+ * first paint) and steady-state paint cost per frame.
+ *
+ * Runs on the offscreen platform unless QT_QPA_PLATFORM is already set.
+ *
+ * @author Tolstoy Justin
+ * @license MIT License
+ */
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QSlider>
+#include <QProgressBar>
+#include <QMainWindow>
+#include <QPixmap>
+#include "../src/managers/thememanager.h"
+
+static QMainWindow *createWindow()
+{
+    // Roughly the same widget population as MainWindow::setupUI()
+    QMainWindow *window = new QMainWindow();
+    QWidget *central = new QWidget(window);
+    window->setCentralWidget(central);
+    QVBoxLayout *layout = new QVBoxLayout(central);
+
+    layout->addWidget(new QLabel("Typing Speed Test", central));
+    layout->addWidget(new QLabel("The quick brown fox jumps over the lazy dog.", central));
+    layout->addWidget(new QLineEdit(central));
+    QProgressBar *progress = new QProgressBar(central);
+    progress->setValue(40);
+    layout->addWidget(progress);
+
+    for (int row = 0; row < 6; ++row) {
+        QHBoxLayout *rowLayout = new QHBoxLayout();
+        for (int column = 0; column < 3; ++column) {
+            rowLayout->addWidget(new QLabel(QString("Setting %1:").arg(column), central));
+            QComboBox *combo = new QComboBox(central);
+            combo->addItems({"Easy", "Medium", "Hard"});
+            rowLayout->addWidget(combo);
+        }
+        rowLayout->addWidget(new QCheckBox("Option", central));
+        rowLayout->addWidget(new QSlider(Qt::Horizontal, central));
+        layout->addLayout(rowLayout);
+    }
+
+    QHBoxLayout *buttons = new QHBoxLayout();
+    buttons->addWidget(new QPushButton("Start Test", central));
+    buttons->addWidget(new QPushButton("Reset", central));
+    layout->addLayout(buttons);
+
+    window->resize(800, 600);
+    return window;
+}
+
+static void runBackend(ThemeManager &themeManager, ThemeManager::StyleBackend backend,
+                       const QString &name, int switches, int frames, QTextStream &out)
+{
+    QMainWindow *window = createWindow();
+    themeManager.setStyleBackend(backend);
+    themeManager.applyToWidget(window);
+    window->show();
+    QApplication::processEvents();
+    window->grab(); // Warm up polish and glyph caches
+
+    const ThemeManager::ThemeType themes[] = {
+        ThemeManager::DARK_THEME, ThemeManager::HIGH_CONTRAST_THEME, ThemeManager::LIGHT_THEME
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < switches; ++i) {
+        themeManager.applyTheme(themes[i % 3]);
+        themeManager.applyToWidget(window);
+        QApplication::processEvents();
+        window->grab();
+    }
+    const double switchMs = timer.nsecsElapsed() / 1e6 / switches;
+
+    timer.restart();
+    for (int i = 0; i < frames; ++i) {
+        window->grab();
+    }
+    const double frameMs = timer.nsecsElapsed() / 1e6 / frames;
+
+    out << name.leftJustified(12) << QString::number(switchMs, 'f', 3).rightJustified(14)
+        << QString::number(frameMs, 'f', 3).rightJustified(14) << "\n";
+    out.flush();
+
+    delete window;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks theme switching and painting for both theming backends.");
+    parser.addHelpOption();
+    QCommandLineOption switchesOption("switches", "Theme switches to time.", "count", "60");
+    QCommandLineOption framesOption("frames", "Frames to paint per backend.", "count", "200");
+    parser.addOptions({switchesOption, framesOption});
+    parser.process(app);
+
+    const int switches = qMax(1, parser.value(switchesOption).toInt());
+    const int frames = qMax(1, parser.value(framesOption).toInt());
+
+    ThemeManager themeManager;
+    const ThemeManager::ThemeType savedTheme = themeManager.getCurrentTheme();
+    const ThemeManager::StyleBackend savedBackend = themeManager.getStyleBackend();
+
+    QTextStream out(stdout);
+    out << "Backend         switch (ms)    frame (ms)\n";
+    runBackend(themeManager, ThemeManager::STYLESHEET_BACKEND, "stylesheet", switches, frames, out);
+    runBackend(themeManager, ThemeManager::PALETTE_BACKEND, "palette", switches, frames, out);
+
+    // ThemeManager persists its state on destruction; leave the user's settings as they were
+    themeManager.applyTheme(savedTheme);
+    themeManager.setStyleBackend(savedBackend);
+    return 0;
+}